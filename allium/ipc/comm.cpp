@@ -94,4 +94,10 @@ namespace allium {
     return result;
   }
 
+  void Comm::wait_all(std::vector<MPI_Request>& requests)
+  {
+    MPI_Waitall(requests.size(), requests.data(), MPI_STATUSES_IGNORE);
+    requests.clear();
+  }
+
 }
@@ -16,10 +16,34 @@
 #define ALLIUM_IPC_COMM_HPP
 
 #include <mpi.h>
+#include <complex>
 #include <vector>
 #include <allium/mesh/range.hpp>
 
 namespace allium {
+
+  /// @cond INTERNAL
+  namespace detail {
+    /** The MPI data type corresponding to a C++ type. */
+    template <typename T> struct MpiType;
+
+    #define ALLIUM_MPI_TYPE(T, MPI_T) \
+      template <> struct MpiType<T> { \
+        static MPI_Datatype get() { return MPI_T; } \
+      };
+    ALLIUM_MPI_TYPE(int, MPI_INT)
+    ALLIUM_MPI_TYPE(long, MPI_LONG)
+    ALLIUM_MPI_TYPE(long long, MPI_LONG_LONG)
+    ALLIUM_MPI_TYPE(unsigned, MPI_UNSIGNED)
+    ALLIUM_MPI_TYPE(unsigned long, MPI_UNSIGNED_LONG)
+    ALLIUM_MPI_TYPE(unsigned long long, MPI_UNSIGNED_LONG_LONG)
+    ALLIUM_MPI_TYPE(float, MPI_FLOAT)
+    ALLIUM_MPI_TYPE(double, MPI_DOUBLE)
+    ALLIUM_MPI_TYPE(std::complex<float>, MPI_C_FLOAT_COMPLEX)
+    ALLIUM_MPI_TYPE(std::complex<double>, MPI_C_DOUBLE_COMPLEX)
+    #undef ALLIUM_MPI_TYPE
+  }
+  /// @endcond
   /** The communicator class.
    @brief Wraps an MPI communicator to make MPI easier to use.
   */
@@ -65,6 +89,69 @@ namespace allium {
 
       std::vector<long long> sum_exscan(std::vector<long long> buf);
 
+      /** @brief Sums the given values element-wise over all ranks. */
+      template <typename T>
+      void sum_allreduce(T* data, int elements) {
+        MPI_Allreduce(MPI_IN_PLACE, data, elements,
+                      detail::MpiType<T>::get(), MPI_SUM, m_handle);
+      }
+
+      template <typename T>
+      T sum_allreduce(T value) {
+        sum_allreduce(&value, 1);
+        return value;
+      }
+
+      /** @brief Collects one value from every rank, ordered by rank. */
+      template <typename T>
+      std::vector<T> allgather(T value) {
+        std::vector<T> result(size());
+        MPI_Allgather(&value, 1, detail::MpiType<T>::get(),
+                      result.data(), 1, detail::MpiType<T>::get(),
+                      m_handle);
+        return result;
+      }
+
+      /**
+       @brief Sends `values[i]` to rank i and returns the values received
+       from all ranks, ordered by rank.
+       */
+      template <typename T>
+      std::vector<T> alltoall(const std::vector<T>& values) {
+        std::vector<T> result(size());
+        MPI_Alltoall(values.data(), 1, detail::MpiType<T>::get(),
+                     result.data(), 1, detail::MpiType<T>::get(),
+                     m_handle);
+        return result;
+      }
+
+      /**
+       @brief Starts a non-blocking send. The data must not be modified until
+       the returned request has completed.
+       */
+      template <typename T>
+      MPI_Request isend(const T* data, int elements, int dest, int tag) {
+        MPI_Request request;
+        MPI_Isend(const_cast<T*>(data), elements, detail::MpiType<T>::get(),
+                  dest, tag, m_handle, &request);
+        return request;
+      }
+
+      /**
+       @brief Starts a non-blocking receive. The data must not be accessed
+       until the returned request has completed.
+       */
+      template <typename T>
+      MPI_Request irecv(T* data, int elements, int src, int tag) {
+        MPI_Request request;
+        MPI_Irecv(data, elements, detail::MpiType<T>::get(),
+                  src, tag, m_handle, &request);
+        return request;
+      }
+
+      /** @brief Waits until all given requests have completed. */
+      static void wait_all(std::vector<MPI_Request>& requests);
+
       MPI_Comm handle() { return m_handle; }
     private:
       MPI_Comm m_handle;
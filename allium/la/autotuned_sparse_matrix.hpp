@@ -0,0 +1,131 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_AUTOTUNED_SPARSE_MATRIX_HPP
+#define ALLIUM_LA_AUTOTUNED_SPARSE_MATRIX_HPP
+
+#include "sparse_matrix.hpp"
+#include "eigen_vector.hpp"
+#include <allium/util/extern.hpp>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace allium {
+
+  /** @brief The measured run time of a format in the autotuner. */
+  struct AutotuneCandidate {
+    std::string format;
+    int threads;
+    /** Seconds per matrix-vector product. */
+    double time;
+  };
+
+  /**
+   @brief A sparse matrix, which selects the fastest storage format for the
+   matrix-vector product at run time.
+
+   When the entries are set, the matrix is stored in each of the candidate
+   formats (`eigen`, `eigen_row_major`, `csr`, `compact_csr` and `sell`)
+   and the product is timed for several thread counts. The thread count is
+   a setting of the CSR, compact CSR and SELL storages; the Eigen formats
+   are timed once and use max_threads(). The fastest combination is kept,
+   the other copies are freed. Hence, set_entries() is considerably more
+   expensive than for the other formats, and this matrix pays off when many
+   products are computed with the same sparsity pattern.
+
+   If a cache file is given, the decision is stored there, keyed by the
+   matrix size, the sparsity pattern and the maximal thread count. Later
+   runs, which set the same pattern, reuse the decision without timing the
+   candidates again.
+
+   Like EigenVectorStorage, this matrix cannot be distributed.
+   */
+  template <typename N>
+  class AutotunedSparseMatrixStorage final
+      : public SparseMatrixStorage<EigenVectorStorage<N>>
+  {
+    public:
+      using Vector = EigenVectorStorage<N>;
+      using DefaultVector = EigenVectorStorage<N>;
+      using typename SparseMatrixStorage<Vector>::Number;
+      using typename SparseMatrixStorage<Vector>::Real;
+      using SparseMatrixStorage<Vector>::row_spec;
+      using SparseMatrixStorage<Vector>::col_spec;
+
+      AutotunedSparseMatrixStorage(VectorSpec rows,
+                                   VectorSpec cols,
+                                   std::string cache_file = "");
+
+      void set_entries(LocalCooMatrix<N> lmat) override;
+
+      /**
+       Returns the entries row by row, sorted by column, regardless of the
+       selected format. This is the order of the values in set_values().
+       */
+      LocalCooMatrix<N> get_entries() override;
+      void set_values(const std::vector<N>& values) override;
+
+      /**
+       Computes the product with the selected format and thread count. The
+       global thread count, max_threads(), is not changed.
+       */
+      void apply(Vector& result, const Vector& arg) override;
+
+      /** Uses the selected format and thread count, like apply(). */
+      void apply_block(MultiVector<N, Eigen::RowMajor>& result,
+                       const MultiVector<N, Eigen::RowMajor>& arg) override;
+
+      /** The name of the selected format. */
+      const std::string& format() const { return m_format; }
+
+      /**
+       The number of threads used by apply(). For the Eigen formats, this
+       is max_threads() at the time of tuning.
+       */
+      int threads() const { return m_threads; }
+
+      /**
+       The timings of the last tuning. Empty, if the decision was taken
+       from the cache file.
+       */
+      const std::vector<AutotuneCandidate>& candidates() const {
+        return m_candidates;
+      }
+
+      /** The names of the candidate formats. */
+      static std::vector<std::string> formats();
+
+    private:
+      using Storage = SparseMatrixStorage<Vector>;
+
+      std::string m_cache_file;
+      std::unique_ptr<Storage> m_mat;
+      std::string m_format;
+      int m_threads;
+      std::vector<AutotuneCandidate> m_candidates;
+      /// The position of every entry of get_entries() in the selected format.
+      std::vector<size_t> m_value_pos;
+
+      std::unique_ptr<Storage> create(const std::string& format);
+      void tune(const LocalCooMatrix<N>& lmat);
+      void update_value_pos();
+  };
+
+  #define ALLIUM_AUTOTUNED_SPARSE_MATRIX_DECL(extern, N) \
+    extern template class AutotunedSparseMatrixStorage<N>;
+  ALLIUM_EXTERN_N(ALLIUM_AUTOTUNED_SPARSE_MATRIX_DECL)
+}
+
+#endif
@@ -0,0 +1,341 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_AUTOTUNED_SPARSE_MATRIX_IMPL_HPP
+#define ALLIUM_LA_AUTOTUNED_SPARSE_MATRIX_IMPL_HPP
+
+#include "autotuned_sparse_matrix.hpp"
+
+#include "compact_csr_sparse_matrix.hpp"
+#include "csr_sparse_matrix.hpp"
+#include "eigen_sparse_matrix.hpp"
+#include "sell_sparse_matrix.hpp"
+#include <allium/util/parallel.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <numeric>
+#include <sstream>
+
+namespace allium {
+
+  /// @cond INTERNAL
+  namespace detail {
+    /**
+     Sets the thread count of the formats with a per-matrix thread setting.
+     Returns false for the other formats, which use max_threads().
+     */
+    template <typename N>
+    bool set_storage_threads(SparseMatrixStorage<EigenVectorStorage<N>>& mat,
+                             int threads)
+    {
+      if (auto csr = dynamic_cast<CsrSparseMatrixStorage<N>*>(&mat)) {
+        csr->threads(threads);
+      } else if (auto compact = dynamic_cast<CompactCsrSparseMatrixStorage<N>*>(&mat)) {
+        compact->threads(threads);
+      } else if (auto sell = dynamic_cast<SellSparseMatrixStorage<N>*>(&mat)) {
+        sell->threads(threads);
+      } else {
+        return false;
+      }
+      return true;
+    }
+
+    inline uint64_t mix(uint64_t x) {
+      // the finalizer of SplitMix64
+      x ^= x >> 30;
+      x *= 0xbf58476d1ce4e5b9ull;
+      x ^= x >> 27;
+      x *= 0x94d049bb133111ebull;
+      x ^= x >> 31;
+      return x;
+    }
+
+    /**
+     Identifies a sparsity pattern on this machine. The hash does not depend
+     on the order of the entries.
+     */
+    template <typename N>
+    std::string autotune_key(const LocalCooMatrix<N>& lmat,
+                             global_size_t rows,
+                             global_size_t cols)
+    {
+      uint64_t pattern = 0;
+      for (size_t i = 0; i < lmat.entry_count(); ++i) {
+        pattern += mix(mix(lmat.row_ind()[i]) ^ lmat.col_ind()[i]);
+      }
+
+      std::stringstream key;
+      key << "n" << sizeof(N)
+          << "-" << rows << "x" << cols
+          << "-" << lmat.entry_count()
+          << "-t" << max_threads()
+          << "-" << std::hex << pattern;
+      return key.str();
+    }
+
+    inline bool read_autotune_cache(const std::string& filename,
+                             const std::string& key,
+                             std::string& format,
+                             int& threads)
+    {
+      std::ifstream is(filename);
+      bool found = false;
+
+      // later entries override earlier ones
+      std::string line;
+      while (std::getline(is, line)) {
+        std::istringstream fields(line);
+        std::string line_key, line_format;
+        int line_threads;
+        if (fields >> line_key >> line_format >> line_threads
+            && line_key == key && line_threads >= 1) {
+          format = line_format;
+          threads = line_threads;
+          found = true;
+        }
+      }
+      return found;
+    }
+
+    inline void write_autotune_cache(const std::string& filename,
+                              const std::string& key,
+                              const std::string& format,
+                              int threads)
+    {
+      std::ofstream os(filename, std::ios::app);
+      os << key << " " << format << " " << threads << std::endl;
+      if (!os) {
+        throw std::runtime_error("Could not write the autotuning cache "
+                                 + filename + ".");
+      }
+    }
+
+    /** The time per call, the best of several repetitions. */
+    template <typename M, typename V>
+    double time_apply(M& mat, V& result, const V& arg)
+    {
+      using clock = std::chrono::steady_clock;
+      const double min_time = 1e-3;
+      const int repetitions = 3;
+
+      // warm-up, which also initializes the thread partitioning
+      mat.apply(result, arg);
+
+      // short products are repeated, such that the timer resolution does
+      // not matter
+      size_t calls = 1;
+      double best = std::numeric_limits<double>::infinity();
+      for (int i_rep = 0; i_rep < repetitions; ++i_rep) {
+        double elapsed;
+        while (true) {
+          auto start = clock::now();
+          for (size_t i_call = 0; i_call < calls; ++i_call) {
+            mat.apply(result, arg);
+          }
+          elapsed = std::chrono::duration<double>(clock::now() - start).count();
+          if (elapsed >= min_time || calls >= (1u << 20))
+            break;
+          calls *= 2;
+        }
+        best = std::min(best, elapsed / calls);
+      }
+      return best;
+    }
+  }
+  /// @endcond
+
+  template <typename N>
+  AutotunedSparseMatrixStorage<N>::AutotunedSparseMatrixStorage(
+    VectorSpec rows, VectorSpec cols, std::string cache_file)
+    : SparseMatrixStorage<Vector>(rows, cols),
+      m_cache_file(cache_file),
+      m_format("csr"),
+      m_threads(max_threads())
+  {
+    if (rows.comm().size() != 1) {
+      throw std::logic_error("Objects of type AutotunedSparseMatrixStorage cannot be distributed.");
+    }
+    m_mat = create(m_format);
+  }
+
+  template <typename N>
+  std::vector<std::string> AutotunedSparseMatrixStorage<N>::formats()
+  {
+    return { "eigen", "eigen_row_major", "csr", "compact_csr", "sell" };
+  }
+
+  template <typename N>
+  auto AutotunedSparseMatrixStorage<N>::create(const std::string& format)
+    -> std::unique_ptr<Storage>
+  {
+    auto rows = row_spec();
+    auto cols = col_spec();
+
+    if (format == "eigen")
+      return std::make_unique<EigenSparseMatrixStorage<N>>(rows, cols);
+    else if (format == "eigen_row_major")
+      return std::make_unique<EigenSparseMatrixStorage<N, Eigen::RowMajor>>(rows, cols);
+    else if (format == "csr")
+      return std::make_unique<CsrSparseMatrixStorage<N>>(rows, cols);
+    else if (format == "compact_csr")
+      return std::make_unique<CompactCsrSparseMatrixStorage<N>>(rows, cols);
+    else if (format == "sell")
+      return std::make_unique<SellSparseMatrixStorage<N>>(rows, cols);
+    else
+      return nullptr;
+  }
+
+  template <typename N>
+  void AutotunedSparseMatrixStorage<N>::set_entries(LocalCooMatrix<N> lmat)
+  {
+    std::string key;
+    if (!m_cache_file.empty()) {
+      key = detail::autotune_key(lmat, row_spec().global_size(), col_spec().global_size());
+
+      std::string format;
+      int threads;
+      if (detail::read_autotune_cache(m_cache_file, key, format, threads)) {
+        auto mat = create(format);
+        if (mat) {
+          mat->set_entries(std::move(lmat));
+          detail::set_storage_threads(*mat, threads);
+          m_mat = std::move(mat);
+          update_value_pos();
+          m_format = format;
+          m_threads = threads;
+          m_candidates.clear();
+          return;
+        }
+      }
+    }
+
+    tune(lmat);
+    update_value_pos();
+
+    if (!m_cache_file.empty()) {
+      detail::write_autotune_cache(m_cache_file, key, m_format, m_threads);
+    }
+  }
+
+  template <typename N>
+  void AutotunedSparseMatrixStorage<N>::tune(const LocalCooMatrix<N>& lmat)
+  {
+    // halve the thread count, down to a single thread
+    std::vector<int> thread_counts;
+    for (int threads = max_threads(); threads >= 1; threads /= 2) {
+      thread_counts.push_back(threads);
+    }
+
+    Vector x(col_spec());
+    Vector y(row_spec());
+    {
+      auto lx = local_slice(x);
+      for (size_t i = 0; i < lx.size(); ++i) {
+        lx[i] = Number(1) + Number(i % 7);
+      }
+    }
+
+    m_candidates.clear();
+    double best_time = std::numeric_limits<double>::infinity();
+    const Storage* best = nullptr;
+    for (const auto& format : formats()) {
+      auto mat = create(format);
+      mat->set_entries(lmat);
+
+      for (int threads : thread_counts) {
+        // formats without a thread setting are timed once with max_threads()
+        if (!detail::set_storage_threads(*mat, threads)
+            && threads != thread_counts.front())
+          break;
+
+        double time = detail::time_apply(*mat, y, x);
+        m_candidates.push_back(AutotuneCandidate{format, threads, time});
+
+        if (time < best_time) {
+          best_time = time;
+          m_format = format;
+          m_threads = threads;
+          best = mat.get();
+        }
+      }
+
+      // only the selected format is kept
+      if (best == mat.get()) {
+        detail::set_storage_threads(*mat, m_threads);
+        m_mat = std::move(mat);
+      }
+    }
+  }
+
+  template <typename N>
+  void AutotunedSparseMatrixStorage<N>::update_value_pos()
+  {
+    auto stored = m_mat->get_entries();
+    const auto& rows = stored.row_ind();
+    const auto& cols = stored.col_ind();
+
+    m_value_pos.resize(stored.entry_count());
+    std::iota(m_value_pos.begin(), m_value_pos.end(), 0);
+    std::sort(m_value_pos.begin(), m_value_pos.end(),
+              [&](size_t a, size_t b) {
+                return rows[a] < rows[b] || (rows[a] == rows[b] && cols[a] < cols[b]);
+              });
+  }
+
+  template <typename N>
+  LocalCooMatrix<N> AutotunedSparseMatrixStorage<N>::get_entries()
+  {
+    auto stored = m_mat->get_entries();
+
+    LocalCooMatrix<N> lmat;
+    lmat.reserve(m_value_pos.size());
+    for (size_t pos : m_value_pos) {
+      lmat.add(stored.row_ind()[pos], stored.col_ind()[pos], stored.values()[pos]);
+    }
+    return lmat;
+  }
+
+  template <typename N>
+  void AutotunedSparseMatrixStorage<N>::set_values(const std::vector<N>& values)
+  {
+    if (values.size() != m_value_pos.size()) {
+      throw std::invalid_argument("The value count does not match the sparsity pattern.");
+    }
+
+    std::vector<N> stored(values.size());
+    for (size_t i = 0; i < values.size(); ++i) {
+      stored[m_value_pos[i]] = values[i];
+    }
+    m_mat->set_values(stored);
+  }
+
+  template <typename N>
+  void AutotunedSparseMatrixStorage<N>::apply(Vector& result, const Vector& arg)
+  {
+    m_mat->apply(result, arg);
+  }
+
+  template <typename N>
+  void AutotunedSparseMatrixStorage<N>::apply_block(
+    MultiVector<N, Eigen::RowMajor>& result,
+    const MultiVector<N, Eigen::RowMajor>& arg)
+  {
+    m_mat->apply_block(result, arg);
+  }
+}
+
+#endif
@@ -0,0 +1,155 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_BLOCK_JACOBI_HPP
+#define ALLIUM_LA_BLOCK_JACOBI_HPP
+
+#include "sparse_matrix.hpp"
+#include "linear_operator.hpp"
+#include <allium/util/memory.hpp>
+#include <Eigen/Core>
+#include <Eigen/LU>
+#include <stdexcept>
+
+namespace allium {
+
+  /**
+   @brief Block-Jacobi preconditioner.
+
+   Applies the inverse of the block diagonal part of a matrix, where the
+   blocks are of size `block_size` x `block_size`. The blocks are taken from
+   the locally owned rows and columns only. Hence, with several processes,
+   the preconditioner is additionally block-diagonal across the processes.
+
+   The diagonal blocks are extracted and inverted once, when the
+   preconditioner is created. For block sizes up to 8, fixed-size kernels
+   are used for the application.
+
+   @ingroup linear_solver
+   */
+  template <typename V>
+  class BlockJacobiPreconditioner final : public LinearOperator<V> {
+    public:
+      using typename LinearOperator<V>::Vector;
+      using typename LinearOperator<V>::Number;
+      using typename LinearOperator<V>::Real;
+
+      BlockJacobiPreconditioner(SparseMatrixStorage<V>& mat, int block_size);
+
+      void apply(Vector& result, const Vector& arg) override;
+
+      int block_size() const { return m_block_size; }
+
+    private:
+      int m_block_size;
+      size_t m_block_count;
+      /// The inverted blocks, every block is stored row by row.
+      aligned_vector<Number> m_inverses;
+
+      template <int B>
+      void apply_fixed(Number* y, const Number* x);
+  };
+
+  template <typename V>
+  BlockJacobiPreconditioner<V>::BlockJacobiPreconditioner(
+    SparseMatrixStorage<V>& mat, int block_size)
+    : m_block_size(block_size)
+  {
+    using Block = Eigen::Matrix<Number, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+
+    auto spec = mat.row_spec();
+    size_t local_size = spec.local_size();
+    global_size_t local_start = spec.local_start();
+    size_t b = block_size;
+
+    if (block_size < 1 || local_size % b != 0) {
+      throw std::logic_error("The local size must be a multiple of the block size.");
+    }
+
+    m_block_count = local_size / b;
+    m_inverses.assign(m_block_count * b * b, Number(0));
+
+    auto entries = mat.get_entries();
+    for (auto e : entries.entries()) {
+      global_size_t row = e.row() - local_start;
+      global_size_t col = e.col() - local_start;
+      if (e.col() >= local_start && col < local_size && row / b == col / b) {
+        m_inverses[(row / b) * b * b + (row % b) * b + (col % b)] += e.value();
+      }
+    }
+
+    for (size_t i_block = 0; i_block < m_block_count; ++i_block) {
+      Eigen::Map<Block> block(m_inverses.data() + i_block * b * b, b, b);
+
+      Eigen::FullPivLU<Block> lu(block);
+      if (!lu.isInvertible()) {
+        throw std::runtime_error("Singular diagonal block.");
+      }
+      block = lu.inverse();
+    }
+  }
+
+  template <typename V>
+  template <int B>
+  void BlockJacobiPreconditioner<V>::apply_fixed(Number* y, const Number* x)
+  {
+    using Block = Eigen::Matrix<Number, B, B, Eigen::RowMajor>;
+    using Segment = Eigen::Matrix<Number, B, 1>;
+
+    const Number* inverses = m_inverses.data();
+    const long block_count = m_block_count;
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (long i_block = 0; i_block < block_count; ++i_block) {
+      Eigen::Map<Segment>(y + i_block * B).noalias()
+        = Eigen::Map<const Block>(inverses + i_block * B * B)
+          * Eigen::Map<const Segment>(x + i_block * B);
+    }
+  }
+
+  template <typename V>
+  void BlockJacobiPreconditioner<V>::apply(Vector& result, const Vector& arg)
+  {
+    auto y_slice = local_slice(result);
+    auto x_slice = local_slice(arg);
+    Number* y = y_slice.data();
+    const Number* x = x_slice.data();
+
+    switch (m_block_size) {
+      case 1: apply_fixed<1>(y, x); break;
+      case 2: apply_fixed<2>(y, x); break;
+      case 3: apply_fixed<3>(y, x); break;
+      case 4: apply_fixed<4>(y, x); break;
+      case 5: apply_fixed<5>(y, x); break;
+      case 6: apply_fixed<6>(y, x); break;
+      case 7: apply_fixed<7>(y, x); break;
+      case 8: apply_fixed<8>(y, x); break;
+      default: {
+        using Block = Eigen::Matrix<Number, Eigen::Dynamic, Eigen::Dynamic, Eigen::RowMajor>;
+        using Segment = Eigen::Matrix<Number, Eigen::Dynamic, 1>;
+        size_t b = m_block_size;
+
+        for (size_t i_block = 0; i_block < m_block_count; ++i_block) {
+          Eigen::Map<Segment>(y + i_block * b, b).noalias()
+            = Eigen::Map<const Block>(m_inverses.data() + i_block * b * b, b, b)
+              * Eigen::Map<const Segment>(x + i_block * b, b);
+        }
+      }
+    }
+  }
+}
+
+#endif
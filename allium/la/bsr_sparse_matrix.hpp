@@ -0,0 +1,118 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_BSR_SPARSE_MATRIX_HPP
+#define ALLIUM_LA_BSR_SPARSE_MATRIX_HPP
+
+#include "sparse_matrix.hpp"
+#include "csr_sparse_matrix.hpp"
+#include "eigen_vector.hpp"
+#include <allium/util/extern.hpp>
+#include <allium/util/memory.hpp>
+#include <memory>
+
+namespace allium {
+
+  /**
+   @brief A sparse matrix in block compressed sparse row (BSR) format.
+
+   The matrix is divided into dense blocks of size B x B, and the non-zero
+   blocks are stored in CSR format. This suits problems with B coupled
+   degrees of freedom per grid point, e.g., a PetscMeshSpec with `ndof = B`.
+   Compared to CSR, a single column index is stored per block and the
+   matrix-vector product uses register-blocked, fixed-size block kernels.
+
+   The number of rows and columns must be multiples of B. Every entry set by
+   set_entries occupies its whole block, get_entries returns all entries of
+   the stored blocks, including zeros.
+
+   Like EigenVectorStorage, this matrix cannot be distributed.
+   */
+  template <typename N, int B>
+  class BsrSparseMatrixStorage final
+      : public SparseMatrixStorage<EigenVectorStorage<N>>
+  {
+    public:
+      static_assert(B >= 2 && B <= 8, "Unsupported block size.");
+
+      using Vector = EigenVectorStorage<N>;
+      using DefaultVector = EigenVectorStorage<N>;
+      using typename SparseMatrixStorage<Vector>::Number;
+      using typename SparseMatrixStorage<Vector>::Real;
+      using SparseMatrixStorage<Vector>::row_spec;
+      using SparseMatrixStorage<Vector>::col_spec;
+
+      static constexpr int block_size = B;
+
+      BsrSparseMatrixStorage(VectorSpec rows, VectorSpec cols);
+
+      void set_entries(LocalCooMatrix<N> lmat) override;
+      LocalCooMatrix<N> get_entries() override;
+
+      void apply(Vector& result, const Vector& arg) override;
+
+      size_t block_rows() const { return m_block_row_ptr.size() - 1; }
+
+      /** Position of the first block of each block row, plus the block
+          count. */
+      const aligned_vector<size_t>& block_row_ptr() const {
+        return m_block_row_ptr;
+      }
+      const aligned_vector<global_size_t>& block_col_ind() const {
+        return m_block_col_ind;
+      }
+      /** The entries of the blocks, every block is stored row by row. */
+      const aligned_vector<N>& values() const { return m_values; }
+
+    private:
+      aligned_vector<size_t> m_block_row_ptr;
+      aligned_vector<global_size_t> m_block_col_ind;
+      aligned_vector<N> m_values;
+  };
+
+  /**
+   @brief Creates a sparse matrix, which uses the block size as a hint for
+   its storage format.
+
+   For a block size between 2 and 8 a BsrSparseMatrixStorage is created,
+   otherwise a CsrSparseMatrixStorage.
+   */
+  template <typename N>
+  std::shared_ptr<SparseMatrixStorage<EigenVectorStorage<N>>>
+  make_block_sparse_matrix(VectorSpec rows, VectorSpec cols, int block_size)
+  {
+    switch (block_size) {
+      case 2: return std::make_shared<BsrSparseMatrixStorage<N, 2>>(rows, cols);
+      case 3: return std::make_shared<BsrSparseMatrixStorage<N, 3>>(rows, cols);
+      case 4: return std::make_shared<BsrSparseMatrixStorage<N, 4>>(rows, cols);
+      case 5: return std::make_shared<BsrSparseMatrixStorage<N, 5>>(rows, cols);
+      case 6: return std::make_shared<BsrSparseMatrixStorage<N, 6>>(rows, cols);
+      case 7: return std::make_shared<BsrSparseMatrixStorage<N, 7>>(rows, cols);
+      case 8: return std::make_shared<BsrSparseMatrixStorage<N, 8>>(rows, cols);
+      default: return std::make_shared<CsrSparseMatrixStorage<N>>(rows, cols);
+    }
+  }
+
+  #define ALLIUM_BSR_SPARSE_MATRIX_DECL(extern, N) \
+    extern template class BsrSparseMatrixStorage<N, 2>; \
+    extern template class BsrSparseMatrixStorage<N, 3>; \
+    extern template class BsrSparseMatrixStorage<N, 4>; \
+    extern template class BsrSparseMatrixStorage<N, 5>; \
+    extern template class BsrSparseMatrixStorage<N, 6>; \
+    extern template class BsrSparseMatrixStorage<N, 7>; \
+    extern template class BsrSparseMatrixStorage<N, 8>;
+  ALLIUM_EXTERN_N(ALLIUM_BSR_SPARSE_MATRIX_DECL)
+}
+
+#endif
@@ -0,0 +1,173 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_BSR_SPARSE_MATRIX_IMPL_HPP
+#define ALLIUM_LA_BSR_SPARSE_MATRIX_IMPL_HPP
+
+#include "bsr_sparse_matrix.hpp"
+#include "local_csr_matrix.hpp"
+
+#include <algorithm>
+#include <Eigen/Core>
+
+namespace allium {
+
+  template <typename N, int B>
+  BsrSparseMatrixStorage<N, B>::BsrSparseMatrixStorage(VectorSpec rows,
+                                                       VectorSpec cols)
+    : SparseMatrixStorage<Vector>(rows, cols),
+      m_block_row_ptr(rows.local_size() / B + 1, 0)
+  {
+    if (rows.comm().size() != 1) {
+      throw std::logic_error("Objects of type BsrSparseMatrixStorage cannot be distributed.");
+    }
+    if (rows.local_size() % B != 0 || cols.global_size() % B != 0) {
+      throw std::logic_error("The matrix size must be a multiple of the block size.");
+    }
+  }
+
+  template <typename N, int B>
+  void BsrSparseMatrixStorage<N, B>::set_entries(LocalCooMatrix<N> lmat)
+  {
+    size_t rows = row_spec().local_size();
+    size_t n_block_rows = rows / B;
+    size_t n_block_cols = col_spec().global_size() / B;
+
+    // sorts the entries and sums up duplicates
+    LocalCsrMatrix<N> csr(rows,
+                          col_spec().global_size(),
+                          lmat,
+                          row_spec().local_start());
+    auto& row_ptr = csr.row_ptr();
+    auto& col_ind = csr.col_ind();
+
+    // The block row, which used a block column last, and the position of the
+    // block within that block row.
+    const size_t none = static_cast<size_t>(-1);
+    std::vector<size_t> last_block_row(n_block_cols, none);
+    std::vector<size_t> block_pos(n_block_cols);
+
+    // count the distinct blocks of every block row
+    m_block_row_ptr.assign(n_block_rows + 1, 0);
+    for (size_t i_block_row = 0; i_block_row < n_block_rows; ++i_block_row) {
+      size_t block_count = 0;
+      for (size_t i_entry = row_ptr[i_block_row * B];
+           i_entry < row_ptr[(i_block_row+1) * B];
+           ++i_entry)
+      {
+        global_size_t block_col = col_ind[i_entry] / B;
+        if (last_block_row[block_col] != i_block_row) {
+          last_block_row[block_col] = i_block_row;
+          ++block_count;
+        }
+      }
+      m_block_row_ptr[i_block_row+1] = m_block_row_ptr[i_block_row] + block_count;
+    }
+
+    size_t n_blocks = m_block_row_ptr[n_block_rows];
+    m_block_col_ind.resize(n_blocks);
+    m_values.assign(n_blocks * B * B, N(0));
+
+    std::fill(last_block_row.begin(), last_block_row.end(), none);
+    for (size_t i_block_row = 0; i_block_row < n_block_rows; ++i_block_row) {
+      size_t entries_begin = row_ptr[i_block_row * B];
+      size_t entries_end = row_ptr[(i_block_row+1) * B];
+
+      // the block columns of this block row in increasing order
+      size_t i_block = m_block_row_ptr[i_block_row];
+      for (size_t i_entry = entries_begin; i_entry < entries_end; ++i_entry) {
+        global_size_t block_col = col_ind[i_entry] / B;
+        if (last_block_row[block_col] != i_block_row) {
+          last_block_row[block_col] = i_block_row;
+          m_block_col_ind[i_block++] = block_col;
+        }
+      }
+      std::sort(m_block_col_ind.begin() + m_block_row_ptr[i_block_row],
+                m_block_col_ind.begin() + m_block_row_ptr[i_block_row+1]);
+      for (i_block = m_block_row_ptr[i_block_row];
+           i_block < m_block_row_ptr[i_block_row+1];
+           ++i_block)
+      {
+        block_pos[m_block_col_ind[i_block]] = i_block;
+      }
+
+      // copy the values into the blocks
+      for (size_t i_row = i_block_row * B; i_row < (i_block_row+1) * B; ++i_row) {
+        for (size_t i_entry = row_ptr[i_row]; i_entry < row_ptr[i_row+1]; ++i_entry) {
+          global_size_t col = col_ind[i_entry];
+          m_values[block_pos[col / B] * B * B + (i_row % B) * B + (col % B)]
+            = csr.values()[i_entry];
+        }
+      }
+    }
+  }
+
+  template <typename N, int B>
+  LocalCooMatrix<N> BsrSparseMatrixStorage<N, B>::get_entries()
+  {
+    LocalCooMatrix<N> lmat;
+    global_size_t row_offset = row_spec().local_start();
+
+    for (size_t i_block_row = 0; i_block_row < block_rows(); ++i_block_row) {
+      for (int i = 0; i < B; ++i) {
+        for (size_t i_block = m_block_row_ptr[i_block_row];
+             i_block < m_block_row_ptr[i_block_row+1];
+             ++i_block)
+        {
+          for (int j = 0; j < B; ++j) {
+            lmat.add(row_offset + i_block_row * B + i,
+                     m_block_col_ind[i_block] * B + j,
+                     m_values[i_block * B * B + i * B + j]);
+          }
+        }
+      }
+    }
+
+    return lmat;
+  }
+
+  template <typename N, int B>
+  void BsrSparseMatrixStorage<N, B>::apply(Vector& result, const Vector& arg)
+  {
+    this->check_apply_sizes(result, arg);
+
+    using Block = Eigen::Matrix<N, B, B, Eigen::RowMajor>;
+    using Segment = Eigen::Matrix<N, B, 1>;
+
+    const size_t* block_row_ptr = m_block_row_ptr.data();
+    const global_size_t* block_col_ind = m_block_col_ind.data();
+    const N* values = m_values.data();
+    const N* x = arg.native().data();
+    N* y = result.native().data();
+    const long n_block_rows = block_rows();
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (long i_block_row = 0; i_block_row < n_block_rows; ++i_block_row) {
+      Segment sum = Segment::Zero();
+      for (size_t i_block = block_row_ptr[i_block_row];
+           i_block < block_row_ptr[i_block_row+1];
+           ++i_block)
+      {
+        sum.noalias()
+          += Eigen::Map<const Block>(values + i_block * B * B)
+             * Eigen::Map<const Segment>(x + block_col_ind[i_block] * B);
+      }
+      Eigen::Map<Segment>(y + i_block_row * B) = sum;
+    }
+  }
+}
+
+#endif
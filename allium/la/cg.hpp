@@ -49,10 +49,30 @@ namespace allium {
       int m_iteration_count;
 
       virtual void matvec(VectorStorage<N>& out, const VectorStorage<N>& in) = 0;
+
+      /** Computes `out = alpha A in + beta out`. */
+      virtual void matvec_add(VectorStorage<N>& out,
+                              N alpha,
+                              const VectorStorage<N>& in,
+                              N beta) = 0;
+
+      /**
+       Applies the preconditioner. Returns false, without modifying `out`,
+       if no preconditioner is set.
+       */
+      virtual bool precondition(VectorStorage<N>& /* out */,
+                                const VectorStorage<N>& /* in */) {
+        return false;
+      }
   };
 
   /**
    @brief The conjugate gradient method, solves @f$ A x = b @f$.
+
+   If a preconditioner @f$ M^{-1} @f$ is set, the preconditioned conjugate
+   gradient method is used. Like A, the preconditioner needs to be
+   self-adjoint and positive definite.
+
    @ingroup linear_solver
    */
   template <typename V>
@@ -72,6 +92,12 @@ namespace allium {
         m_mat = mat;
       }
 
+      /** Sets the preconditioner, which approximates the inverse of the
+          matrix. Passing nullptr removes the preconditioner. */
+      void preconditioner(std::shared_ptr<Matrix> pc) {
+        m_pc = pc;
+      }
+
       void solve(Vector& solution,
                  const Vector& rhs,
                  InitialGuess initial_guess = InitialGuess::NOT_PROVIDED) override {
@@ -80,6 +106,7 @@ namespace allium {
 
     private:
       std::shared_ptr<Matrix> m_mat;
+      std::shared_ptr<Matrix> m_pc;
 
       void matvec(VectorStorage<Number>& out, const VectorStorage<Number>& in) override {
         ALLIUM_NO_NONNULL_WARNING
@@ -91,6 +118,29 @@ namespace allium {
         m_mat->apply(static_cast<V&>(out),
                      static_cast<const V&>(in));
       }
+
+      void matvec_add(VectorStorage<Number>& out,
+                      Number alpha,
+                      const VectorStorage<Number>& in,
+                      Number beta) override {
+        ALLIUM_NO_NONNULL_WARNING
+        allium_assert(dynamic_cast<const V*>(&in) != nullptr);
+        allium_assert(dynamic_cast<V*>(&out) != nullptr);
+        ALLIUM_RESTORE_WARNING
+        allium_assert(static_cast<bool>(m_mat), "operator provided");
+
+        m_mat->apply_add(static_cast<V&>(out), alpha,
+                         static_cast<const V&>(in), beta);
+      }
+
+      bool precondition(VectorStorage<Number>& out, const VectorStorage<Number>& in) override {
+        if (!m_pc)
+          return false;
+
+        m_pc->apply(static_cast<V&>(out),
+                    static_cast<const V&>(in));
+        return true;
+      }
   };
 
   /**
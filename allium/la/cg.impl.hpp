@@ -28,27 +28,35 @@ namespace allium {
                               InitialGuess initial_guess)
   {
     auto residual = allocate_like(rhs);
-    auto new_residual = allocate_like(rhs);
     auto x = allocate_like(rhs);
-    auto tmp1 = allocate_like(rhs);
 
+    //residual = rhs - m_mat * x;
+    residual->assign(rhs);
     switch (initial_guess) {
       case InitialGuess::NOT_PROVIDED:
         set_zero(*x);
       break;
       case InitialGuess::PROVIDED:
         x->assign(solution);
+        matvec_add(*residual, -1, *x, 1);
       break;
     }
 
-    //residual = rhs - m_mat * x;
-    matvec(*tmp1, *x);
-    residual->assign(rhs);
-    residual->add_scaled(-1, *tmp1);
+    // z = M^{-1} residual, without a preconditioner z is the residual itself
+    std::unique_ptr<VectorStorage<N>> preconditioned;
+    const VectorStorage<N>* z = residual.get();
+    {
+      auto pz = allocate_like(rhs);
+      if (precondition(*pz, *residual)) {
+        preconditioned = std::move(pz);
+        z = preconditioned.get();
+      }
+    }
 
     Real residual_norm_sq = std::real(residual->dot(*residual));
+    Real rz = preconditioned ? std::real(residual->dot(*z)) : residual_norm_sq;
     auto p = allocate_like(rhs);
-    p->assign(*residual);
+    p->assign(*z);
 
     Real abs_tol = rhs.l2_norm() * m_tol;
 
@@ -61,28 +69,30 @@ namespace allium {
 
         matvec(*Ap, *p);
 
-        Real alpha = std::real(residual->dot(*residual)) / std::real(p->dot(*Ap));
+        Real alpha = rz / std::real(p->dot(*Ap));
 
         // x = x + alpha * p;
         x->add_scaled(alpha, *p);
 
-        // new_residual = residual - alpha * Ap;
-        new_residual->assign(*residual);
-        new_residual->add_scaled(-alpha, *Ap);
+        // residual = residual - alpha * Ap;
+        residual->add_scaled(-alpha, *Ap);
+
+        residual_norm_sq = std::real(residual->dot(*residual));
 
-        Real new_residual_norm_sq
-          = std::real(new_residual->dot(*new_residual));
+        if (sqrt(residual_norm_sq) <= abs_tol) break;
 
-        if (sqrt(new_residual_norm_sq) <= abs_tol) break;
+        Real new_rz = residual_norm_sq;
+        if (preconditioned) {
+          precondition(*preconditioned, *residual);
+          new_rz = std::real(residual->dot(*z));
+        }
 
-        Real beta = new_residual_norm_sq / residual_norm_sq;
-        // p = beta * p + new_residual
+        Real beta = new_rz / rz;
+        // p = beta * p + z
         *p *= beta;
-        *p += *new_residual;
+        *p += *z;
 
-        // @todo Remove unecessary copying
-        residual->assign(*new_residual);
-        residual_norm_sq = new_residual_norm_sq;
+        rz = new_rz;
       }
     }
 
@@ -0,0 +1,23 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "compact_csr_sparse_matrix.impl.hpp"
+
+namespace allium {
+  ALLIUM_NOEXTERN_N(ALLIUM_COMPACT_CSR_SPARSE_MATRIX_DECL)
+
+  template class CompactCsrSparseMatrixStorage<double, float>;
+  template class CompactCsrSparseMatrixStorage<std::complex<double>,
+                                               std::complex<float>>;
+}
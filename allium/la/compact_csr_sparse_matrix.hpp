@@ -0,0 +1,97 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_COMPACT_CSR_SPARSE_MATRIX_HPP
+#define ALLIUM_LA_COMPACT_CSR_SPARSE_MATRIX_HPP
+
+#include "sparse_matrix.hpp"
+#include "eigen_vector.hpp"
+#include "local_csr_matrix.hpp"
+#include <allium/util/extern.hpp>
+#include <allium/util/parallel.hpp>
+#include <cstdint>
+
+namespace allium {
+
+  /**
+   @brief A native sparse matrix in CSR format with 32 bit column indices,
+   whose values can be stored with a lower precision than the vectors.
+
+   The matrix-vector product is limited by the memory bandwidth, which is
+   mostly spent on the column indices and the values. With 32 bit indices
+   and `S = float` (for `N = double`), an entry takes 8 instead of 16 bytes.
+   The values are converted to `N` in the product, and the sums are
+   computed in the precision of `N`. The rows are split among the threads
+   like for CsrSparseMatrixStorage.
+
+   The number of columns must be less than 2^32. Like EigenVectorStorage,
+   this matrix cannot be distributed.
+
+   @tparam N The number type of the vectors.
+   @tparam S The number type of the stored values.
+   */
+  template <typename N, typename S = N>
+  class CompactCsrSparseMatrixStorage final
+      : public SparseMatrixStorage<EigenVectorStorage<N>>
+  {
+    public:
+      using Vector = EigenVectorStorage<N>;
+      using DefaultVector = EigenVectorStorage<N>;
+      using typename SparseMatrixStorage<Vector>::Number;
+      using typename SparseMatrixStorage<Vector>::Real;
+      using SparseMatrixStorage<Vector>::row_spec;
+      using SparseMatrixStorage<Vector>::col_spec;
+      using StoredNumber = S;
+      using Index = uint32_t;
+
+      CompactCsrSparseMatrixStorage(VectorSpec rows, VectorSpec cols);
+
+      void set_entries(LocalCooMatrix<N> lmat) override;
+      void set_csr(LocalCsrMatrix<N> mat) override;
+      LocalCooMatrix<N> get_entries() override;
+      void set_values(const std::vector<N>& values) override;
+
+      void apply(Vector& result, const Vector& arg) override;
+
+      const aligned_vector<size_t>& row_ptr() const { return m_row_ptr; }
+      const aligned_vector<Index>& col_ind() const { return m_col_ind; }
+      const aligned_vector<S>& values() const { return m_values; }
+
+      /**
+       Sets the number of threads used by the matrix-vector product,
+       independent of max_threads(). Zero, the default, uses max_threads().
+       */
+      void threads(int threads) { m_threads = threads; }
+      int threads() const { return m_threads > 0 ? m_threads : max_threads(); }
+
+    private:
+      aligned_vector<size_t> m_row_ptr;
+      aligned_vector<Index> m_col_ind;
+      aligned_vector<S> m_values;
+
+      /// First row of every thread's block, plus the row count.
+      std::vector<size_t> m_partition;
+      int m_threads = 0;
+  };
+
+  #define ALLIUM_COMPACT_CSR_SPARSE_MATRIX_DECL(extern, N) \
+    extern template class CompactCsrSparseMatrixStorage<N>;
+  ALLIUM_EXTERN_N(ALLIUM_COMPACT_CSR_SPARSE_MATRIX_DECL)
+
+  extern template class CompactCsrSparseMatrixStorage<double, float>;
+  extern template class CompactCsrSparseMatrixStorage<std::complex<double>,
+                                                      std::complex<float>>;
+}
+
+#endif
@@ -0,0 +1,145 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_COMPACT_CSR_SPARSE_MATRIX_IMPL_HPP
+#define ALLIUM_LA_COMPACT_CSR_SPARSE_MATRIX_IMPL_HPP
+
+#include "compact_csr_sparse_matrix.hpp"
+
+#include <allium/util/numeric.hpp>
+#include <allium/util/parallel.hpp>
+#include <limits>
+
+namespace allium {
+
+  template <typename N, typename S>
+  CompactCsrSparseMatrixStorage<N, S>::CompactCsrSparseMatrixStorage(
+    VectorSpec rows, VectorSpec cols)
+    : SparseMatrixStorage<Vector>(rows, cols),
+      m_row_ptr(rows.local_size() + 1, 0)
+  {
+    if (rows.comm().size() != 1) {
+      throw std::logic_error("Objects of type CompactCsrSparseMatrixStorage cannot be distributed.");
+    }
+    if (cols.global_size() > std::numeric_limits<Index>::max()) {
+      throw std::logic_error("Too many columns for 32 bit column indices.");
+    }
+  }
+
+  template <typename N, typename S>
+  void CompactCsrSparseMatrixStorage<N, S>::set_entries(LocalCooMatrix<N> lmat)
+  {
+    set_csr(LocalCsrMatrix<N>(row_spec().local_size(),
+                              col_spec().global_size(),
+                              lmat,
+                              row_spec().local_start()));
+  }
+
+  template <typename N, typename S>
+  void CompactCsrSparseMatrixStorage<N, S>::set_csr(LocalCsrMatrix<N> mat)
+  {
+    this->check_csr_size(mat);
+
+    const size_t nnz = mat.nnz();
+    m_row_ptr = mat.row_ptr();
+    m_col_ind.resize(nnz);
+    m_values.resize(nnz);
+
+    const global_size_t* col_ind = mat.col_ind().data();
+    const N* values = mat.values().data();
+    Index* compact_col_ind = m_col_ind.data();
+    S* compact_values = m_values.data();
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel for schedule(static) num_threads(max_threads())
+    #endif
+    for (size_t i_entry = 0; i_entry < nnz; ++i_entry) {
+      compact_col_ind[i_entry] = col_ind[i_entry];
+      compact_values[i_entry] = narrow_number<S, N>()(values[i_entry]);
+    }
+
+    m_partition.clear();
+  }
+
+  template <typename N, typename S>
+  LocalCooMatrix<N> CompactCsrSparseMatrixStorage<N, S>::get_entries()
+  {
+    global_size_t row_offset = row_spec().local_start();
+    size_t rows = m_row_ptr.size() - 1;
+
+    LocalCooMatrix<N> coo;
+    coo.reserve(m_values.size());
+    for (size_t i_row = 0; i_row < rows; ++i_row) {
+      for (size_t i_entry = m_row_ptr[i_row];
+           i_entry < m_row_ptr[i_row+1];
+           ++i_entry)
+      {
+        coo.add(row_offset + i_row, m_col_ind[i_entry], N(m_values[i_entry]));
+      }
+    }
+    return coo;
+  }
+
+  template <typename N, typename S>
+  void CompactCsrSparseMatrixStorage<N, S>::set_values(const std::vector<N>& values)
+  {
+    if (values.size() != m_values.size()) {
+      throw std::invalid_argument("The value count does not match the sparsity pattern.");
+    }
+
+    std::transform(values.begin(), values.end(), m_values.begin(),
+                   narrow_number<S, N>());
+  }
+
+  template <typename N, typename S>
+  void CompactCsrSparseMatrixStorage<N, S>::apply(Vector& result,
+                                                  const Vector& arg)
+  {
+    this->check_apply_sizes(result, arg);
+
+    int parts = threads();
+    size_t rows = m_row_ptr.size() - 1;
+    if (m_partition.size() != static_cast<size_t>(parts) + 1) {
+      m_partition = partition_rows(m_row_ptr.data(), rows, parts);
+    }
+
+    const size_t* row_ptr = m_row_ptr.data();
+    const Index* col_ind = m_col_ind.data();
+    const S* values = m_values.data();
+    const N* x = arg.native().data();
+    N* y = result.native().data();
+    const size_t* partition = m_partition.data();
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel for schedule(static, 1) num_threads(parts)
+    #endif
+    for (int i_part = 0; i_part < parts; ++i_part) {
+      for (size_t i_row = partition[i_part];
+           i_row < partition[i_part+1];
+           ++i_row)
+      {
+        N sum = 0;
+        for (size_t i_entry = row_ptr[i_row];
+             i_entry < row_ptr[i_row+1];
+             ++i_entry)
+        {
+          sum += N(values[i_entry]) * x[col_ind[i_entry]];
+        }
+        y[i_row] = sum;
+      }
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,90 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_CSR_SPARSE_MATRIX_HPP
+#define ALLIUM_LA_CSR_SPARSE_MATRIX_HPP
+
+#include "sparse_matrix.hpp"
+#include "eigen_vector.hpp"
+#include "local_csr_matrix.hpp"
+#include <allium/util/extern.hpp>
+#include <allium/util/parallel.hpp>
+
+namespace allium {
+
+  /**
+   @brief A native sparse matrix in compressed sparse row (CSR) format.
+
+   The matrix-vector product is multithreaded (if OpenMP is available). The
+   rows are split statically into one contiguous block per thread, such that
+   all blocks contain roughly the same number of entries.
+
+   Like EigenVectorStorage, this matrix cannot be distributed.
+   */
+  template <typename N>
+  class CsrSparseMatrixStorage final
+      : public SparseMatrixStorage<EigenVectorStorage<N>>
+  {
+    public:
+      using Vector = EigenVectorStorage<N>;
+      using DefaultVector = EigenVectorStorage<N>;
+      using typename SparseMatrixStorage<Vector>::Number;
+      using typename SparseMatrixStorage<Vector>::Real;
+      using SparseMatrixStorage<Vector>::row_spec;
+      using SparseMatrixStorage<Vector>::col_spec;
+
+      CsrSparseMatrixStorage(VectorSpec rows, VectorSpec cols);
+
+      /** Creates the matrix from the given local rows. */
+      CsrSparseMatrixStorage(VectorSpec rows,
+                             VectorSpec cols,
+                             LocalCsrMatrix<N> mat);
+
+      void set_entries(LocalCooMatrix<N> lmat) override;
+
+      /** Takes over the rows as they are. */
+      void set_csr(LocalCsrMatrix<N> mat) override;
+
+      LocalCooMatrix<N> get_entries() override;
+      void set_values(const std::vector<N>& values) override;
+
+      void apply(Vector& result, const Vector& arg) override;
+
+      /** Uses csr_block_product with the same row partition as apply(). */
+      void apply_block(MultiVector<N, Eigen::RowMajor>& result,
+                       const MultiVector<N, Eigen::RowMajor>& arg) override;
+
+      const LocalCsrMatrix<N>& local_matrix() const { return m_mat; }
+
+      /**
+       Sets the number of threads used by the matrix-vector product,
+       independent of max_threads(). Zero, the default, uses max_threads().
+       */
+      void threads(int threads) { m_threads = threads; }
+      int threads() const { return m_threads > 0 ? m_threads : max_threads(); }
+
+    private:
+      LocalCsrMatrix<N> m_mat;
+      int m_threads = 0;
+
+      /// First row of every thread's block, plus the row count.
+      std::vector<size_t> m_partition;
+  };
+
+  #define ALLIUM_CSR_SPARSE_MATRIX_DECL(extern, N) \
+    extern template class CsrSparseMatrixStorage<N>;
+  ALLIUM_EXTERN_N(ALLIUM_CSR_SPARSE_MATRIX_DECL)
+}
+
+#endif
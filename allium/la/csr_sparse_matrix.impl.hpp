@@ -0,0 +1,100 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_CSR_SPARSE_MATRIX_IMPL_HPP
+#define ALLIUM_LA_CSR_SPARSE_MATRIX_IMPL_HPP
+
+#include "csr_sparse_matrix.hpp"
+
+#include <allium/util/parallel.hpp>
+
+namespace allium {
+
+  template <typename N>
+  CsrSparseMatrixStorage<N>::CsrSparseMatrixStorage(VectorSpec rows,
+                                                    VectorSpec cols)
+    : SparseMatrixStorage<Vector>(rows, cols),
+      m_mat(rows.local_size(), cols.global_size())
+  {
+    if (rows.comm().size() != 1) {
+      throw std::logic_error("Objects of type CsrSparseMatrixStorage cannot be distributed.");
+    }
+  }
+
+  template <typename N>
+  CsrSparseMatrixStorage<N>::CsrSparseMatrixStorage(VectorSpec rows,
+                                                    VectorSpec cols,
+                                                    LocalCsrMatrix<N> mat)
+    : CsrSparseMatrixStorage(rows, cols)
+  {
+    set_csr(std::move(mat));
+  }
+
+  template <typename N>
+  void CsrSparseMatrixStorage<N>::set_entries(LocalCooMatrix<N> lmat)
+  {
+    m_mat = LocalCsrMatrix<N>(row_spec().local_size(),
+                              col_spec().global_size(),
+                              lmat,
+                              row_spec().local_start());
+    m_partition.clear();
+  }
+
+  template <typename N>
+  void CsrSparseMatrixStorage<N>::set_csr(LocalCsrMatrix<N> mat)
+  {
+    this->check_csr_size(mat);
+    m_mat = std::move(mat);
+    m_partition.clear();
+  }
+
+  template <typename N>
+  LocalCooMatrix<N> CsrSparseMatrixStorage<N>::get_entries()
+  {
+    return m_mat.to_coo(row_spec().local_start());
+  }
+
+  template <typename N>
+  void CsrSparseMatrixStorage<N>::set_values(const std::vector<N>& values)
+  {
+    if (values.size() != m_mat.nnz()) {
+      throw std::invalid_argument("The value count does not match the sparsity pattern.");
+    }
+
+    std::copy(values.begin(), values.end(), m_mat.values().begin());
+  }
+
+  template <typename N>
+  void CsrSparseMatrixStorage<N>::apply(Vector& result, const Vector& arg)
+  {
+    this->check_apply_sizes(result, arg);
+
+    update_row_partition(m_mat, m_partition, threads());
+    csr_apply(m_mat, m_partition, arg.native().data(), result.native().data());
+  }
+
+  template <typename N>
+  void CsrSparseMatrixStorage<N>::apply_block(
+    MultiVector<N, Eigen::RowMajor>& result,
+    const MultiVector<N, Eigen::RowMajor>& arg)
+  {
+    this->check_block_sizes(result, arg);
+
+    update_row_partition(m_mat, m_partition, threads());
+    csr_block_product(m_mat, m_partition, arg.count(),
+                      arg.native().data(), result.native().data());
+  }
+}
+
+#endif
@@ -27,7 +27,7 @@
     using DefaultVector = EigenVectorStorage<N>;
 
     template <typename N>
-    using DefaultSparseMatrix = EigenSparseMatrixStorage<N>;
+    using DefaultSparseMatrix = EigenSparseMatrixStorage<N, Eigen::RowMajor>;
   }
 
 #elif defined(ALLIUM_DEFAULT_BACKEND_PETSC)
@@ -0,0 +1,131 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_DISTRIBUTED_CSR_SPARSE_MATRIX_HPP
+#define ALLIUM_LA_DISTRIBUTED_CSR_SPARSE_MATRIX_HPP
+
+#include "sparse_matrix.hpp"
+#include "distributed_vector.hpp"
+#include "local_csr_matrix.hpp"
+#include <allium/util/extern.hpp>
+
+namespace allium {
+
+  /**
+   @brief A native sparse matrix in CSR format, whose rows are distributed
+   across the ranks.
+
+   The local rows are split into the diagonal block, which contains the
+   columns of the local part of the argument, and the off-diagonal block,
+   which contains all other columns. The columns of the off-diagonal block
+   are compressed to the ghost columns, i.e., the columns that actually
+   occur in the local rows. They are derived from the entries, when they are
+   set, along with the plan to exchange the ghost values.
+
+   The matrix-vector product starts the exchange of the ghost values, then
+   multiplies with the diagonal block while the messages are in flight and
+   finishes with the off-diagonal block.
+   */
+  template <typename N>
+  class DistributedCsrSparseMatrixStorage final
+      : public SparseMatrixStorage<DistributedVectorStorage<N>>
+  {
+    public:
+      using Vector = DistributedVectorStorage<N>;
+      using DefaultVector = DistributedVectorStorage<N>;
+      using typename SparseMatrixStorage<Vector>::Number;
+      using typename SparseMatrixStorage<Vector>::Real;
+      using SparseMatrixStorage<Vector>::row_spec;
+      using SparseMatrixStorage<Vector>::col_spec;
+
+      DistributedCsrSparseMatrixStorage(VectorSpec rows, VectorSpec cols);
+
+      /**
+       Sets the entries of the matrix. Entries of rows that are owned by
+       other ranks are sent to their owner, see exchange_entries(). Every
+       rank must call this method, since the entries are exchanged and the
+       exchange of the ghost values is planned collectively.
+       */
+      void set_entries(LocalCooMatrix<N> lmat) override;
+
+      /**
+       Splits the local rows into the blocks without sorting them. Unlike
+       set_entries(), no entries are sent to other ranks.
+       */
+      void set_csr(LocalCsrMatrix<N> mat) override;
+
+      /**
+       The entries of the local rows, row by row. The entries of the
+       diagonal block precede the ones of the off-diagonal block in every
+       row.
+       */
+      LocalCooMatrix<N> get_entries() override;
+      void set_values(const std::vector<N>& values) override;
+
+      void apply(Vector& result, const Vector& arg) override;
+
+      /**
+       Exchanges the ghost values of all vectors in one message per
+       neighbor and applies both blocks by csr_block_product.
+       */
+      void apply_block(MultiVector<N, Eigen::RowMajor>& result,
+                       const MultiVector<N, Eigen::RowMajor>& arg) override;
+
+      /** The diagonal block, with local column indices. */
+      const LocalCsrMatrix<N>& diagonal_block() const { return m_diag; }
+
+      /** The off-diagonal block, indexed by the position of the ghost. */
+      const LocalCsrMatrix<N>& off_diagonal_block() const { return m_off_diag; }
+
+      /** The global indices of the ghost columns, sorted ascendingly. */
+      const std::vector<global_size_t>& ghost_columns() const { return m_ghosts; }
+
+    private:
+      LocalCsrMatrix<N> m_diag;
+      LocalCsrMatrix<N> m_off_diag;
+      std::vector<global_size_t> m_ghosts;
+
+      /// The ranks owning ghost columns and the first ghost of each, plus
+      /// the ghost count.
+      std::vector<int> m_recv_ranks;
+      std::vector<size_t> m_recv_offsets;
+
+      /// The ranks needing local values, the first position of each in
+      /// m_send_indices, plus the total count, and the local indices of the
+      /// values to send.
+      std::vector<int> m_send_ranks;
+      std::vector<size_t> m_send_offsets;
+      std::vector<size_t> m_send_indices;
+
+      aligned_vector<N> m_send_buffer;
+      aligned_vector<N> m_ghost_buffer;
+
+      /// The buffers of apply_block, for all vectors of a block
+      aligned_vector<N> m_block_send_buffer;
+      aligned_vector<N> m_block_ghost_buffer;
+      std::vector<MPI_Request> m_requests;
+
+      /// First row of every thread's block, plus the row count.
+      std::vector<size_t> m_diag_partition;
+      std::vector<size_t> m_off_diag_partition;
+
+      void plan_exchange();
+  };
+
+  #define ALLIUM_DISTRIBUTED_CSR_SPARSE_MATRIX_DECL(extern, N) \
+    extern template class DistributedCsrSparseMatrixStorage<N>;
+  ALLIUM_EXTERN_N(ALLIUM_DISTRIBUTED_CSR_SPARSE_MATRIX_DECL)
+}
+
+#endif
@@ -0,0 +1,354 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_DISTRIBUTED_CSR_SPARSE_MATRIX_IMPL_HPP
+#define ALLIUM_LA_DISTRIBUTED_CSR_SPARSE_MATRIX_IMPL_HPP
+
+#include "distributed_csr_sparse_matrix.hpp"
+#include "entry_exchange.hpp"
+
+#include <allium/util/parallel.hpp>
+
+namespace allium {
+
+  /// @cond INTERNAL
+  namespace detail {
+    const int ghost_request_tag = 7100;
+    const int ghost_value_tag = 7101;
+  }
+  /// @endcond
+
+  template <typename N>
+  DistributedCsrSparseMatrixStorage<N>::DistributedCsrSparseMatrixStorage(
+    VectorSpec rows, VectorSpec cols)
+    : SparseMatrixStorage<Vector>(rows, cols),
+      m_diag(rows.local_size(), cols.local_size()),
+      m_off_diag(rows.local_size(), 0),
+      m_recv_offsets(1, 0),
+      m_send_offsets(1, 0)
+  {}
+
+  template <typename N>
+  void DistributedCsrSparseMatrixStorage<N>::set_entries(LocalCooMatrix<N> lmat)
+  {
+    lmat = detail::send_remote_entries(row_spec(), std::move(lmat));
+
+    // All ranks have to agree on an invalid entry, like in set_csr().
+    int invalid = 0;
+    const global_size_t global_cols = col_spec().global_size();
+    for (auto col : lmat.col_ind()) {
+      if (col >= global_cols) {
+        invalid = 1;
+        break;
+      }
+    }
+    if (row_spec().comm().sum_allreduce(invalid) > 0) {
+      throw std::out_of_range("Matrix entry is out of the column range.");
+    }
+
+    // duplicates are summed by the conversion to CSR
+    set_csr(LocalCsrMatrix<N>(row_spec().local_size(),
+                              global_cols,
+                              lmat,
+                              row_spec().local_start()));
+  }
+
+  template <typename N>
+  void DistributedCsrSparseMatrixStorage<N>::set_csr(LocalCsrMatrix<N> mat)
+  {
+    this->check_csr_size(mat);
+
+    const global_size_t col_start = col_spec().local_start();
+    const global_size_t col_end = col_spec().local_end();
+    const global_size_t global_cols = col_spec().global_size();
+    const size_t rows = mat.rows();
+    const size_t* row_ptr = mat.row_ptr().data();
+    const global_size_t* col_ind = mat.col_ind().data();
+    const N* values = mat.values().data();
+
+    // The other ranks would wait in plan_exchange(), if only this rank
+    // threw.
+    int invalid = 0;
+    m_ghosts.clear();
+    aligned_vector<size_t> diag_row_ptr(rows + 1, 0);
+    aligned_vector<size_t> off_diag_row_ptr(rows + 1, 0);
+    for (size_t i_row = 0; i_row < rows; ++i_row) {
+      diag_row_ptr[i_row+1] = diag_row_ptr[i_row];
+      off_diag_row_ptr[i_row+1] = off_diag_row_ptr[i_row];
+      for (size_t i_entry = row_ptr[i_row]; i_entry < row_ptr[i_row+1]; ++i_entry) {
+        global_size_t col = col_ind[i_entry];
+        if (col >= global_cols) {
+          invalid = 1;
+        } else if (col >= col_start && col < col_end) {
+          ++diag_row_ptr[i_row+1];
+        } else {
+          m_ghosts.push_back(col);
+          ++off_diag_row_ptr[i_row+1];
+        }
+      }
+    }
+    if (row_spec().comm().sum_allreduce(invalid) > 0) {
+      throw std::out_of_range("Matrix entry is out of the column range.");
+    }
+
+    std::sort(m_ghosts.begin(), m_ghosts.end());
+    m_ghosts.erase(std::unique(m_ghosts.begin(), m_ghosts.end()),
+                   m_ghosts.end());
+
+    // The columns of every row are sorted, and so are the local columns and
+    // the ghost indices of both blocks.
+    aligned_vector<global_size_t> diag_col_ind(diag_row_ptr[rows]);
+    aligned_vector<N> diag_values(diag_row_ptr[rows]);
+    aligned_vector<global_size_t> off_diag_col_ind(off_diag_row_ptr[rows]);
+    aligned_vector<N> off_diag_values(off_diag_row_ptr[rows]);
+    size_t i_diag = 0;
+    size_t i_off_diag = 0;
+    for (size_t i_entry = 0; i_entry < mat.nnz(); ++i_entry) {
+      global_size_t col = col_ind[i_entry];
+      if (col >= col_start && col < col_end) {
+        diag_col_ind[i_diag] = col - col_start;
+        diag_values[i_diag] = values[i_entry];
+        ++i_diag;
+      } else {
+        off_diag_col_ind[i_off_diag] =
+          std::lower_bound(m_ghosts.begin(), m_ghosts.end(), col)
+          - m_ghosts.begin();
+        off_diag_values[i_off_diag] = values[i_entry];
+        ++i_off_diag;
+      }
+    }
+
+    m_diag = LocalCsrMatrix<N>(col_spec().local_size(),
+                               std::move(diag_row_ptr),
+                               std::move(diag_col_ind),
+                               std::move(diag_values));
+    m_off_diag = LocalCsrMatrix<N>(m_ghosts.size(),
+                                   std::move(off_diag_row_ptr),
+                                   std::move(off_diag_col_ind),
+                                   std::move(off_diag_values));
+    m_diag_partition.clear();
+    m_off_diag_partition.clear();
+
+    plan_exchange();
+  }
+
+  template <typename N>
+  void DistributedCsrSparseMatrixStorage<N>::plan_exchange()
+  {
+    Comm comm = col_spec().comm();
+    const int ranks = comm.size();
+    auto col_starts = comm.allgather(col_spec().local_start());
+
+    // the ghosts are sorted, hence the ghosts of every owner are contiguous
+    std::vector<int> request_counts(ranks, 0);
+    m_recv_ranks.clear();
+    m_recv_offsets.assign(1, 0);
+    for (size_t i_ghost = 0; i_ghost < m_ghosts.size(); ++i_ghost) {
+      int owner = std::upper_bound(col_starts.begin(), col_starts.end(),
+                                   m_ghosts[i_ghost])
+                  - col_starts.begin() - 1;
+      if (m_recv_ranks.empty() || m_recv_ranks.back() != owner) {
+        if (!m_recv_ranks.empty()) {
+          m_recv_offsets.push_back(i_ghost);
+        }
+        m_recv_ranks.push_back(owner);
+      }
+      ++request_counts[owner];
+    }
+    if (!m_recv_ranks.empty()) {
+      m_recv_offsets.push_back(m_ghosts.size());
+    }
+
+    // tell the owners, which of their values are needed
+    auto send_counts = comm.alltoall(request_counts);
+
+    m_send_ranks.clear();
+    m_send_offsets.assign(1, 0);
+    for (int i_rank = 0; i_rank < ranks; ++i_rank) {
+      if (send_counts[i_rank] > 0) {
+        m_send_ranks.push_back(i_rank);
+        m_send_offsets.push_back(m_send_offsets.back() + send_counts[i_rank]);
+      }
+    }
+
+    std::vector<global_size_t> requested(m_send_offsets.back());
+    for (size_t i = 0; i < m_send_ranks.size(); ++i) {
+      m_requests.push_back(
+        comm.irecv(requested.data() + m_send_offsets[i],
+                   m_send_offsets[i+1] - m_send_offsets[i],
+                   m_send_ranks[i],
+                   detail::ghost_request_tag));
+    }
+    for (size_t i = 0; i < m_recv_ranks.size(); ++i) {
+      m_requests.push_back(
+        comm.isend(m_ghosts.data() + m_recv_offsets[i],
+                   m_recv_offsets[i+1] - m_recv_offsets[i],
+                   m_recv_ranks[i],
+                   detail::ghost_request_tag));
+    }
+    Comm::wait_all(m_requests);
+
+    const global_size_t col_start = col_spec().local_start();
+    m_send_indices.resize(requested.size());
+    for (size_t i = 0; i < requested.size(); ++i) {
+      m_send_indices[i] = requested[i] - col_start;
+    }
+
+    m_send_buffer.resize(m_send_indices.size());
+    m_ghost_buffer.resize(m_ghosts.size());
+  }
+
+  template <typename N>
+  LocalCooMatrix<N> DistributedCsrSparseMatrixStorage<N>::get_entries()
+  {
+    const global_size_t row_start = row_spec().local_start();
+    const global_size_t col_start = col_spec().local_start();
+
+    LocalCooMatrix<N> entries;
+    entries.reserve(m_diag.nnz() + m_off_diag.nnz());
+    for (size_t i_row = 0; i_row < m_diag.rows(); ++i_row) {
+      for (size_t i_entry = m_diag.row_ptr()[i_row];
+           i_entry < m_diag.row_ptr()[i_row+1];
+           ++i_entry)
+      {
+        entries.add(row_start + i_row,
+                    col_start + m_diag.col_ind()[i_entry],
+                    m_diag.values()[i_entry]);
+      }
+      for (size_t i_entry = m_off_diag.row_ptr()[i_row];
+           i_entry < m_off_diag.row_ptr()[i_row+1];
+           ++i_entry)
+      {
+        entries.add(row_start + i_row,
+                    m_ghosts[m_off_diag.col_ind()[i_entry]],
+                    m_off_diag.values()[i_entry]);
+      }
+    }
+    return entries;
+  }
+
+  template <typename N>
+  void DistributedCsrSparseMatrixStorage<N>::set_values(const std::vector<N>& values)
+  {
+    if (values.size() != m_diag.nnz() + m_off_diag.nnz()) {
+      throw std::invalid_argument("The value count does not match the sparsity pattern.");
+    }
+
+    // the values are given in the order of get_entries
+    const N* value = values.data();
+    for (size_t i_row = 0; i_row < m_diag.rows(); ++i_row) {
+      for (size_t i_entry = m_diag.row_ptr()[i_row];
+           i_entry < m_diag.row_ptr()[i_row+1];
+           ++i_entry)
+      {
+        m_diag.values()[i_entry] = *value++;
+      }
+      for (size_t i_entry = m_off_diag.row_ptr()[i_row];
+           i_entry < m_off_diag.row_ptr()[i_row+1];
+           ++i_entry)
+      {
+        m_off_diag.values()[i_entry] = *value++;
+      }
+    }
+  }
+
+  template <typename N>
+  void DistributedCsrSparseMatrixStorage<N>::apply(Vector& result, const Vector& arg)
+  {
+    Comm comm = col_spec().comm();
+    const N* x = arg.native().data();
+    N* y = result.native().data();
+
+    for (size_t i = 0; i < m_send_indices.size(); ++i) {
+      m_send_buffer[i] = x[m_send_indices[i]];
+    }
+
+    for (size_t i = 0; i < m_recv_ranks.size(); ++i) {
+      m_requests.push_back(
+        comm.irecv(m_ghost_buffer.data() + m_recv_offsets[i],
+                   m_recv_offsets[i+1] - m_recv_offsets[i],
+                   m_recv_ranks[i],
+                   detail::ghost_value_tag));
+    }
+    for (size_t i = 0; i < m_send_ranks.size(); ++i) {
+      m_requests.push_back(
+        comm.isend(m_send_buffer.data() + m_send_offsets[i],
+                   m_send_offsets[i+1] - m_send_offsets[i],
+                   m_send_ranks[i],
+                   detail::ghost_value_tag));
+    }
+
+    // the diagonal block does not need the ghost values
+    update_row_partition(m_diag, m_diag_partition);
+    csr_apply(m_diag, m_diag_partition, x, y);
+
+    Comm::wait_all(m_requests);
+
+    if (m_off_diag.nnz() > 0) {
+      update_row_partition(m_off_diag, m_off_diag_partition);
+      csr_apply(m_off_diag, m_off_diag_partition, m_ghost_buffer.data(), y, true);
+    }
+  }
+
+  template <typename N>
+  void DistributedCsrSparseMatrixStorage<N>::apply_block(
+    MultiVector<N, Eigen::RowMajor>& result,
+    const MultiVector<N, Eigen::RowMajor>& arg)
+  {
+    this->check_block_sizes(result, arg);
+
+    Comm comm = col_spec().comm();
+    const size_t k = arg.count();
+    const N* x = arg.native().data();
+    N* y = result.native().data();
+
+    // the values of all vectors at one index are contiguous, hence the
+    // messages are the ones of apply, with k values per index
+    m_block_send_buffer.resize(k * m_send_indices.size());
+    m_block_ghost_buffer.resize(k * m_ghosts.size());
+    for (size_t i = 0; i < m_send_indices.size(); ++i) {
+      std::copy(x + k * m_send_indices[i],
+                x + k * (m_send_indices[i] + 1),
+                m_block_send_buffer.data() + k * i);
+    }
+
+    for (size_t i = 0; i < m_recv_ranks.size(); ++i) {
+      m_requests.push_back(
+        comm.irecv(m_block_ghost_buffer.data() + k * m_recv_offsets[i],
+                   k * (m_recv_offsets[i+1] - m_recv_offsets[i]),
+                   m_recv_ranks[i],
+                   detail::ghost_value_tag));
+    }
+    for (size_t i = 0; i < m_send_ranks.size(); ++i) {
+      m_requests.push_back(
+        comm.isend(m_block_send_buffer.data() + k * m_send_offsets[i],
+                   k * (m_send_offsets[i+1] - m_send_offsets[i]),
+                   m_send_ranks[i],
+                   detail::ghost_value_tag));
+    }
+
+    update_row_partition(m_diag, m_diag_partition);
+    csr_block_product(m_diag, m_diag_partition, k, x, y);
+
+    Comm::wait_all(m_requests);
+
+    if (m_off_diag.nnz() > 0) {
+      update_row_partition(m_off_diag, m_off_diag_partition);
+      csr_block_product(m_off_diag, m_off_diag_partition, k,
+                        m_block_ghost_buffer.data(), y, true);
+    }
+  }
+}
+
+#endif
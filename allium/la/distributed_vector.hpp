@@ -0,0 +1,83 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_DISTRIBUTED_VECTOR_HPP
+#define ALLIUM_LA_DISTRIBUTED_VECTOR_HPP
+
+#include <allium/util/extern.hpp>
+#include "vector_storage.hpp"
+#include <Eigen/Core>
+
+namespace allium {
+
+  /**
+    @brief A native vector, which is distributed across the ranks of the
+    communicator of its specification.
+
+    Every rank stores its local part contiguously. Reductions, i.e., dot
+    products and norms, are computed locally and summed over all ranks.
+   */
+  template <typename N>
+  class DistributedVectorStorage final
+    : public VectorStorageTrait<DistributedVectorStorage<N>, N>
+  {
+    public:
+      template <typename> friend class LocalSlice;
+
+      using BaseVector = Eigen::Matrix<N, Eigen::Dynamic, 1>;
+      using typename VectorStorage<N>::Number;
+      using Real = real_part_t<N>;
+
+      explicit DistributedVectorStorage(VectorSpec spec);
+      DistributedVectorStorage(const DistributedVectorStorage& other);
+
+      using VectorStorageTrait<DistributedVectorStorage, N>::operator+=;
+      DistributedVectorStorage& operator+=(const DistributedVectorStorage<N>& rhs);
+
+      DistributedVectorStorage& operator*=(const N& factor) override;
+
+      void add_scaled(N factor, const DistributedVectorStorage& other);
+
+      using VectorStorageTrait<DistributedVectorStorage, N>::dot;
+      N dot(const DistributedVectorStorage& rhs) const;
+      Real l2_norm() const override;
+
+      void fill(N value) override;
+
+      /** The local part of the vector. */
+      BaseVector& native() { return vec; }
+      const BaseVector& native() const { return vec; }
+
+    protected:
+      Number* aquire_data_ptr() override;
+      void release_data_ptr(Number* data) override;
+
+    private:
+      BaseVector vec;
+
+      VectorStorage<N>* allocate_like() const& override {
+        return new DistributedVectorStorage(this->spec());
+      }
+
+      Cloneable* clone() const& override {
+        return new DistributedVectorStorage(*this);
+      }
+  };
+
+  #define ALLIUM_DISTRIBUTED_VECTOR_DECL(extern, N) \
+    extern template class DistributedVectorStorage<N>;
+  ALLIUM_EXTERN_N(ALLIUM_DISTRIBUTED_VECTOR_DECL)
+}
+
+#endif
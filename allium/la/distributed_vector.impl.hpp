@@ -0,0 +1,85 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "distributed_vector.hpp"
+
+#include <cmath>
+
+namespace allium {
+
+  template <typename N>
+    DistributedVectorStorage<N>::DistributedVectorStorage(VectorSpec spec)
+      : VectorStorageTrait<DistributedVectorStorage<N>, N>(spec),
+        vec(spec.local_size())
+    {}
+
+  template <typename N>
+    DistributedVectorStorage<N>::DistributedVectorStorage(const DistributedVectorStorage& other)
+      : VectorStorageTrait<DistributedVectorStorage, N>(other.spec()),
+        vec(other.vec)
+    {}
+
+  template <typename N>
+  auto DistributedVectorStorage<N>::operator+=(const DistributedVectorStorage<N>& rhs)
+    -> DistributedVectorStorage&
+  {
+    vec += rhs.vec;
+    return *this;
+  }
+
+  template <typename N>
+  auto DistributedVectorStorage<N>::operator*=(const N& factor)
+    -> DistributedVectorStorage&
+  {
+    vec *= factor;
+    return *this;
+  }
+
+  template <typename N>
+  void DistributedVectorStorage<N>::add_scaled(N factor,
+                                               const DistributedVectorStorage& other)
+  {
+    vec += factor * other.vec;
+  }
+
+  template <typename N>
+  N DistributedVectorStorage<N>::dot(const DistributedVectorStorage<N>& rhs) const
+  {
+    // eigen has a dot product wich is linear in the SECOND argument
+    return this->spec().comm().sum_allreduce(rhs.vec.dot(vec));
+  }
+
+  template <typename N>
+    auto DistributedVectorStorage<N>::l2_norm() const -> Real
+  {
+    return std::sqrt(this->spec().comm().sum_allreduce(vec.squaredNorm()));
+  }
+
+  template <typename N>
+    void DistributedVectorStorage<N>::fill(N value)
+  {
+    vec.setConstant(value);
+  }
+
+  template <typename N>
+    auto DistributedVectorStorage<N>::aquire_data_ptr() -> Number*
+  {
+    return vec.data();
+  }
+
+  template <typename Number>
+    void DistributedVectorStorage<Number>::release_data_ptr(Number* data)
+  {}
+
+}
@@ -18,59 +18,26 @@
 #include "sparse_matrix.hpp"
 #include "eigen_vector.hpp"
 #include "linear_operator.hpp"
+#include "local_csr_matrix.hpp"
 #include <allium/util/except.hpp>
 #include <Eigen/Sparse>
 
 namespace allium {
-  /** @cond INTERNAL */
-  template <typename N>
-  class triplet_iterator final {
-    public:
-      typedef typename std::vector<MatrixEntry<N>>::iterator base_iterator;
-
-      typedef typename base_iterator::difference_type difference_type;
-      typedef Eigen::Triplet<N> value_type;
-      typedef const Eigen::Triplet<N> *pointer;
-      typedef const Eigen::Triplet<N> &reference;
-      typedef std::forward_iterator_tag iterator_category;
-
-      explicit triplet_iterator(base_iterator base) : base(base) {};
-
-      bool operator!= (const triplet_iterator& other) const {
-        return base != other.base;
-      }
-
-      reference operator* () {
-        current = Eigen::Triplet<N>(base->row(),
-                                    base->col(),
-                                    base->value());
-        return current;
-      }
-
-      pointer operator-> () {
-        return &(**this);
-      }
-
-      triplet_iterator& operator++ () {
-        ++base;
-        return *this;
-      }
-    private:
-      base_iterator base;
-      Eigen::Triplet<N> current;
-  };
-  /** @endcond */
-
   /**
     @brief A sparse matrix implementation based on Eigen.
+
+    The storage order is Eigen::ColMajor or Eigen::RowMajor. With row-major
+    storage, the matrix-vector product is multithreaded by Eigen (if OpenMP
+    is available), using max_threads() threads.
    */
-  template <typename N>
+  template <typename N, int StorageOrder = Eigen::ColMajor>
   class EigenSparseMatrixStorage final
       : public SparseMatrixStorage<EigenVectorStorage<N>>
 		{
     public:
       using Vector = EigenVectorStorage<N>;
       using DefaultVector = EigenVectorStorage<N>;
+      using NativeMatrix = Eigen::SparseMatrix<N, StorageOrder>;
       using SparseMatrixStorage<Vector>::Number;
       using SparseMatrixStorage<Vector>::Real;
       using SparseMatrixStorage<Vector>::row_spec;
@@ -80,19 +47,73 @@ namespace allium {
         : SparseMatrixStorage<Vector>(rows, cols),
           m_mat(rows.global_size(), cols.global_size()) {}
 
+      /** Creates the matrix from an Eigen sparse matrix. */
+      EigenSparseMatrixStorage(VectorSpec rows,
+                               VectorSpec cols,
+                               NativeMatrix mat)
+        : SparseMatrixStorage<Vector>(rows, cols),
+          m_mat(std::move(mat))
+      {
+        if (m_mat.rows() != static_cast<long>(rows.global_size())
+            || m_mat.cols() != static_cast<long>(cols.global_size())) {
+          throw std::invalid_argument("The matrix size does not match the vector specifications.");
+        }
+        m_mat.makeCompressed();
+      }
+
       void set_entries(LocalCooMatrix<N> lmat) override {
-        auto entries = std::move(lmat).entries();
+        LocalCsrMatrix<N> csr(row_spec().global_size(),
+                              col_spec().global_size(),
+                              lmat);
 
-        m_mat.setFromTriplets(
-          triplet_iterator<N>(entries.begin()),
-          triplet_iterator<N>(entries.end()));
+        using StorageIndex = typename NativeMatrix::StorageIndex;
+
+        NativeMatrix mat(csr.rows(), csr.cols());
+        mat.resizeNonZeros(csr.nnz());
+
+        StorageIndex* outer = mat.outerIndexPtr();
+        StorageIndex* inner = mat.innerIndexPtr();
+        N* values = mat.valuePtr();
+
+        if (StorageOrder == Eigen::RowMajor) {
+          std::copy(csr.row_ptr().begin(), csr.row_ptr().end(), outer);
+          std::copy(csr.col_ind().begin(), csr.col_ind().end(), inner);
+          std::copy(csr.values().begin(), csr.values().end(), values);
+          m_mat = std::move(mat);
+          return;
+        }
+
+        // Transpose the sorted CSR arrays into the compressed column
+        // storage of Eigen. The rows of every column stay sorted.
+        std::fill(outer, outer + csr.cols() + 1, 0);
+        for (size_t i_entry = 0; i_entry < csr.nnz(); ++i_entry) {
+          ++outer[csr.col_ind()[i_entry] + 1];
+        }
+        for (size_t i_col = 0; i_col < csr.cols(); ++i_col) {
+          outer[i_col+1] += outer[i_col];
+        }
+
+        std::vector<StorageIndex> next(outer, outer + csr.cols());
+        for (size_t i_row = 0; i_row < csr.rows(); ++i_row) {
+          for (size_t i_entry = csr.row_ptr()[i_row];
+               i_entry < csr.row_ptr()[i_row+1];
+               ++i_entry)
+          {
+            StorageIndex pos = next[csr.col_ind()[i_entry]]++;
+            inner[pos] = static_cast<StorageIndex>(i_row);
+            values[pos] = csr.values()[i_entry];
+          }
+        }
+
+        m_mat = std::move(mat);
       };
 
       LocalCooMatrix<N> get_entries() override {
         LocalCooMatrix<N> lmat;
+        lmat.reserve(m_mat.nonZeros());
 
         for (long k=0; k < m_mat.outerSize(); ++k) {
-          for (typename Eigen::SparseMatrix<N>::InnerIterator it(m_mat,k); it; ++it)
+          for (typename NativeMatrix::InnerIterator it(m_mat,k); it; ++it)
           {
             lmat.add(it.row(), it.col(), it.value());
           }
@@ -101,13 +122,81 @@ namespace allium {
         return lmat;
       }
 
-      void apply(EigenVectorStorage<N>& result, const EigenVectorStorage<N>& arg) {
-        result.native() = m_mat * arg.native();
+      void set_values(const std::vector<N>& values) override {
+        if (values.size() != static_cast<size_t>(m_mat.nonZeros())) {
+          throw std::invalid_argument("The value count does not match the sparsity pattern.");
+        }
+
+        std::copy(values.begin(), values.end(), m_mat.valuePtr());
+      }
+
+      void apply(EigenVectorStorage<N>& result, const EigenVectorStorage<N>& arg) override {
+        // Eigen splits the rows of a row-major matrix into nbThreads()
+        // blocks, which follows set_max_threads()
+        result.native().noalias() = m_mat * arg.native();
       }
 
+      void apply_add(EigenVectorStorage<N>& result,
+                     N alpha,
+                     const EigenVectorStorage<N>& arg,
+                     N beta) override
+      {
+        if (beta == N(0)) {
+          result.native().noalias() = alpha * (m_mat * arg.native());
+          return;
+        }
+
+        if (beta != N(1))
+          result.native() *= beta;
+        result.native().noalias() += alpha * (m_mat * arg.native());
+      }
+
+      void apply_transpose(EigenVectorStorage<N>& result,
+                           const EigenVectorStorage<N>& arg) override
+      {
+        result.native().noalias() = m_mat.transpose() * arg.native();
+      }
+
+      void apply_block(MultiVector<N, Eigen::RowMajor>& result,
+                       const MultiVector<N, Eigen::RowMajor>& arg) override
+      {
+        this->check_block_sizes(result, arg);
+        result.native().noalias() = m_mat * arg.native();
+      }
+
+      /**
+       Gathers the arguments into a dense block, such that the matrix is
+       traversed only once for all vectors.
+       */
+      void apply_multi(const std::vector<EigenVectorStorage<N>*>& results,
+                       const std::vector<const EigenVectorStorage<N>*>& args) override
+      {
+        if (results.size() != args.size()) {
+          throw std::invalid_argument("The number of results does not match the number of arguments.");
+        }
+
+        using Block = Eigen::Matrix<N, Eigen::Dynamic, Eigen::Dynamic>;
+        Block x(m_mat.cols(), args.size());
+        for (size_t i = 0; i < args.size(); ++i) {
+          x.col(i) = args[i]->native();
+        }
+
+        Block y = m_mat * x;
+        for (size_t i = 0; i < results.size(); ++i) {
+          results[i]->native() = y.col(i);
+        }
+      }
+
+      const NativeMatrix& native() const { return m_mat; }
+
     private:
-      Eigen::SparseMatrix<N> m_mat;
+      NativeMatrix m_mat;
   };
+
+  /** @brief An EigenSparseMatrixStorage with row-major storage. */
+  template <typename N>
+  using EigenRowMajorSparseMatrixStorage
+    = EigenSparseMatrixStorage<N, Eigen::RowMajor>;
 }
 
 #endif
@@ -0,0 +1,175 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_ENTRY_EXCHANGE_HPP
+#define ALLIUM_LA_ENTRY_EXCHANGE_HPP
+
+#include "local_coo_matrix.hpp"
+#include "local_csr_matrix.hpp"
+#include "vector_spec.hpp"
+#include <algorithm>
+#include <stdexcept>
+
+namespace allium {
+
+  /// @cond INTERNAL
+  namespace detail {
+    const int entry_index_tag = 7102;
+    const int entry_value_tag = 7103;
+
+    /**
+     Sends the entries of rows, which are owned by other ranks, to their
+     owners and returns the remaining entries followed by the received
+     ones. Entries at the same position are not summed.
+
+     The counts are exchanged by one all-to-all, the entries by
+     non-blocking point-to-point messages between the ranks that actually
+     exchange entries. Must be called by all ranks of the communicator. If
+     any rank provides an entry outside of the rows, all ranks throw
+     std::out_of_range.
+     */
+    template <typename N>
+    LocalCooMatrix<N> send_remote_entries(VectorSpec rows,
+                                          LocalCooMatrix<N> entries)
+    {
+      Comm comm = rows.comm();
+      const int ranks = comm.size();
+      const global_size_t row_start = rows.local_start();
+      const global_size_t row_end = rows.local_end();
+      const global_size_t global_rows = rows.global_size();
+
+      if (ranks == 1) {
+        return entries;
+      }
+
+      // All ranks have to agree on an invalid entry before throwing, since
+      // the others would wait in the exchange below otherwise.
+      int invalid = 0;
+      for (auto row : entries.row_ind()) {
+        if (row >= global_rows) {
+          invalid = 1;
+          break;
+        }
+      }
+      if (comm.sum_allreduce(invalid) > 0) {
+        throw std::out_of_range("Matrix entry is out of the row range.");
+      }
+
+      auto row_starts = comm.allgather(row_start);
+
+      // stash the entries of the other ranks, sorted by their owner
+      std::vector<int> owners;
+      std::vector<int> send_counts(ranks, 0);
+      for (auto row : entries.row_ind()) {
+        if (row < row_start || row >= row_end) {
+          int owner = std::upper_bound(row_starts.begin(), row_starts.end(), row)
+                      - row_starts.begin() - 1;
+          owners.push_back(owner);
+          ++send_counts[owner];
+        }
+      }
+
+      std::vector<size_t> send_offsets(ranks + 1, 0);
+      for (int i_rank = 0; i_rank < ranks; ++i_rank) {
+        send_offsets[i_rank+1] = send_offsets[i_rank] + send_counts[i_rank];
+      }
+
+      std::vector<global_size_t> send_indices(2 * owners.size());
+      std::vector<N> send_values(owners.size());
+      LocalCooMatrix<N> local;
+      if (!owners.empty()) {
+        std::vector<size_t> position(send_offsets.begin(), send_offsets.end() - 1);
+        local.reserve(entries.entry_count() - owners.size());
+
+        size_t i_remote = 0;
+        for (auto e : entries.entries()) {
+          if (e.row() < row_start || e.row() >= row_end) {
+            size_t pos = position[owners[i_remote++]]++;
+            send_indices[2*pos] = e.row();
+            send_indices[2*pos+1] = e.col();
+            send_values[pos] = e.value();
+          } else {
+            local.add(e.row(), e.col(), e.value());
+          }
+        }
+      } else {
+        local = std::move(entries);
+      }
+
+      auto recv_counts = comm.alltoall(send_counts);
+
+      std::vector<size_t> recv_offsets(ranks + 1, 0);
+      for (int i_rank = 0; i_rank < ranks; ++i_rank) {
+        recv_offsets[i_rank+1] = recv_offsets[i_rank] + recv_counts[i_rank];
+      }
+
+      std::vector<global_size_t> recv_indices(2 * recv_offsets.back());
+      std::vector<N> recv_values(recv_offsets.back());
+      std::vector<MPI_Request> requests;
+      for (int i_rank = 0; i_rank < ranks; ++i_rank) {
+        if (recv_counts[i_rank] > 0) {
+          requests.push_back(
+            comm.irecv(recv_indices.data() + 2 * recv_offsets[i_rank],
+                       2 * recv_counts[i_rank], i_rank, entry_index_tag));
+          requests.push_back(
+            comm.irecv(recv_values.data() + recv_offsets[i_rank],
+                       recv_counts[i_rank], i_rank, entry_value_tag));
+        }
+        if (send_counts[i_rank] > 0) {
+          requests.push_back(
+            comm.isend(send_indices.data() + 2 * send_offsets[i_rank],
+                       2 * send_counts[i_rank], i_rank, entry_index_tag));
+          requests.push_back(
+            comm.isend(send_values.data() + send_offsets[i_rank],
+                       send_counts[i_rank], i_rank, entry_value_tag));
+        }
+      }
+      Comm::wait_all(requests);
+
+      local.reserve(local.entry_count() + recv_values.size());
+      for (size_t i = 0; i < recv_values.size(); ++i) {
+        local.add(recv_indices[2*i], recv_indices[2*i+1], recv_values[i]);
+      }
+      return local;
+    }
+  }
+  /// @endcond
+
+  /**
+   @brief Moves the given entries to the ranks owning their rows.
+
+   Every rank may provide entries of any row, e.g., the contributions of
+   its finite elements to the rows of neighboring ranks. The entries of
+   other ranks are stashed and sent to their owner in one sparse
+   all-to-all exchange. The result contains the entries of the local rows,
+   row by row, where all contributions to the same position are summed.
+
+   This is a collective operation.
+
+   @param [in] rows The distribution of the rows.
+   @param [in] cols The number of columns.
+   @param [in] entries The entries provided by this rank.
+   */
+  template <typename N>
+  LocalCooMatrix<N> exchange_entries(VectorSpec rows,
+                                     global_size_t cols,
+                                     LocalCooMatrix<N> entries)
+  {
+    auto owned = detail::send_remote_entries(rows, std::move(entries));
+    return LocalCsrMatrix<N>(rows.local_size(), cols, owned, rows.local_start())
+             .to_coo(rows.local_start());
+  }
+}
+
+#endif
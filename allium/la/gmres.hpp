@@ -28,7 +28,9 @@ namespace allium {
 
     @ingroup linear_solver
 
-    This class should be used using the GmresSolver type.
+    This class should be used using the GmresSolver type. If a
+    preconditioner is set, right preconditioning is used, i.e., the residual
+    that is minimized is the residual of the original system.
 
     Saad, Youcef, and Martin H. Schultz. 1986. "GMRES: A Generalized Minimal
     Residual Algorithm for Solving Nonsymmetric Linear Systems."
@@ -18,6 +18,7 @@
 #include "gmres.hpp"
 
 #include "local_vector.hpp"
+#include <allium/util/numeric.hpp>
 
 #include <vector>
 
@@ -74,15 +75,6 @@ namespace allium {
   template <> inline void givens(double& c, double& s, double a, double b)
   { return real_givens<double>(c, s, a, b); }
 
-  template <typename N>
-  N conj(N z) {
-    return std::conj(z);
-  }
-  template <>
-  double inline conj(double z) { return z; }
-  template <>
-  float inline conj(float z) { return z; }
-
   /** Overrides u by the vector obtained by applying a rotation in the i1-i2
    * plane to the vector u.
    *
@@ -203,19 +195,16 @@ namespace allium {
                                  const VectorStorage<N>& rhs,
                                  InitialGuess initial_guess)
   {
-    auto tmp1 = allocate_like(rhs);
-
     m_max_krylov_size = 30;
 
-    if (initial_guess == InitialGuess::NOT_PROVIDED) {
-      set_zero(x);
-    }
-
     // residual = rhs - mat * x
     auto residual = allocate_like(rhs);
     residual->assign(rhs);
-    this->apply_matrix(*tmp1, x);
-    residual->add_scaled(-1.0, *tmp1);
+    if (initial_guess == InitialGuess::NOT_PROVIDED) {
+      set_zero(x);
+    } else {
+      this->apply_matrix_add(*residual, -1.0, x, 1.0);
+    }
     auto residual_norm = residual->l2_norm();
 
     Real abs_tol = tolerance() * rhs.l2_norm();
@@ -231,8 +220,7 @@ namespace allium {
 
       // residual = rhs - mat * x
       residual->assign(rhs);
-      this->apply_matrix(*tmp1, x);
-      residual->add_scaled(-1.0, *tmp1);
+      this->apply_matrix_add(*residual, -1.0, x, 1.0);
       residual_norm = residual->l2_norm();
     }
   }
@@ -259,6 +247,10 @@ namespace allium {
 
     HessenbergQr<N> qr(beta);
 
+    // With right preconditioning, the Krylov space of A M^{-1} is built.
+    auto z = allocate_like(residual);
+    bool preconditioned = false;
+
     for (size_t i_iteration = 0;
          i_iteration < m_max_krylov_size && !success;
          ++i_iteration)
@@ -266,7 +258,10 @@ namespace allium {
       m_iteration_count++;
 
       auto v_hat = allocate_like(residual);
-      this->apply_matrix(*v_hat, *krylov_base.at(i_iteration));
+      preconditioned
+        = this->apply_preconditioner(*z, *krylov_base.at(i_iteration));
+      this->apply_matrix(*v_hat,
+                         preconditioned ? *z : *krylov_base.at(i_iteration));
 
       // current column of the Hessenberg matrix
       LocalVector<N> hessenberg_column(i_iteration + 2);
@@ -301,8 +296,19 @@ namespace allium {
     // compute linear combination of basis vectors to approximate the
     // solution of the LGS
     assert(y.rows() == krylov_base.size() - 1);
-    for (size_t i_base = 0; i_base < y.rows(); ++i_base) {
-      x.add_scaled(y[i_base], *krylov_base[i_base]);
+    if (preconditioned) {
+      // x = x + M^{-1} (sum of y_i v_i)
+      auto update = allocate_like(residual);
+      set_zero(*update);
+      for (size_t i_base = 0; i_base < y.rows(); ++i_base) {
+        update->add_scaled(y[i_base], *krylov_base[i_base]);
+      }
+      this->apply_preconditioner(*z, *update);
+      x += *z;
+    } else {
+      for (size_t i_base = 0; i_base < y.rows(); ++i_base) {
+        x.add_scaled(y[i_base], *krylov_base[i_base]);
+      }
     }
 
     return success;
@@ -0,0 +1,509 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_INCOMPLETE_FACTORIZATION_HPP
+#define ALLIUM_LA_INCOMPLETE_FACTORIZATION_HPP
+
+#include "sparse_matrix.hpp"
+#include "linear_operator.hpp"
+#include "local_csr_matrix.hpp"
+#include "local_csr_product.hpp"
+#include <allium/util/memory.hpp>
+#include <allium/util/numeric.hpp>
+#include <allium/util/parallel.hpp>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+
+namespace allium {
+
+  /// @cond INTERNAL
+  namespace detail {
+    /**
+     The entries of the locally owned rows and columns of a square matrix.
+     The column indices are local.
+     */
+    template <typename V>
+    LocalCsrMatrix<typename V::Number>
+    local_diagonal_block(SparseMatrixStorage<V>& mat)
+    {
+      using Number = typename V::Number;
+
+      auto spec = mat.row_spec();
+      if (spec != mat.col_spec()) {
+        throw std::logic_error("The matrix must be square.");
+      }
+      size_t local_size = spec.local_size();
+      global_size_t local_start = spec.local_start();
+
+      auto entries = mat.get_entries();
+      LocalCooMatrix<Number> block;
+      block.reserve(entries.entry_count());
+      for (auto e : entries.entries()) {
+        if (e.col() >= local_start && e.col() - local_start < local_size) {
+          block.add(e.row() - local_start, e.col() - local_start, e.value());
+        }
+      }
+
+      return LocalCsrMatrix<Number>(local_size, local_size, block);
+    }
+
+    /** The position of the diagonal entry of every row. */
+    template <typename N>
+    std::vector<size_t> diagonal_positions(const LocalCsrMatrix<N>& mat)
+    {
+      std::vector<size_t> result(mat.rows());
+      for (size_t i_row = 0; i_row < mat.rows(); ++i_row) {
+        auto begin = mat.col_ind().begin() + mat.row_ptr()[i_row];
+        auto end = mat.col_ind().begin() + mat.row_ptr()[i_row+1];
+        auto it = std::lower_bound(begin, end, i_row);
+        if (it == end || *it != i_row) {
+          throw std::runtime_error("Missing diagonal entry.");
+        }
+        result[i_row] = it - mat.col_ind().begin();
+      }
+      return result;
+    }
+
+    /**
+     The lower (`lower == true`) or upper triangular part of the matrix,
+     optionally including the diagonal.
+     */
+    template <typename N>
+    LocalCsrMatrix<N> triangular_part(const LocalCsrMatrix<N>& mat,
+                                      bool lower,
+                                      bool with_diagonal)
+    {
+      aligned_vector<size_t> row_ptr(mat.rows() + 1);
+      aligned_vector<global_size_t> col_ind;
+      aligned_vector<N> values;
+
+      row_ptr[0] = 0;
+      for (size_t i_row = 0; i_row < mat.rows(); ++i_row) {
+        for (size_t i_entry = mat.row_ptr()[i_row];
+             i_entry < mat.row_ptr()[i_row+1];
+             ++i_entry)
+        {
+          global_size_t col = mat.col_ind()[i_entry];
+          if ((lower ? col < i_row : col > i_row)
+              || (with_diagonal && col == i_row)) {
+            col_ind.push_back(col);
+            values.push_back(mat.values()[i_entry]);
+          }
+        }
+        row_ptr[i_row+1] = col_ind.size();
+      }
+
+      return LocalCsrMatrix<N>(mat.cols(),
+                               std::move(row_ptr),
+                               std::move(col_ind),
+                               std::move(values));
+    }
+
+    /**
+     Groups the rows of a triangular matrix into levels, such that the rows
+     of a level only depend on the rows of the previous levels. The rows of
+     a level can be processed in parallel.
+     */
+    class LevelSchedule {
+      public:
+        LevelSchedule() {}
+
+        /**
+         For a lower triangular matrix, row `i` depends on the rows `j < i`
+         with an entry `(i, j)`, for an upper triangular matrix on the rows
+         `j > i`.
+         */
+        template <typename N>
+        LevelSchedule(const LocalCsrMatrix<N>& mat, bool lower)
+        {
+          const size_t rows = mat.rows();
+          const auto& row_ptr = mat.row_ptr();
+          const auto& col_ind = mat.col_ind();
+
+          std::vector<size_t> level(rows, 0);
+          size_t level_count = rows > 0 ? 1 : 0;
+          for (size_t i = 0; i < rows; ++i) {
+            size_t i_row = lower ? i : rows - 1 - i;
+            for (size_t i_entry = row_ptr[i_row];
+                 i_entry < row_ptr[i_row+1];
+                 ++i_entry)
+            {
+              global_size_t col = col_ind[i_entry];
+              if (lower ? col < i_row : col > i_row) {
+                level[i_row] = std::max(level[i_row], level[col] + 1);
+              }
+            }
+            level_count = std::max(level_count, level[i_row] + 1);
+          }
+
+          // counting sort, the rows of a level remain in ascending order
+          m_level_ptr.assign(level_count + 1, 0);
+          for (size_t i_row = 0; i_row < rows; ++i_row) {
+            ++m_level_ptr[level[i_row] + 1];
+          }
+          for (size_t i_level = 0; i_level < level_count; ++i_level) {
+            m_level_ptr[i_level+1] += m_level_ptr[i_level];
+          }
+          m_rows.resize(rows);
+          std::vector<size_t> next(m_level_ptr.begin(), m_level_ptr.end() - 1);
+          for (size_t i_row = 0; i_row < rows; ++i_row) {
+            m_rows[next[level[i_row]]++] = i_row;
+          }
+        }
+
+        size_t level_count() const {
+          return m_level_ptr.empty() ? 0 : m_level_ptr.size() - 1;
+        }
+
+        /** The rows of level `i` are `rows()[level_ptr()[i]]`, ... */
+        const std::vector<size_t>& level_ptr() const { return m_level_ptr; }
+        const std::vector<size_t>& rows() const { return m_rows; }
+
+      private:
+        std::vector<size_t> m_level_ptr;
+        std::vector<size_t> m_rows;
+    };
+
+    /**
+     Solves `(D + T) y = x` in place, where `T` is strictly triangular and
+     `D` is diagonal. The rows are processed level by level, the rows of
+     each level in parallel.
+     */
+    template <typename N>
+    class TriangularSolve {
+      public:
+        TriangularSolve() {}
+
+        /**
+         @param [in] mat The strictly triangular part `T`.
+         @param [in] inv_diag The inverse of `D`, empty for the identity.
+         */
+        TriangularSolve(const LocalCsrMatrix<N>& mat,
+                        aligned_vector<N> inv_diag,
+                        bool lower)
+          : m_schedule(mat, lower),
+            m_inv_diag(std::move(inv_diag))
+        {
+          // store the rows in the order of the schedule
+          const auto& order = m_schedule.rows();
+          m_row_ptr.resize(order.size() + 1);
+          m_row_ptr[0] = 0;
+          for (size_t i = 0; i < order.size(); ++i) {
+            m_row_ptr[i+1] = m_row_ptr[i] + mat.row_ptr()[order[i]+1]
+                                          - mat.row_ptr()[order[i]];
+          }
+
+          m_col_ind.resize(mat.nnz());
+          m_values.resize(mat.nnz());
+          for (size_t i = 0; i < order.size(); ++i) {
+            std::copy(mat.col_ind().begin() + mat.row_ptr()[order[i]],
+                      mat.col_ind().begin() + mat.row_ptr()[order[i]+1],
+                      m_col_ind.begin() + m_row_ptr[i]);
+            std::copy(mat.values().begin() + mat.row_ptr()[order[i]],
+                      mat.values().begin() + mat.row_ptr()[order[i]+1],
+                      m_values.begin() + m_row_ptr[i]);
+          }
+        }
+
+        size_t level_count() const { return m_schedule.level_count(); }
+
+        void solve(N* x) const {
+          const size_t level_count = m_schedule.level_count();
+          const size_t* level_ptr = m_schedule.level_ptr().data();
+          const size_t* rows = m_schedule.rows().data();
+          const size_t* row_ptr = m_row_ptr.data();
+          const global_size_t* col_ind = m_col_ind.data();
+          const N* values = m_values.data();
+          const N* inv_diag = m_inv_diag.empty() ? nullptr : m_inv_diag.data();
+
+          #ifdef ALLIUM_USE_OPENMP
+          #pragma omp parallel num_threads(max_threads())
+          #endif
+          for (size_t i_level = 0; i_level < level_count; ++i_level) {
+            // the implicit barrier separates the levels
+            #ifdef ALLIUM_USE_OPENMP
+            #pragma omp for schedule(static)
+            #endif
+            for (size_t i = level_ptr[i_level]; i < level_ptr[i_level+1]; ++i) {
+              size_t row = rows[i];
+              N sum = x[row];
+              for (size_t i_entry = row_ptr[i]; i_entry < row_ptr[i+1]; ++i_entry) {
+                sum -= values[i_entry] * x[col_ind[i_entry]];
+              }
+              x[row] = inv_diag ? sum * inv_diag[row] : sum;
+            }
+          }
+        }
+
+      private:
+        LevelSchedule m_schedule;
+        aligned_vector<N> m_inv_diag;
+        aligned_vector<size_t> m_row_ptr;
+        aligned_vector<global_size_t> m_col_ind;
+        aligned_vector<N> m_values;
+    };
+  }
+  /// @endcond
+
+  /**
+   @brief Incomplete LU factorization without fill-in, ILU(0).
+
+   Computes `L U ≈ A`, where `L` and `U` have the sparsity pattern of the
+   lower and upper triangular part of `A`. As for the
+   BlockJacobiPreconditioner, only the locally owned rows and columns are
+   factorized.
+
+   The triangular solves of the application are level scheduled: the rows
+   are grouped into levels, which only depend on the previous levels, and
+   the rows of each level are processed in parallel. The levels are
+   computed once, together with the factorization. The factorization
+   itself uses the same levels.
+
+   @ingroup linear_solver
+   */
+  template <typename V>
+  class IluPreconditioner final : public LinearOperator<V> {
+    public:
+      using typename LinearOperator<V>::Vector;
+      using typename LinearOperator<V>::Number;
+      using typename LinearOperator<V>::Real;
+
+      explicit IluPreconditioner(SparseMatrixStorage<V>& mat);
+
+      void apply(Vector& result, const Vector& arg) override;
+
+      /** The number of levels of the forward and the backward solve. */
+      size_t lower_level_count() const { return m_lower.level_count(); }
+      size_t upper_level_count() const { return m_upper.level_count(); }
+
+    private:
+      detail::TriangularSolve<Number> m_lower;
+      detail::TriangularSolve<Number> m_upper;
+  };
+
+  template <typename V>
+  IluPreconditioner<V>::IluPreconditioner(SparseMatrixStorage<V>& mat)
+  {
+    auto lu = detail::local_diagonal_block(mat);
+    const size_t rows = lu.rows();
+    const size_t* row_ptr = lu.row_ptr().data();
+    const global_size_t* col_ind = lu.col_ind().data();
+    Number* values = lu.values().data();
+
+    auto diag = detail::diagonal_positions(lu);
+    detail::LevelSchedule schedule(lu, true);
+    const size_t* level_ptr = schedule.level_ptr().data();
+    const size_t* level_rows = schedule.rows().data();
+    const size_t none = std::numeric_limits<size_t>::max();
+    bool zero_pivot = false;
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel num_threads(max_threads()) reduction(||:zero_pivot)
+    #endif
+    {
+      // the position of every column in the current row
+      std::vector<size_t> position(rows, none);
+
+      for (size_t i_level = 0; i_level < schedule.level_count(); ++i_level) {
+        #ifdef ALLIUM_USE_OPENMP
+        #pragma omp for schedule(dynamic, 64)
+        #endif
+        for (size_t i = level_ptr[i_level]; i < level_ptr[i_level+1]; ++i) {
+          size_t i_row = level_rows[i];
+          for (size_t p = row_ptr[i_row]; p < row_ptr[i_row+1]; ++p) {
+            position[col_ind[p]] = p;
+          }
+
+          // eliminate the entries left of the diagonal
+          for (size_t p = row_ptr[i_row]; p < diag[i_row]; ++p) {
+            size_t k = col_ind[p];
+            if (values[diag[k]] == Number(0)) {
+              zero_pivot = true;
+              continue;
+            }
+            values[p] /= values[diag[k]];
+            for (size_t q = diag[k] + 1; q < row_ptr[k+1]; ++q) {
+              size_t pos = position[col_ind[q]];
+              if (pos != none)
+                values[pos] -= values[p] * values[q];
+            }
+          }
+
+          if (values[diag[i_row]] == Number(0))
+            zero_pivot = true;
+
+          for (size_t p = row_ptr[i_row]; p < row_ptr[i_row+1]; ++p) {
+            position[col_ind[p]] = none;
+          }
+        }
+      }
+    }
+
+    if (zero_pivot) {
+      throw std::runtime_error("Zero pivot in the incomplete factorization.");
+    }
+
+    aligned_vector<Number> inv_diag(rows);
+    for (size_t i_row = 0; i_row < rows; ++i_row) {
+      inv_diag[i_row] = Number(1) / values[diag[i_row]];
+    }
+
+    // L has a unit diagonal
+    m_lower = detail::TriangularSolve<Number>(
+                detail::triangular_part(lu, true, false), {}, true);
+    m_upper = detail::TriangularSolve<Number>(
+                detail::triangular_part(lu, false, false),
+                std::move(inv_diag),
+                false);
+  }
+
+  template <typename V>
+  void IluPreconditioner<V>::apply(Vector& result, const Vector& arg)
+  {
+    auto y_slice = local_slice(result);
+    auto x_slice = local_slice(arg);
+    Number* y = y_slice.data();
+    std::copy(x_slice.data(), x_slice.data() + x_slice.size(), y);
+
+    m_lower.solve(y);
+    m_upper.solve(y);
+  }
+
+  /**
+   @brief Incomplete Cholesky factorization without fill-in, IC(0).
+
+   Computes `L L^H ≈ A` for a Hermitian positive definite matrix `A`, where
+   `L` has the sparsity pattern of the lower triangular part of `A`. Only
+   the lower triangular part of `A` is used. The factorization and the
+   triangular solves are level scheduled, see IluPreconditioner.
+
+   @ingroup linear_solver
+   */
+  template <typename V>
+  class IcPreconditioner final : public LinearOperator<V> {
+    public:
+      using typename LinearOperator<V>::Vector;
+      using typename LinearOperator<V>::Number;
+      using typename LinearOperator<V>::Real;
+
+      explicit IcPreconditioner(SparseMatrixStorage<V>& mat);
+
+      void apply(Vector& result, const Vector& arg) override;
+
+      size_t level_count() const { return m_lower.level_count(); }
+
+    private:
+      detail::TriangularSolve<Number> m_lower;
+      detail::TriangularSolve<Number> m_upper;
+  };
+
+  template <typename V>
+  IcPreconditioner<V>::IcPreconditioner(SparseMatrixStorage<V>& mat)
+  {
+    auto block = detail::local_diagonal_block(mat);
+    const size_t rows = block.rows();
+
+    auto l = detail::triangular_part(block, true, true);
+
+    const size_t* row_ptr = l.row_ptr().data();
+    const global_size_t* col_ind = l.col_ind().data();
+    Number* values = l.values().data();
+
+    auto diag = detail::diagonal_positions(l);
+    detail::LevelSchedule schedule(l, true);
+    const size_t* level_ptr = schedule.level_ptr().data();
+    const size_t* level_rows = schedule.rows().data();
+    const size_t none = std::numeric_limits<size_t>::max();
+    bool not_positive = false;
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel num_threads(max_threads()) reduction(||:not_positive)
+    #endif
+    {
+      std::vector<size_t> position(rows, none);
+
+      for (size_t i_level = 0; i_level < schedule.level_count(); ++i_level) {
+        #ifdef ALLIUM_USE_OPENMP
+        #pragma omp for schedule(dynamic, 64)
+        #endif
+        for (size_t i = level_ptr[i_level]; i < level_ptr[i_level+1]; ++i) {
+          size_t i_row = level_rows[i];
+          for (size_t p = row_ptr[i_row]; p < diag[i_row]; ++p) {
+            position[col_ind[p]] = p;
+          }
+
+          // l_ik = (a_ik - sum_{j<k} l_ij conj(l_kj)) / l_kk
+          Real diag_value = std::real(values[diag[i_row]]);
+          for (size_t p = row_ptr[i_row]; p < diag[i_row]; ++p) {
+            size_t k = col_ind[p];
+            Number sum = values[p];
+            for (size_t q = row_ptr[k]; q < diag[k]; ++q) {
+              size_t pos = position[col_ind[q]];
+              if (pos != none)
+                sum -= values[pos] * conj(values[q]);
+            }
+            values[p] = sum / values[diag[k]];
+            diag_value -= std::norm(values[p]);
+          }
+
+          if (!(diag_value > 0)) {
+            not_positive = true;
+            diag_value = 1;
+          }
+          values[diag[i_row]] = std::sqrt(diag_value);
+
+          for (size_t p = row_ptr[i_row]; p < diag[i_row]; ++p) {
+            position[col_ind[p]] = none;
+          }
+        }
+      }
+    }
+
+    if (not_positive) {
+      throw std::runtime_error("The matrix is not positive definite.");
+    }
+
+    aligned_vector<Number> inv_diag(rows);
+    for (size_t i_row = 0; i_row < rows; ++i_row) {
+      inv_diag[i_row] = Number(1) / values[diag[i_row]];
+    }
+
+    // the rows of L^H are the conjugated columns of L
+    auto strict_lower = detail::triangular_part(l, true, false);
+    LocalCsrTranspose<Number> transpose(strict_lower);
+    auto strict_upper = transpose.result();
+    for (auto& value : strict_upper.values()) {
+      value = conj(value);
+    }
+
+    m_lower = detail::TriangularSolve<Number>(strict_lower, inv_diag, true);
+    m_upper = detail::TriangularSolve<Number>(strict_upper,
+                                              std::move(inv_diag), false);
+  }
+
+  template <typename V>
+  void IcPreconditioner<V>::apply(Vector& result, const Vector& arg)
+  {
+    auto y_slice = local_slice(result);
+    auto x_slice = local_slice(arg);
+    Number* y = y_slice.data();
+    std::copy(x_slice.data(), x_slice.data() + x_slice.size(), y);
+
+    m_lower.solve(y);
+    m_upper.solve(y);
+  }
+}
+
+#endif
@@ -38,6 +38,21 @@ namespace allium {
     protected:
       virtual void apply_matrix(VectorStorage<Number>& out, const VectorStorage<Number>& in) = 0;
 
+      /** Computes `out = alpha A in + beta out`. */
+      virtual void apply_matrix_add(VectorStorage<Number>& out,
+                                    Number alpha,
+                                    const VectorStorage<Number>& in,
+                                    Number beta) = 0;
+
+      /**
+       Applies the preconditioner. Returns false, without modifying `out`,
+       if no preconditioner is set.
+       */
+      virtual bool apply_preconditioner(VectorStorage<Number>& /* out */,
+                                        const VectorStorage<Number>& /* in */) {
+        return false;
+      }
+
     private:
       real_part_t<N> m_tol;
   };
@@ -60,6 +75,12 @@ namespace allium {
         m_mat = mat;
       }
 
+      /** Sets the preconditioner, which approximates the inverse of the
+          matrix. Passing nullptr removes the preconditioner. */
+      void preconditioner(std::shared_ptr<Matrix> pc) {
+        m_pc = pc;
+      }
+
       void solve(V& solution,
                  const V& rhs,
                  InitialGuess initial_guess = InitialGuess::NOT_PROVIDED) override {
@@ -68,6 +89,7 @@ namespace allium {
 
     private:
       std::shared_ptr<Matrix> m_mat;
+      std::shared_ptr<Matrix> m_pc;
 
       void apply_matrix(VectorStorage<Number>& out, const VectorStorage<Number>& in) override
       {
@@ -79,6 +101,30 @@ namespace allium {
         m_mat->apply(static_cast<V&>(out),
                      static_cast<const V&>(in));
       }
+
+      void apply_matrix_add(VectorStorage<Number>& out,
+                            Number alpha,
+                            const VectorStorage<Number>& in,
+                            Number beta) override
+      {
+        ALLIUM_NO_NONNULL_WARNING
+        allium_assert(dynamic_cast<const V*>(&in) != nullptr);
+        allium_assert(dynamic_cast<V*>(&out) != nullptr);
+        ALLIUM_RESTORE_WARNING
+
+        m_mat->apply_add(static_cast<V&>(out), alpha,
+                         static_cast<const V&>(in), beta);
+      }
+
+      bool apply_preconditioner(VectorStorage<Number>& out, const VectorStorage<Number>& in) override
+      {
+        if (!m_pc)
+          return false;
+
+        m_pc->apply(static_cast<V&>(out),
+                    static_cast<const V&>(in));
+        return true;
+      }
   };
 
 };
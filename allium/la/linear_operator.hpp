@@ -15,7 +15,11 @@
 #ifndef ALLIUM_LA_LINEAR_OPERATOR_HPP
 #define ALLIUM_LA_LINEAR_OPERATOR_HPP
 
+#include "vector_storage.hpp"
+#include <allium/util/except.hpp>
 #include <memory>
+#include <stdexcept>
+#include <vector>
 
 namespace allium {
   /// @addtogroup linear_solver
@@ -36,8 +40,72 @@ namespace allium {
 
       virtual void apply(Vector& result,
                          const Vector& arg) = 0;
+
+      /**
+       Computes `result = alpha A arg + beta result`. If `beta` is zero,
+       the previous content of `result` is not read.
+
+       The default implementation applies the operator into a temporary
+       vector. Operators that can accumulate into the result directly should
+       override it.
+       */
+      virtual void apply_add(Vector& result,
+                             Number alpha,
+                             const Vector& arg,
+                             Number beta);
+
+      /**
+       Computes `result = A^T arg`, the product with the transposed (not
+       conjugated) operator. The default implementation throws
+       not_implemented, since it cannot be derived from apply.
+       */
+      virtual void apply_transpose(Vector& /* result */, const Vector& /* arg */) {
+        throw not_implemented();
+      }
+
+      /**
+       Computes `*results[i] = A *args[i]` for a block of vectors. The
+       default implementation applies the operator to each vector
+       separately. Operators that can apply themselves to several vectors
+       at once, loading their data only once, should override it.
+       */
+      virtual void apply_multi(const std::vector<Vector*>& results,
+                               const std::vector<const Vector*>& args);
   };
 
+  template <typename V>
+  void LinearOperator<V>::apply_add(Vector& result,
+                                    Number alpha,
+                                    const Vector& arg,
+                                    Number beta)
+  {
+    if (beta == Number(0)) {
+      apply(result, arg);
+      if (alpha != Number(1))
+        result *= alpha;
+      return;
+    }
+
+    auto tmp = allocate_like(result);
+    apply(*tmp, arg);
+    if (beta != Number(1))
+      result *= beta;
+    result.add_scaled(alpha, *tmp);
+  }
+
+  template <typename V>
+  void LinearOperator<V>::apply_multi(const std::vector<Vector*>& results,
+                                      const std::vector<const Vector*>& args)
+  {
+    if (results.size() != args.size()) {
+      throw std::invalid_argument("The number of results does not match the number of arguments.");
+    }
+
+    for (size_t i = 0; i < args.size(); ++i) {
+      apply(*results[i], *args[i]);
+    }
+  }
+
   /**
     @brief Wraps a functor into a linear operator.
   */
@@ -16,6 +16,7 @@
 #define ALLIUM_LA_LOCAL_COO_MATRIX_HPP
 
 #include <allium/util/types.hpp>
+#include <iterator>
 #include <vector>
 
 namespace allium {
@@ -34,36 +35,139 @@ namespace allium {
         return (m_row == rhs.m_row && m_col == rhs.m_col && m_value == rhs.m_value);
       }
 
-      global_size_t row() { return m_row; }
-      global_size_t col() { return m_col; }
-      N value() { return m_value; }
+      global_size_t row() const { return m_row; }
+      global_size_t col() const { return m_col; }
+      N value() const { return m_value; }
     private:
       global_size_t m_row, m_col;
       N m_value;
   };
 
+  /**
+   @brief Read-only view of the entries of a LocalCooMatrix.
+
+   The view does not copy the entries, it constructs each MatrixEntry when it
+   is accessed. Hence, the view is only valid as long as the matrix exists
+   and is not modified.
+   */
+  template <typename N>
+  class MatrixEntryRange {
+    public:
+      class iterator {
+        public:
+          using iterator_category = std::input_iterator_tag;
+          using value_type = MatrixEntry<N>;
+          using difference_type = std::ptrdiff_t;
+          using pointer = const MatrixEntry<N>*;
+          using reference = MatrixEntry<N>;
+
+          iterator(const MatrixEntryRange* range, size_t pos)
+            : m_range(range), m_pos(pos) {}
+
+          MatrixEntry<N> operator* () const { return (*m_range)[m_pos]; }
+
+          iterator& operator++ () { ++m_pos; return *this; }
+
+          bool operator== (const iterator& other) const { return m_pos == other.m_pos; }
+          bool operator!= (const iterator& other) const { return m_pos != other.m_pos; }
+        private:
+          const MatrixEntryRange* m_range;
+          size_t m_pos;
+      };
+      using const_iterator = iterator;
+
+      MatrixEntryRange(const global_size_t* rows,
+                       const global_size_t* cols,
+                       const N* values,
+                       size_t size)
+        : m_rows(rows), m_cols(cols), m_values(values), m_size(size) {}
+
+      size_t size() const { return m_size; }
+      bool empty() const { return m_size == 0; }
+
+      MatrixEntry<N> operator[] (size_t i) const {
+        return MatrixEntry<N>(m_rows[i], m_cols[i], m_values[i]);
+      }
+
+      iterator begin() const { return iterator(this, 0); }
+      iterator end() const { return iterator(this, m_size); }
+
+      /** True if both ranges contain the same entries in the same order. */
+      bool operator== (const MatrixEntryRange& other) const {
+        if (m_size != other.m_size)
+          return false;
+        for (size_t i = 0; i < m_size; ++i) {
+          if (m_rows[i] != other.m_rows[i]
+              || m_cols[i] != other.m_cols[i]
+              || m_values[i] != other.m_values[i]) {
+            return false;
+          }
+        }
+        return true;
+      }
+
+      bool operator!= (const MatrixEntryRange& other) const {
+        return !(*this == other);
+      }
+
+    private:
+      const global_size_t* m_rows;
+      const global_size_t* m_cols;
+      const N* m_values;
+      size_t m_size;
+  };
+
   /**
    @brief Local (non-distributed) matrix which stores the entries in coordinate format.
+
+   The row indices, the column indices and the values are stored in separate
+   arrays (structure of arrays), which can be accessed directly. Entries at
+   the same position are allowed, they are summed when the matrix is
+   assembled.
    */
   template <typename N>
   class LocalCooMatrix {
     public:
       LocalCooMatrix() {}
-      template <typename T>
-      explicit LocalCooMatrix(T&& entries)
-        : m_entries(std::forward<T>(entries))
-      {}
+
+      explicit LocalCooMatrix(const std::vector<MatrixEntry<N>>& entries) {
+        reserve(entries.size());
+        for (const auto& e : entries) {
+          add(e.row(), e.col(), e.value());
+        }
+      }
+
+      /** Reserves memory for the given number of entries. */
+      void reserve(size_t entry_count) {
+        m_rows.reserve(entry_count);
+        m_cols.reserve(entry_count);
+        m_values.reserve(entry_count);
+      }
 
       void add(global_size_t row, global_size_t col, N value) {
-        m_entries.push_back(MatrixEntry<N>(row, col, value));
+        m_rows.push_back(row);
+        m_cols.push_back(col);
+        m_values.push_back(value);
       }
 
-      size_t entry_count() { return m_entries.size(); }
+      size_t entry_count() const { return m_values.size(); }
+
+      const std::vector<global_size_t>& row_ind() const { return m_rows; }
+      const std::vector<global_size_t>& col_ind() const { return m_cols; }
+      const std::vector<N>& values() const { return m_values; }
+      std::vector<N>& values() { return m_values; }
 
-      const std::vector<MatrixEntry<N>> entries() const& { return m_entries; }
-      const std::vector<MatrixEntry<N>> entries() && { return std::move(m_entries); }
+      /** A view of the entries, which does not copy them. */
+      MatrixEntryRange<N> entries() const& {
+        return MatrixEntryRange<N>(m_rows.data(), m_cols.data(),
+                                   m_values.data(), m_values.size());
+      }
+      // the view would outlive the matrix
+      MatrixEntryRange<N> entries() && = delete;
     private:
-      std::vector<MatrixEntry<N>> m_entries;
+      std::vector<global_size_t> m_rows;
+      std::vector<global_size_t> m_cols;
+      std::vector<N> m_values;
   };
 
 
@@ -0,0 +1,550 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_LOCAL_CSR_MATRIX_HPP
+#define ALLIUM_LA_LOCAL_CSR_MATRIX_HPP
+
+#include "local_coo_matrix.hpp"
+#include <allium/config.hpp>
+#include <allium/util/memory.hpp>
+#include <allium/util/parallel.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+namespace allium {
+
+  /**
+   @brief Local (non-distributed) matrix which stores the entries in
+   compressed sparse row (CSR) format.
+
+   The entries of each row are sorted by column and every position is stored
+   at most once. The arrays are aligned to cache lines.
+   */
+  template <typename N>
+  class LocalCsrMatrix {
+    public:
+      using Number = N;
+
+      LocalCsrMatrix() : m_cols(0), m_row_ptr(1, 0) {}
+
+      LocalCsrMatrix(size_t rows, size_t cols)
+        : m_cols(cols), m_row_ptr(rows+1, 0) {}
+
+      /**
+       Creates the matrix from its CSR arrays. The column indices of every
+       row must be sorted and unique.
+       */
+      LocalCsrMatrix(size_t cols,
+                     aligned_vector<size_t> row_ptr,
+                     aligned_vector<global_size_t> col_ind,
+                     aligned_vector<N> values)
+        : m_cols(cols),
+          m_row_ptr(std::move(row_ptr)),
+          m_col_ind(std::move(col_ind)),
+          m_values(std::move(values))
+      {
+        if (m_row_ptr.empty()
+            || m_col_ind.size() != m_row_ptr.back()
+            || m_values.size() != m_row_ptr.back()) {
+          throw std::invalid_argument("Inconsistent CSR arrays.");
+        }
+      }
+
+      /**
+       Creates the matrix from entries in coordinate format. Entries at the
+       same position are summed in the order in which they were added.
+
+       The conversion is a parallel counting sort by row, followed by a sort
+       of every row by column.
+
+       @param [in] rows The number of rows.
+       @param [in] cols The number of columns.
+       @param [in] coo The entries.
+       @param [in] row_offset The row index of the entries, which is stored
+                   as the first row of this matrix. Hence, only entries with
+                   `row_offset <= row < row_offset + rows` are allowed.
+       */
+      LocalCsrMatrix(size_t rows,
+                     size_t cols,
+                     const LocalCooMatrix<N>& coo,
+                     global_size_t row_offset = 0);
+
+      size_t rows() const { return m_row_ptr.size() - 1; }
+      size_t cols() const { return m_cols; }
+      size_t nnz() const { return m_row_ptr.back(); }
+
+      /** Position of the first entry of each row, plus the entry count. */
+      const aligned_vector<size_t>& row_ptr() const { return m_row_ptr; }
+      const aligned_vector<global_size_t>& col_ind() const { return m_col_ind; }
+      const aligned_vector<N>& values() const { return m_values; }
+      aligned_vector<N>& values() { return m_values; }
+
+      /** The entries in coordinate format, row by row. */
+      LocalCooMatrix<N> to_coo(global_size_t row_offset = 0) const;
+
+    private:
+      size_t m_cols;
+      aligned_vector<size_t> m_row_ptr;
+      aligned_vector<global_size_t> m_col_ind;
+      aligned_vector<N> m_values;
+  };
+
+  /// @cond INTERNAL
+  namespace detail {
+    /**
+     Sorts the entries `[begin, end)` by column. The order of entries in the
+     same column is preserved, such that duplicates are summed in a
+     deterministic order.
+     */
+    template <typename N>
+    void sort_row(global_size_t* cols, N* values, size_t begin, size_t end)
+    {
+      if (end - begin <= 32) {
+        // insertion sort, short rows are the common case
+        for (size_t i = begin + 1; i < end; ++i) {
+          global_size_t col = cols[i];
+          N value = values[i];
+          size_t j = i;
+          while (j > begin && cols[j-1] > col) {
+            cols[j] = cols[j-1];
+            values[j] = values[j-1];
+            --j;
+          }
+          cols[j] = col;
+          values[j] = value;
+        }
+      } else {
+        std::vector<std::pair<global_size_t, N>> row(end - begin);
+        for (size_t i = begin; i < end; ++i) {
+          row[i - begin] = std::make_pair(cols[i], values[i]);
+        }
+        std::stable_sort(row.begin(), row.end(),
+                         [](const std::pair<global_size_t, N>& a,
+                            const std::pair<global_size_t, N>& b) {
+                           return a.first < b.first;
+                         });
+        for (size_t i = begin; i < end; ++i) {
+          cols[i] = row[i - begin].first;
+          values[i] = row[i - begin].second;
+        }
+      }
+    }
+  }
+  /// @endcond
+
+  template <typename N>
+  LocalCsrMatrix<N>::LocalCsrMatrix(size_t rows,
+                                    size_t cols,
+                                    const LocalCooMatrix<N>& coo,
+                                    global_size_t row_offset)
+    : m_cols(cols), m_row_ptr(rows+1, 0)
+  {
+    const global_size_t* row_ind = coo.row_ind().data();
+    const global_size_t* col_ind = coo.col_ind().data();
+    const N* values = coo.values().data();
+    const size_t n_entries = coo.entry_count();
+
+    // Every part counts the entries of its chunk per block of rows, where
+    // every part owns one contiguous block. Hence, the counters grow with the
+    // square of the parts, not with the rows. Small matrices are not worth
+    // the overhead of the parts.
+    const size_t min_entries_per_part = 16384;
+    int parts = static_cast<int>(
+                  std::max<size_t>(1,
+                    std::min<size_t>(max_threads(),
+                                     n_entries / min_entries_per_part)));
+
+    // block i_block holds the rows [block_begin(i_block), block_begin(i_block+1))
+    auto block_of = [&](size_t row) { return row * parts / rows; };
+    auto block_begin = [&](size_t i_block) {
+      return (i_block * rows + parts - 1) / parts;
+    };
+
+    std::vector<size_t> block_position(parts * parts, 0);
+    std::vector<int> error(parts, 0);
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel for schedule(static, 1) num_threads(parts)
+    #endif
+    for (int i_part = 0; i_part < parts; ++i_part) {
+      size_t* count = block_position.data() + i_part * parts;
+      size_t begin = n_entries * i_part / parts;
+      size_t end = n_entries * (i_part + 1) / parts;
+
+      for (size_t i_entry = begin; i_entry < end; ++i_entry) {
+        global_size_t row = row_ind[i_entry];
+        if (row < row_offset || row >= row_offset + rows) {
+          error[i_part] = 1;
+        } else if (col_ind[i_entry] >= cols) {
+          error[i_part] = 2;
+        } else {
+          ++count[block_of(row - row_offset)];
+        }
+      }
+    }
+
+    for (int e : error) {
+      if (e == 1)
+        throw std::out_of_range("Matrix entry is not in a local row.");
+      if (e == 2)
+        throw std::out_of_range("Matrix entry is out of the column range.");
+    }
+
+    // turn the counts into the position of the first entry of every part
+    // within every block
+    std::vector<size_t> block_start(parts + 1, 0);
+    for (int i_block = 0; i_block < parts; ++i_block) {
+      size_t next = block_start[i_block];
+      for (int i_part = 0; i_part < parts; ++i_part) {
+        size_t count = block_position[i_part * parts + i_block];
+        block_position[i_part * parts + i_block] = next;
+        next += count;
+      }
+      block_start[i_block+1] = next;
+    }
+
+    // Distribute the entries to the blocks, keeping their order. With a
+    // single part, the entries are read from the input directly.
+    std::vector<size_t> block_rows;
+    aligned_vector<global_size_t> block_cols;
+    aligned_vector<N> block_values;
+    if (parts > 1) {
+      block_rows.resize(n_entries);
+      block_cols.resize(n_entries);
+      block_values.resize(n_entries);
+
+      #ifdef ALLIUM_USE_OPENMP
+      #pragma omp parallel for schedule(static, 1) num_threads(parts)
+      #endif
+      for (int i_part = 0; i_part < parts; ++i_part) {
+        size_t* next = block_position.data() + i_part * parts;
+        size_t begin = n_entries * i_part / parts;
+        size_t end = n_entries * (i_part + 1) / parts;
+
+        for (size_t i_entry = begin; i_entry < end; ++i_entry) {
+          size_t row = row_ind[i_entry] - row_offset;
+          size_t pos = next[block_of(row)]++;
+          block_rows[pos] = row;
+          block_cols[pos] = col_ind[i_entry];
+          block_values[pos] = values[i_entry];
+        }
+      }
+    }
+
+    // sort the entries of every block into their rows, keeping their order
+    // within a row
+    aligned_vector<global_size_t> sorted_cols(n_entries);
+    aligned_vector<N> sorted_values(n_entries);
+    std::vector<size_t> next(rows);
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel for schedule(static, 1) num_threads(parts)
+    #endif
+    for (int i_block = 0; i_block < parts; ++i_block) {
+      size_t row_begin = block_begin(i_block);
+      size_t row_end = block_begin(i_block + 1);
+
+      for (size_t i_entry = block_start[i_block];
+           i_entry < block_start[i_block+1];
+           ++i_entry)
+      {
+        size_t row = parts > 1 ? block_rows[i_entry]
+                               : row_ind[i_entry] - row_offset;
+        ++m_row_ptr[row+1];
+      }
+
+      size_t position = block_start[i_block];
+      for (size_t i_row = row_begin; i_row < row_end; ++i_row) {
+        next[i_row] = position;
+        position += m_row_ptr[i_row+1];
+        m_row_ptr[i_row+1] = position;
+      }
+
+      for (size_t i_entry = block_start[i_block];
+           i_entry < block_start[i_block+1];
+           ++i_entry)
+      {
+        if (parts > 1) {
+          size_t pos = next[block_rows[i_entry]]++;
+          sorted_cols[pos] = block_cols[i_entry];
+          sorted_values[pos] = block_values[i_entry];
+        } else {
+          size_t pos = next[row_ind[i_entry] - row_offset]++;
+          sorted_cols[pos] = col_ind[i_entry];
+          sorted_values[pos] = values[i_entry];
+        }
+      }
+    }
+
+    block_rows.clear(); block_rows.shrink_to_fit();
+    block_cols.clear(); block_cols.shrink_to_fit();
+    block_values.clear(); block_values.shrink_to_fit();
+
+    // sort every row by column and sum up duplicates in place
+    std::vector<size_t> row_length(rows);
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel for schedule(static) num_threads(parts)
+    #endif
+    for (size_t i_row = 0; i_row < rows; ++i_row) {
+      size_t begin = m_row_ptr[i_row];
+      size_t end = m_row_ptr[i_row+1];
+
+      detail::sort_row(sorted_cols.data(), sorted_values.data(), begin, end);
+
+      size_t i_out = begin;
+      for (size_t i_entry = begin; i_entry < end; ++i_entry) {
+        if (i_out > begin && sorted_cols[i_out-1] == sorted_cols[i_entry]) {
+          sorted_values[i_out-1] += sorted_values[i_entry];
+        } else {
+          sorted_cols[i_out] = sorted_cols[i_entry];
+          sorted_values[i_out] = sorted_values[i_entry];
+          ++i_out;
+        }
+      }
+      row_length[i_row] = i_out - begin;
+    }
+
+    aligned_vector<size_t> compressed_row_ptr(rows+1, 0);
+    for (size_t i_row = 0; i_row < rows; ++i_row) {
+      compressed_row_ptr[i_row+1] = compressed_row_ptr[i_row] + row_length[i_row];
+    }
+
+    if (compressed_row_ptr[rows] == n_entries) {
+      // no duplicates, the sorted arrays are the result
+      m_col_ind = std::move(sorted_cols);
+      m_values = std::move(sorted_values);
+    } else {
+      m_col_ind.resize(compressed_row_ptr[rows]);
+      m_values.resize(compressed_row_ptr[rows]);
+
+      #ifdef ALLIUM_USE_OPENMP
+      #pragma omp parallel for schedule(static) num_threads(parts)
+      #endif
+      for (size_t i_row = 0; i_row < rows; ++i_row) {
+        std::copy_n(sorted_cols.begin() + m_row_ptr[i_row],
+                    row_length[i_row],
+                    m_col_ind.begin() + compressed_row_ptr[i_row]);
+        std::copy_n(sorted_values.begin() + m_row_ptr[i_row],
+                    row_length[i_row],
+                    m_values.begin() + compressed_row_ptr[i_row]);
+      }
+    }
+
+    m_row_ptr = std::move(compressed_row_ptr);
+  }
+
+  template <typename N>
+  LocalCooMatrix<N> LocalCsrMatrix<N>::to_coo(global_size_t row_offset) const
+  {
+    LocalCooMatrix<N> coo;
+    coo.reserve(nnz());
+    for (size_t i_row = 0; i_row < rows(); ++i_row) {
+      for (size_t i_entry = m_row_ptr[i_row];
+           i_entry < m_row_ptr[i_row+1];
+           ++i_entry)
+      {
+        coo.add(row_offset + i_row, m_col_ind[i_entry], m_values[i_entry]);
+      }
+    }
+    return coo;
+  }
+
+  /**
+   @brief Splits the rows of a CSR matrix into `parts` contiguous blocks,
+   which contain roughly the same number of entries.
+
+   Every row is weighted by its entry count plus one, which accounts for the
+   cost of loading the row pointer and storing the result. Returns the first
+   row of every block, plus the row count.
+   */
+  inline std::vector<size_t> partition_rows(const size_t* row_ptr,
+                                            size_t rows,
+                                            int parts)
+  {
+    size_t total_weight = row_ptr[rows] + rows;
+
+    std::vector<size_t> partition(parts + 1);
+    partition[0] = 0;
+
+    size_t i_row = 0;
+    for (int i_part = 1; i_part < parts; ++i_part) {
+      size_t target = (total_weight * i_part) / parts;
+      while (i_row < rows && row_ptr[i_row] + i_row < target) {
+        ++i_row;
+      }
+      partition[i_part] = i_row;
+    }
+    partition[parts] = rows;
+
+    return partition;
+  }
+
+  /**
+   Recomputes the partition of the rows of `mat` by partition_rows, if it
+   was not computed for the given number of parts.
+   */
+  template <typename N>
+  void update_row_partition(const LocalCsrMatrix<N>& mat,
+                            std::vector<size_t>& partition,
+                            int parts = max_threads())
+  {
+    if (partition.size() != static_cast<size_t>(parts) + 1) {
+      partition = partition_rows(mat.row_ptr().data(), mat.rows(), parts);
+    }
+  }
+
+  /// @cond INTERNAL
+  namespace detail {
+    /**
+     The rows `[row_begin, row_end)` of the product with `width`
+     interleaved vectors. If `K` is not zero, it is the width, known at
+     compile time, and the sums are kept in registers.
+     */
+    template <int K, typename N>
+    void csr_block_rows(const size_t* row_ptr,
+                        const global_size_t* col_ind,
+                        const N* values,
+                        size_t width,
+                        const N* x,
+                        N* y,
+                        size_t row_begin,
+                        size_t row_end,
+                        bool add)
+    {
+      const size_t k = K > 0 ? K : width;
+
+      for (size_t i_row = row_begin; i_row < row_end; ++i_row) {
+        N* y_row = y + i_row * k;
+
+        if (K > 0) {
+          N sum[K > 0 ? K : 1];
+          for (int j = 0; j < K; ++j) {
+            sum[j] = add ? y_row[j] : N(0);
+          }
+          for (size_t i_entry = row_ptr[i_row];
+               i_entry < row_ptr[i_row+1];
+               ++i_entry)
+          {
+            const N a = values[i_entry];
+            const N* x_row = x + col_ind[i_entry] * K;
+            for (int j = 0; j < K; ++j) {
+              sum[j] += a * x_row[j];
+            }
+          }
+          for (int j = 0; j < K; ++j) {
+            y_row[j] = sum[j];
+          }
+        } else {
+          if (!add) {
+            std::fill(y_row, y_row + k, N(0));
+          }
+          for (size_t i_entry = row_ptr[i_row];
+               i_entry < row_ptr[i_row+1];
+               ++i_entry)
+          {
+            const N a = values[i_entry];
+            const N* x_row = x + col_ind[i_entry] * k;
+            for (size_t j = 0; j < k; ++j) {
+              y_row[j] += a * x_row[j];
+            }
+          }
+        }
+      }
+    }
+
+    template <int K, typename N>
+    void csr_block_product_impl(const LocalCsrMatrix<N>& mat,
+                                const std::vector<size_t>& partition,
+                                size_t width,
+                                const N* x,
+                                N* y,
+                                bool add)
+    {
+      const int parts = static_cast<int>(partition.size()) - 1;
+      const size_t* row_ptr = mat.row_ptr().data();
+      const global_size_t* col_ind = mat.col_ind().data();
+      const N* values = mat.values().data();
+      const size_t* part = partition.data();
+
+      #ifdef ALLIUM_USE_OPENMP
+      #pragma omp parallel for schedule(static, 1) num_threads(parts)
+      #endif
+      for (int i_part = 0; i_part < parts; ++i_part) {
+        csr_block_rows<K>(row_ptr, col_ind, values, width, x, y,
+                          part[i_part], part[i_part+1], add);
+      }
+    }
+  }
+  /// @endcond
+
+  /**
+   @brief Sparse matrix-vector product, `y = A x`, or `y += A x` if `add`
+   is set.
+
+   The rows are processed in the blocks of `partition`, one block per
+   thread (see partition_rows).
+   */
+  template <typename N>
+  void csr_apply(const LocalCsrMatrix<N>& mat,
+                 const std::vector<size_t>& partition,
+                 const N* x,
+                 N* y,
+                 bool add = false)
+  {
+    detail::csr_block_product_impl<1>(mat, partition, 1, x, y, add);
+  }
+
+  /**
+   @brief Sparse matrix times multi-vector product, `Y = A X`, or
+   `Y += A X` if `add` is set.
+
+   `X` and `Y` hold `width` vectors, which are interleaved, i.e., the
+   entry `i` of the vector `j` is stored at `i * width + j`. Hence, every
+   matrix entry is loaded once and applied to `width` values. The rows are
+   processed in the blocks of `partition`, one block per thread (see
+   partition_rows). The widths 2, 4, 8 and 16 use kernels with a fixed
+   width.
+   */
+  template <typename N>
+  void csr_block_product(const LocalCsrMatrix<N>& mat,
+                         const std::vector<size_t>& partition,
+                         size_t width,
+                         const N* x,
+                         N* y,
+                         bool add = false)
+  {
+    switch (width) {
+      case 1:
+        csr_apply(mat, partition, x, y, add);
+        break;
+      case 2:
+        detail::csr_block_product_impl<2>(mat, partition, width, x, y, add);
+        break;
+      case 4:
+        detail::csr_block_product_impl<4>(mat, partition, width, x, y, add);
+        break;
+      case 8:
+        detail::csr_block_product_impl<8>(mat, partition, width, x, y, add);
+        break;
+      case 16:
+        detail::csr_block_product_impl<16>(mat, partition, width, x, y, add);
+        break;
+      default:
+        detail::csr_block_product_impl<0>(mat, partition, width, x, y, add);
+    }
+  }
+}
+
+#endif
@@ -0,0 +1,301 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_LOCAL_CSR_PRODUCT_HPP
+#define ALLIUM_LA_LOCAL_CSR_PRODUCT_HPP
+
+#include "local_csr_matrix.hpp"
+#include <allium/config.hpp>
+#include <allium/util/parallel.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace allium {
+
+  /**
+   @brief The transpose of a LocalCsrMatrix.
+
+   The computation is split into a symbolic phase, which is done by the
+   constructor and determines the sparsity pattern, and a numeric phase,
+   which can be repeated with numeric() whenever the values of the original
+   matrix change, but its pattern does not.
+   */
+  template <typename N>
+  class LocalCsrTranspose {
+    public:
+      explicit LocalCsrTranspose(const LocalCsrMatrix<N>& a);
+
+      /** Recomputes the values for a matrix with the original pattern. */
+      void numeric(const LocalCsrMatrix<N>& a);
+
+      const LocalCsrMatrix<N>& result() const { return m_result; }
+
+    private:
+      LocalCsrMatrix<N> m_result;
+
+      /// The position of every entry of the original matrix in the result.
+      std::vector<size_t> m_position;
+  };
+
+  /**
+   @brief The product `C = A B` of two LocalCsrMatrix objects.
+
+   The product is computed row by row (Gustavson's algorithm). Like
+   LocalCsrTranspose, the constructor computes the sparsity pattern and
+   numeric() recomputes the values.
+   */
+  template <typename N>
+  class LocalCsrProduct {
+    public:
+      LocalCsrProduct(const LocalCsrMatrix<N>& a, const LocalCsrMatrix<N>& b);
+
+      /**
+       Recomputes the values for matrices with the patterns that were given
+       to the constructor.
+       */
+      void numeric(const LocalCsrMatrix<N>& a, const LocalCsrMatrix<N>& b);
+
+      const LocalCsrMatrix<N>& result() const { return m_result; }
+
+    private:
+      LocalCsrMatrix<N> m_result;
+      size_t m_a_nnz, m_b_nnz;
+  };
+
+  /**
+   @brief The Galerkin product `C = P^T A P` of two LocalCsrMatrix objects.
+
+   The product is computed as `P^T (A P)` with the symbolic and numeric
+   phases of LocalCsrTranspose and LocalCsrProduct.
+   */
+  template <typename N>
+  class LocalCsrTripleProduct {
+    public:
+      LocalCsrTripleProduct(const LocalCsrMatrix<N>& a,
+                            const LocalCsrMatrix<N>& p)
+        : m_pt(p),
+          m_ap(a, p),
+          m_ptap(m_pt.result(), m_ap.result())
+      {}
+
+      void numeric(const LocalCsrMatrix<N>& a, const LocalCsrMatrix<N>& p) {
+        m_pt.numeric(p);
+        m_ap.numeric(a, p);
+        m_ptap.numeric(m_pt.result(), m_ap.result());
+      }
+
+      const LocalCsrMatrix<N>& result() const { return m_ptap.result(); }
+
+    private:
+      LocalCsrTranspose<N> m_pt;
+      LocalCsrProduct<N> m_ap;
+      LocalCsrProduct<N> m_ptap;
+  };
+
+  template <typename N>
+  LocalCsrTranspose<N>::LocalCsrTranspose(const LocalCsrMatrix<N>& a)
+    : m_position(a.nnz())
+  {
+    auto& a_row_ptr = a.row_ptr();
+    auto& a_col_ind = a.col_ind();
+    size_t nnz = a.nnz();
+
+    aligned_vector<size_t> row_ptr(a.cols() + 1, 0);
+    for (size_t i_entry = 0; i_entry < nnz; ++i_entry) {
+      ++row_ptr[a_col_ind[i_entry] + 1];
+    }
+    for (size_t i_col = 0; i_col < a.cols(); ++i_col) {
+      row_ptr[i_col+1] += row_ptr[i_col];
+    }
+
+    // the rows are visited in increasing order, hence, the columns of the
+    // transpose are sorted
+    aligned_vector<global_size_t> col_ind(nnz);
+    std::vector<size_t> next(row_ptr.begin(), row_ptr.end() - 1);
+    for (size_t i_row = 0; i_row < a.rows(); ++i_row) {
+      for (size_t i_entry = a_row_ptr[i_row];
+           i_entry < a_row_ptr[i_row+1];
+           ++i_entry)
+      {
+        size_t pos = next[a_col_ind[i_entry]]++;
+        col_ind[pos] = i_row;
+        m_position[i_entry] = pos;
+      }
+    }
+
+    m_result = LocalCsrMatrix<N>(a.rows(),
+                                 std::move(row_ptr),
+                                 std::move(col_ind),
+                                 aligned_vector<N>(nnz));
+    numeric(a);
+  }
+
+  template <typename N>
+  void LocalCsrTranspose<N>::numeric(const LocalCsrMatrix<N>& a)
+  {
+    if (a.nnz() != m_position.size()) {
+      throw std::invalid_argument("The sparsity pattern has changed.");
+    }
+
+    const N* a_values = a.values().data();
+    N* values = m_result.values().data();
+    const size_t* position = m_position.data();
+    const size_t nnz = m_position.size();
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel for schedule(static) num_threads(max_threads())
+    #endif
+    for (size_t i_entry = 0; i_entry < nnz; ++i_entry) {
+      values[position[i_entry]] = a_values[i_entry];
+    }
+  }
+
+  template <typename N>
+  LocalCsrProduct<N>::LocalCsrProduct(const LocalCsrMatrix<N>& a,
+                                      const LocalCsrMatrix<N>& b)
+    : m_a_nnz(a.nnz()), m_b_nnz(b.nnz())
+  {
+    if (a.cols() != b.rows()) {
+      throw std::invalid_argument("The matrix dimensions do not match.");
+    }
+
+    const size_t rows = a.rows();
+    const size_t cols = b.cols();
+    const size_t* a_row_ptr = a.row_ptr().data();
+    const global_size_t* a_col_ind = a.col_ind().data();
+    const size_t* b_row_ptr = b.row_ptr().data();
+    const global_size_t* b_col_ind = b.col_ind().data();
+    const size_t none = static_cast<size_t>(-1);
+
+    // count the distinct columns of every row
+    aligned_vector<size_t> row_ptr(rows + 1, 0);
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel num_threads(max_threads())
+    #endif
+    {
+      // the last row that used a column
+      std::vector<size_t> marker(cols, none);
+
+      #ifdef ALLIUM_USE_OPENMP
+      #pragma omp for schedule(static)
+      #endif
+      for (size_t i_row = 0; i_row < rows; ++i_row) {
+        size_t count = 0;
+        for (size_t i_a = a_row_ptr[i_row]; i_a < a_row_ptr[i_row+1]; ++i_a) {
+          global_size_t k = a_col_ind[i_a];
+          for (size_t i_b = b_row_ptr[k]; i_b < b_row_ptr[k+1]; ++i_b) {
+            global_size_t j = b_col_ind[i_b];
+            if (marker[j] != i_row) {
+              marker[j] = i_row;
+              ++count;
+            }
+          }
+        }
+        row_ptr[i_row+1] = count;
+      }
+    }
+
+    for (size_t i_row = 0; i_row < rows; ++i_row) {
+      row_ptr[i_row+1] += row_ptr[i_row];
+    }
+
+    // collect and sort the columns of every row
+    aligned_vector<global_size_t> col_ind(row_ptr[rows]);
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel num_threads(max_threads())
+    #endif
+    {
+      std::vector<size_t> marker(cols, none);
+
+      #ifdef ALLIUM_USE_OPENMP
+      #pragma omp for schedule(static)
+      #endif
+      for (size_t i_row = 0; i_row < rows; ++i_row) {
+        size_t pos = row_ptr[i_row];
+        for (size_t i_a = a_row_ptr[i_row]; i_a < a_row_ptr[i_row+1]; ++i_a) {
+          global_size_t k = a_col_ind[i_a];
+          for (size_t i_b = b_row_ptr[k]; i_b < b_row_ptr[k+1]; ++i_b) {
+            global_size_t j = b_col_ind[i_b];
+            if (marker[j] != i_row) {
+              marker[j] = i_row;
+              col_ind[pos++] = j;
+            }
+          }
+        }
+        std::sort(col_ind.begin() + row_ptr[i_row],
+                  col_ind.begin() + row_ptr[i_row+1]);
+      }
+    }
+
+    size_t nnz = row_ptr[rows];
+    m_result = LocalCsrMatrix<N>(cols,
+                                 std::move(row_ptr),
+                                 std::move(col_ind),
+                                 aligned_vector<N>(nnz));
+    numeric(a, b);
+  }
+
+  template <typename N>
+  void LocalCsrProduct<N>::numeric(const LocalCsrMatrix<N>& a,
+                                   const LocalCsrMatrix<N>& b)
+  {
+    if (a.nnz() != m_a_nnz || b.nnz() != m_b_nnz
+        || a.rows() != m_result.rows() || b.cols() != m_result.cols()) {
+      throw std::invalid_argument("The sparsity pattern has changed.");
+    }
+
+    const size_t rows = m_result.rows();
+    const size_t cols = m_result.cols();
+    const size_t* a_row_ptr = a.row_ptr().data();
+    const global_size_t* a_col_ind = a.col_ind().data();
+    const N* a_values = a.values().data();
+    const size_t* b_row_ptr = b.row_ptr().data();
+    const global_size_t* b_col_ind = b.col_ind().data();
+    const N* b_values = b.values().data();
+    const size_t* row_ptr = m_result.row_ptr().data();
+    const global_size_t* col_ind = m_result.col_ind().data();
+    N* values = m_result.values().data();
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel num_threads(max_threads())
+    #endif
+    {
+      // the position of every column in the current row of the result
+      std::vector<size_t> position(cols);
+
+      #ifdef ALLIUM_USE_OPENMP
+      #pragma omp for schedule(static)
+      #endif
+      for (size_t i_row = 0; i_row < rows; ++i_row) {
+        for (size_t i_c = row_ptr[i_row]; i_c < row_ptr[i_row+1]; ++i_c) {
+          position[col_ind[i_c]] = i_c;
+          values[i_c] = 0;
+        }
+
+        for (size_t i_a = a_row_ptr[i_row]; i_a < a_row_ptr[i_row+1]; ++i_a) {
+          global_size_t k = a_col_ind[i_a];
+          N a_ik = a_values[i_a];
+          for (size_t i_b = b_row_ptr[k]; i_b < b_row_ptr[k+1]; ++i_b) {
+            values[position[b_col_ind[i_b]]] += a_ik * b_values[i_b];
+          }
+        }
+      }
+    }
+  }
+}
+
+#endif
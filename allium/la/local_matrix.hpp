@@ -60,6 +60,14 @@ namespace allium {
 
       LocalVector<N> get_row(size_t i_row) const;
       LocalVector<N> get_col(size_t i_col) const;
+
+      /** The underlying Eigen matrix. */
+      Eigen::Matrix<N, Eigen::Dynamic, Eigen::Dynamic>& native() {
+        return m_storage;
+      }
+      const Eigen::Matrix<N, Eigen::Dynamic, Eigen::Dynamic>& native() const {
+        return m_storage;
+      }
     private:
       Eigen::Matrix<N, Eigen::Dynamic, Eigen::Dynamic> m_storage;
   };
@@ -0,0 +1,427 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "matrix_io.hpp"
+#include <allium/util/parallel.hpp>
+#include <cctype>
+#include <cstring>
+#include <exception>
+#include <sstream>
+
+namespace allium {
+
+  namespace {
+    const char binary_csr_magic[8] = { 'A', 'L', 'L', 'I', 'U', 'M', 'C', '1' };
+
+    bool is_space(char c) {
+      return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    std::string lower(std::string word) {
+      for (auto& c : word) {
+        c = std::tolower(c);
+      }
+      return word;
+    }
+
+    /** Returns the position after the end of the current line. */
+    const char* next_line(const char* pos, const char* end) {
+      const char* newline
+        = static_cast<const char*>(std::memchr(pos, '\n', end - pos));
+      return newline ? newline + 1 : end;
+    }
+
+    /**
+     Parses the header and the size line. Returns the position of the first
+     entry.
+     */
+    const char* parse_header(const char* begin,
+                             const char* end,
+                             const std::string& filename,
+                             MatrixMarketHeader& header)
+    {
+      const char* line_end = next_line(begin, end);
+      std::istringstream banner(std::string(begin, line_end));
+
+      std::string tag, object, format, field, symmetry;
+      banner >> tag >> object >> format >> field >> symmetry;
+      if (tag != "%%MatrixMarket" || lower(object) != "matrix") {
+        throw std::runtime_error(filename + " is no Matrix Market file.");
+      }
+      if (lower(format) != "coordinate") {
+        throw std::runtime_error(
+          "Only the Matrix Market coordinate format is supported.");
+      }
+
+      field = lower(field);
+      if (field == "real")
+        header.field = MatrixMarketField::REAL;
+      else if (field == "integer")
+        header.field = MatrixMarketField::INTEGER;
+      else if (field == "complex")
+        header.field = MatrixMarketField::COMPLEX;
+      else if (field == "pattern")
+        header.field = MatrixMarketField::PATTERN;
+      else
+        throw std::runtime_error("Unknown Matrix Market field " + field + ".");
+
+      symmetry = lower(symmetry);
+      if (symmetry == "general")
+        header.symmetry = MatrixMarketSymmetry::GENERAL;
+      else if (symmetry == "symmetric")
+        header.symmetry = MatrixMarketSymmetry::SYMMETRIC;
+      else if (symmetry == "skew-symmetric")
+        header.symmetry = MatrixMarketSymmetry::SKEW_SYMMETRIC;
+      else if (symmetry == "hermitian")
+        header.symmetry = MatrixMarketSymmetry::HERMITIAN;
+      else
+        throw std::runtime_error("Unknown Matrix Market symmetry "
+                                 + symmetry + ".");
+
+      // skip the comments, the next line contains the size
+      const char* pos = line_end;
+      while (pos < end) {
+        line_end = next_line(pos, end);
+        const char* first = pos;
+        while (first < line_end && (is_space(*first) || *first == '\n'))
+          ++first;
+
+        if (first < line_end && *first != '%') {
+          std::istringstream size_line(std::string(first, line_end));
+          if (!(size_line >> header.rows >> header.cols >> header.entry_count))
+            break;
+          return line_end;
+        }
+        pos = line_end;
+      }
+
+      throw std::runtime_error("The size is missing in " + filename + ".");
+    }
+
+    /** Parses an unsigned integer and advances `pos`. */
+    bool parse_index(const char*& pos, const char* end, global_size_t& value)
+    {
+      while (pos < end && is_space(*pos))
+        ++pos;
+
+      const char* first = pos;
+      value = 0;
+      while (pos < end && *pos >= '0' && *pos <= '9') {
+        value = 10 * value + (*pos - '0');
+        ++pos;
+      }
+      return pos != first;
+    }
+
+    /** Parses a floating point number and advances `pos`. */
+    bool parse_number(const char*& pos, const char* end, double& value)
+    {
+      while (pos < end && is_space(*pos))
+        ++pos;
+
+      // The mapped file is not null-terminated, therefore, the number is
+      // copied before calling strtod.
+      char buffer[64];
+      size_t length = 0;
+      while (pos + length < end
+             && length < sizeof(buffer) - 1
+             && !is_space(pos[length])
+             && pos[length] != '\n') {
+        buffer[length] = pos[length];
+        ++length;
+      }
+      buffer[length] = '\0';
+
+      char* number_end;
+      value = std::strtod(buffer, &number_end);
+      pos += length;
+      return length > 0 && number_end == buffer + length;
+    }
+
+    /** The entries of a part of the file. */
+    struct Chunk {
+      global_size_t line_count = 0;
+      std::vector<global_size_t> rows;
+      std::vector<global_size_t> cols;
+      std::vector<double> real;
+      std::vector<double> imag;
+      bool failed = false;
+
+      void add(global_size_t row, global_size_t col,
+               double re, double im, bool complex)
+      {
+        rows.push_back(row);
+        cols.push_back(col);
+        real.push_back(re);
+        if (complex)
+          imag.push_back(im);
+      }
+    };
+
+    void parse_chunk(const char* begin,
+                     const char* end,
+                     const MatrixMarketHeader& header,
+                     global_size_t row_begin,
+                     global_size_t row_end,
+                     Chunk& chunk)
+    {
+      const bool complex = header.field == MatrixMarketField::COMPLEX;
+
+      const char* pos = begin;
+      while (pos < end) {
+        const char* line_end = next_line(pos, end);
+
+        while (pos < line_end && is_space(*pos))
+          ++pos;
+        if (pos == line_end || *pos == '\n' || *pos == '%') {
+          pos = line_end;
+          continue;
+        }
+
+        global_size_t row, col;
+        double re = 1, im = 0;
+        bool ok = parse_index(pos, line_end, row)
+                  && parse_index(pos, line_end, col);
+        if (ok && header.field != MatrixMarketField::PATTERN)
+          ok = parse_number(pos, line_end, re);
+        if (ok && complex)
+          ok = parse_number(pos, line_end, im);
+
+        if (!ok || row < 1 || row > header.rows
+            || col < 1 || col > header.cols) {
+          chunk.failed = true;
+          return;
+        }
+        --row;
+        --col;
+        ++chunk.line_count;
+
+        if (row >= row_begin && row < row_end)
+          chunk.add(row, col, re, im, complex);
+
+        // the entries of the other triangle are not stored in the file
+        if (row != col && col >= row_begin && col < row_end) {
+          switch (header.symmetry) {
+            case MatrixMarketSymmetry::GENERAL:
+              break;
+            case MatrixMarketSymmetry::SYMMETRIC:
+              chunk.add(col, row, re, im, complex);
+              break;
+            case MatrixMarketSymmetry::SKEW_SYMMETRIC:
+              chunk.add(col, row, -re, -im, complex);
+              break;
+            case MatrixMarketSymmetry::HERMITIAN:
+              chunk.add(col, row, re, -im, complex);
+              break;
+          }
+        }
+
+        pos = line_end;
+      }
+    }
+
+    void write_uint64(std::ostream& os, const uint64_t* data, size_t count) {
+      os.write(reinterpret_cast<const char*>(data), count * sizeof(uint64_t));
+    }
+
+    /** Writes the indices as 64 bit integers, converting them if needed. */
+    template <typename T>
+    void write_indices(std::ostream& os, const T* data, size_t count) {
+      const size_t block_size = 1 << 16;
+      std::vector<uint64_t> block;
+      for (size_t i = 0; i < count; i += block_size) {
+        size_t n = std::min(block_size, count - i);
+        block.assign(data + i, data + i + n);
+        write_uint64(os, block.data(), n);
+      }
+    }
+
+    size_t binary_value_size(uint32_t number_type) {
+      switch (number_type) {
+        case 1: return sizeof(float);
+        case 2: return sizeof(double);
+        case 3: return sizeof(std::complex<float>);
+        case 4: return sizeof(std::complex<double>);
+        default:
+          throw std::runtime_error("Unknown number type in matrix file.");
+      }
+    }
+  }
+
+  MatrixMarketHeader read_matrix_market_header(const std::string& filename)
+  {
+    MappedFile file(filename);
+
+    MatrixMarketHeader header;
+    parse_header(file.data(), file.data() + file.size(), filename, header);
+    return header;
+  }
+
+  namespace detail {
+    MatrixMarketEntries read_matrix_market(const std::string& filename,
+                                           global_size_t row_begin,
+                                           global_size_t row_end)
+    {
+      MappedFile file(filename);
+      const char* file_end = file.data() + file.size();
+
+      MatrixMarketEntries result;
+      auto& header = result.header;
+      const char* data = parse_header(file.data(), file_end, filename, header);
+
+      // Split the entries into chunks at line boundaries. There are more
+      // chunks than threads to balance the load.
+      const size_t min_chunk_size = 1 << 16;
+      size_t data_size = file_end - data;
+      size_t chunk_count
+        = std::max<size_t>(1, std::min<size_t>(4 * max_threads(),
+                                               data_size / min_chunk_size));
+
+      std::vector<const char*> bounds(chunk_count + 1);
+      bounds[0] = data;
+      bounds[chunk_count] = file_end;
+      for (size_t i_chunk = 1; i_chunk < chunk_count; ++i_chunk) {
+        bounds[i_chunk]
+          = next_line(data + data_size * i_chunk / chunk_count, file_end);
+      }
+
+      std::vector<Chunk> chunks(chunk_count);
+
+      #ifdef ALLIUM_USE_OPENMP
+      #pragma omp parallel for schedule(dynamic) num_threads(max_threads())
+      #endif
+      for (size_t i_chunk = 0; i_chunk < chunk_count; ++i_chunk) {
+        parse_chunk(bounds[i_chunk], bounds[i_chunk+1],
+                    header, row_begin, row_end, chunks[i_chunk]);
+      }
+
+      global_size_t line_count = 0;
+      std::vector<size_t> offsets(chunk_count + 1, 0);
+      for (size_t i_chunk = 0; i_chunk < chunk_count; ++i_chunk) {
+        if (chunks[i_chunk].failed) {
+          throw std::runtime_error("Invalid matrix entry in "
+                                   + filename + ".");
+        }
+        line_count += chunks[i_chunk].line_count;
+        offsets[i_chunk+1] = offsets[i_chunk] + chunks[i_chunk].rows.size();
+      }
+
+      if (line_count != header.entry_count) {
+        throw std::runtime_error("Unexpected number of entries in "
+                                 + filename + ".");
+      }
+
+      // the entries keep the order of the file
+      const bool complex = header.field == MatrixMarketField::COMPLEX;
+      size_t entry_count = offsets[chunk_count];
+      result.rows.resize(entry_count);
+      result.cols.resize(entry_count);
+      result.real.resize(entry_count);
+      if (complex)
+        result.imag.resize(entry_count);
+
+      #ifdef ALLIUM_USE_OPENMP
+      #pragma omp parallel for schedule(static) num_threads(max_threads())
+      #endif
+      for (size_t i_chunk = 0; i_chunk < chunk_count; ++i_chunk) {
+        auto& chunk = chunks[i_chunk];
+        size_t offset = offsets[i_chunk];
+        std::copy(chunk.rows.begin(), chunk.rows.end(),
+                  result.rows.begin() + offset);
+        std::copy(chunk.cols.begin(), chunk.cols.end(),
+                  result.cols.begin() + offset);
+        std::copy(chunk.real.begin(), chunk.real.end(),
+                  result.real.begin() + offset);
+        if (complex) {
+          std::copy(chunk.imag.begin(), chunk.imag.end(),
+                    result.imag.begin() + offset);
+        }
+      }
+
+      return result;
+    }
+
+    void write_matrix_market_header(std::ostream& os,
+                                    bool complex,
+                                    global_size_t rows,
+                                    global_size_t cols,
+                                    global_size_t entry_count)
+    {
+      os << "%%MatrixMarket matrix coordinate "
+         << (complex ? "complex" : "real") << " general\n"
+         << rows << " " << cols << " " << entry_count << "\n";
+    }
+
+    void write_binary_csr(const std::string& filename,
+                          uint32_t number_type,
+                          uint64_t rows,
+                          uint64_t cols,
+                          const size_t* row_ptr,
+                          const global_size_t* col_ind,
+                          const void* values,
+                          size_t value_size)
+    {
+      std::ofstream os(filename, std::ios::binary);
+      if (!os)
+        throw std::runtime_error("Could not open " + filename + ".");
+
+      BinaryCsrHeader header;
+      std::memcpy(header.magic, binary_csr_magic, sizeof(header.magic));
+      header.number_type = number_type;
+      header.reserved = 0;
+      header.rows = rows;
+      header.cols = cols;
+      header.nnz = row_ptr[rows];
+
+      os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      write_indices(os, row_ptr, rows + 1);
+      write_indices(os, col_ind, header.nnz);
+      os.write(static_cast<const char*>(values), header.nnz * value_size);
+
+      if (!os)
+        throw std::runtime_error("Could not write " + filename + ".");
+    }
+  }
+
+  BinaryCsrFile::BinaryCsrFile(const std::string& filename)
+    : m_filename(filename), m_file(filename)
+  {
+    if (m_file.size() < sizeof(m_header)) {
+      throw std::runtime_error(filename + " is no binary CSR file.");
+    }
+    std::memcpy(&m_header, m_file.data(), sizeof(m_header));
+    if (std::memcmp(m_header.magic, binary_csr_magic, sizeof(m_header.magic))) {
+      throw std::runtime_error(filename + " is no binary CSR file.");
+    }
+
+    size_t expected_size
+      = sizeof(m_header)
+        + sizeof(uint64_t) * (m_header.rows + 1 + m_header.nnz)
+        + binary_value_size(m_header.number_type) * m_header.nnz;
+    if (m_file.size() != expected_size) {
+      throw std::runtime_error(filename + " has the wrong size.");
+    }
+
+    // the mapping is page aligned and all arrays are 64 bit aligned
+    const char* data = m_file.data() + sizeof(m_header);
+    m_row_ptr = reinterpret_cast<const uint64_t*>(data);
+    m_col_ind = m_row_ptr + m_header.rows + 1;
+    m_values = reinterpret_cast<const char*>(m_col_ind + m_header.nnz);
+
+    if (m_row_ptr[0] != 0 || m_row_ptr[m_header.rows] != m_header.nnz) {
+      throw std::runtime_error(filename + " is corrupted.");
+    }
+  }
+
+}
@@ -0,0 +1,386 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_MATRIX_IO_HPP
+#define ALLIUM_LA_MATRIX_IO_HPP
+
+#include "local_coo_matrix.hpp"
+#include "local_csr_matrix.hpp"
+#include "sparse_matrix.hpp"
+#include <allium/util/mapped_file.hpp>
+#include <allium/util/numeric.hpp>
+#include <algorithm>
+#include <complex>
+#include <cstdint>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace allium {
+
+  /// @addtogroup io
+  /// @{
+
+  enum class MatrixMarketField { REAL, INTEGER, COMPLEX, PATTERN };
+
+  enum class MatrixMarketSymmetry {
+    GENERAL, SYMMETRIC, SKEW_SYMMETRIC, HERMITIAN
+  };
+
+  /** @brief The header of a Matrix Market file in coordinate format. */
+  struct MatrixMarketHeader {
+    global_size_t rows;
+    global_size_t cols;
+    /** The number of entries stored in the file. */
+    global_size_t entry_count;
+    MatrixMarketField field;
+    MatrixMarketSymmetry symmetry;
+  };
+
+  MatrixMarketHeader read_matrix_market_header(const std::string& filename);
+
+  /// @cond INTERNAL
+  namespace detail {
+    struct MatrixMarketEntries {
+      MatrixMarketHeader header;
+      std::vector<global_size_t> rows;
+      std::vector<global_size_t> cols;
+      std::vector<double> real;
+      // only used for complex values
+      std::vector<double> imag;
+    };
+
+    MatrixMarketEntries read_matrix_market(const std::string& filename,
+                                           global_size_t row_begin,
+                                           global_size_t row_end);
+
+    template <typename N>
+    std::enable_if_t<!is_complex<N>::value, N>
+    make_number(const MatrixMarketEntries& entries, size_t i) {
+      return entries.real[i];
+    }
+
+    template <typename N>
+    std::enable_if_t<is_complex<N>::value, N>
+    make_number(const MatrixMarketEntries& entries, size_t i) {
+      using Real = real_part_t<N>;
+      if (entries.imag.empty())
+        return N(entries.real[i]);
+      else
+        return N(Real(entries.real[i]), Real(entries.imag[i]));
+    }
+
+    void write_matrix_market_header(std::ostream& os,
+                                    bool complex,
+                                    global_size_t rows,
+                                    global_size_t cols,
+                                    global_size_t entry_count);
+
+    inline void write_matrix_market_value(std::ostream& os, double value) {
+      os << value;
+    }
+
+    inline void write_matrix_market_value(std::ostream& os, float value) {
+      os << value;
+    }
+
+    template <typename T>
+    void write_matrix_market_value(std::ostream& os, std::complex<T> value) {
+      os << value.real() << " " << value.imag();
+    }
+  }
+  /// @endcond
+
+  /**
+   @brief Reads a sparse matrix from a file in the Matrix Market coordinate
+   format.
+
+   The file is parsed by several threads in parallel. Symmetric,
+   skew-symmetric and Hermitian matrices are expanded, i.e., the result
+   contains the entries of both triangles. Only the entries of the rows
+   `row_begin <= row < row_end` are returned, which allows each process to
+   load its own block of rows. The row and column indices start at 0.
+   */
+  template <typename N>
+  LocalCooMatrix<N> read_matrix_market(
+      const std::string& filename,
+      global_size_t row_begin = 0,
+      global_size_t row_end = std::numeric_limits<global_size_t>::max())
+  {
+    auto entries = detail::read_matrix_market(filename, row_begin, row_end);
+
+    if (!is_complex<N>::value
+        && entries.header.field == MatrixMarketField::COMPLEX) {
+      throw std::invalid_argument(
+        "Cannot read complex values into a real matrix.");
+    }
+
+    LocalCooMatrix<N> result;
+    result.reserve(entries.rows.size());
+    for (size_t i = 0; i < entries.rows.size(); ++i) {
+      result.add(entries.rows[i],
+                 entries.cols[i],
+                 detail::make_number<N>(entries, i));
+    }
+    return result;
+  }
+
+  /**
+   @brief Writes a sparse matrix in the Matrix Market coordinate format.
+
+   The values are written with enough digits to be read back exactly.
+   */
+  template <typename N>
+  void write_matrix_market(const std::string& filename,
+                           const LocalCooMatrix<N>& mat,
+                           global_size_t rows,
+                           global_size_t cols)
+  {
+    std::ofstream os(filename);
+    if (!os)
+      throw std::runtime_error("Could not open " + filename + ".");
+
+    detail::write_matrix_market_header(os, is_complex<N>::value,
+                                       rows, cols, mat.entry_count());
+
+    os.precision(std::numeric_limits<real_part_t<N>>::max_digits10);
+    for (size_t i = 0; i < mat.entry_count(); ++i) {
+      os << mat.row_ind()[i] + 1 << " " << mat.col_ind()[i] + 1 << " ";
+      detail::write_matrix_market_value(os, mat.values()[i]);
+      os << "\n";
+    }
+
+    if (!os)
+      throw std::runtime_error("Could not write " + filename + ".");
+  }
+
+  /**
+   @brief Loads the local rows of a distributed matrix from a Matrix Market
+   file.
+   */
+  template <typename V>
+  void load_matrix_market(SparseMatrixStorage<V>& mat,
+                          const std::string& filename)
+  {
+    using Number = typename V::Number;
+
+    auto row_spec = mat.row_spec();
+    auto col_spec = mat.col_spec();
+    auto header = read_matrix_market_header(filename);
+    if (header.rows != row_spec.global_size()
+        || header.cols != col_spec.global_size()) {
+      throw std::runtime_error("The matrix in " + filename
+                               + " has the wrong size.");
+    }
+
+    mat.set_entries(read_matrix_market<Number>(filename,
+                                               row_spec.local_start(),
+                                               row_spec.local_end()));
+  }
+
+  /// @cond INTERNAL
+  namespace detail {
+    template <typename N> struct BinaryNumberType {};
+    template <> struct BinaryNumberType<float>
+      { static const uint32_t value = 1; };
+    template <> struct BinaryNumberType<double>
+      { static const uint32_t value = 2; };
+    template <> struct BinaryNumberType<std::complex<float>>
+      { static const uint32_t value = 3; };
+    template <> struct BinaryNumberType<std::complex<double>>
+      { static const uint32_t value = 4; };
+
+    /** The file header, all fields are 64 bit aligned. */
+    struct BinaryCsrHeader {
+      char magic[8];
+      uint32_t number_type;
+      uint32_t reserved;
+      uint64_t rows;
+      uint64_t cols;
+      uint64_t nnz;
+    };
+
+    void write_binary_csr(const std::string& filename,
+                          uint32_t number_type,
+                          uint64_t rows,
+                          uint64_t cols,
+                          const size_t* row_ptr,
+                          const global_size_t* col_ind,
+                          const void* values,
+                          size_t value_size);
+  }
+  /// @endcond
+
+  /**
+   @brief A sparse matrix in the binary CSR format, mapped into memory.
+
+   The file consists of a header, followed by the row pointers, the column
+   indices (both 64 bit unsigned integers) and the values. It uses the byte
+   order of the machine. Since the file is mapped into memory, only the
+   accessed rows are read from the disk.
+   */
+  class BinaryCsrFile {
+    public:
+      explicit BinaryCsrFile(const std::string& filename);
+
+      global_size_t rows() const { return m_header.rows; }
+      global_size_t cols() const { return m_header.cols; }
+      global_size_t nnz() const { return m_header.nnz; }
+
+      const uint64_t* row_ptr() const { return m_row_ptr; }
+      const uint64_t* col_ind() const { return m_col_ind; }
+
+      template <typename N>
+      const N* values() const {
+        if (m_header.number_type != detail::BinaryNumberType<N>::value) {
+          throw std::invalid_argument(
+            "The matrix file contains a different number type.");
+        }
+        return reinterpret_cast<const N*>(m_values);
+      }
+
+      /**
+       Copies the rows `row_begin <= row < row_end`. Throws
+       std::runtime_error if the row pointers of these rows are not
+       monotonic, or if the columns of a row are not strictly increasing
+       and smaller than cols().
+       */
+      template <typename N>
+      LocalCsrMatrix<N> read_rows(global_size_t row_begin,
+                                  global_size_t row_end) const;
+
+    private:
+      std::string m_filename;
+      MappedFile m_file;
+      detail::BinaryCsrHeader m_header;
+      const uint64_t* m_row_ptr;
+      const uint64_t* m_col_ind;
+      const char* m_values;
+  };
+
+  template <typename N>
+  LocalCsrMatrix<N> BinaryCsrFile::read_rows(global_size_t row_begin,
+                                             global_size_t row_end) const
+  {
+    if (row_begin > row_end || row_end > rows()) {
+      throw std::out_of_range("Invalid row range.");
+    }
+
+    const N* all_values = values<N>();
+    size_t local_rows = row_end - row_begin;
+
+    // the arrays are used as they are, hence a corrupted file must not get
+    // through
+    for (global_size_t i_row = row_begin; i_row < row_end; ++i_row) {
+      uint64_t begin = m_row_ptr[i_row];
+      uint64_t end = m_row_ptr[i_row+1];
+      if (begin > end || end > nnz()) {
+        throw std::runtime_error(m_filename + " is corrupted.");
+      }
+      for (uint64_t i_entry = begin; i_entry < end; ++i_entry) {
+        if (m_col_ind[i_entry] >= cols()
+            || (i_entry > begin && m_col_ind[i_entry] <= m_col_ind[i_entry-1])) {
+          throw std::runtime_error(m_filename + " is corrupted.");
+        }
+      }
+    }
+
+    uint64_t offset = m_row_ptr[row_begin];
+    size_t local_nnz = m_row_ptr[row_end] - offset;
+
+    aligned_vector<size_t> row_ptr(local_rows + 1);
+    for (size_t i_row = 0; i_row <= local_rows; ++i_row) {
+      row_ptr[i_row] = m_row_ptr[row_begin + i_row] - offset;
+    }
+
+    aligned_vector<global_size_t> col_ind(m_col_ind + offset,
+                                          m_col_ind + offset + local_nnz);
+    aligned_vector<N> values(all_values + offset,
+                             all_values + offset + local_nnz);
+
+    return LocalCsrMatrix<N>(cols(),
+                             std::move(row_ptr),
+                             std::move(col_ind),
+                             std::move(values));
+  }
+
+  /**
+   @brief Writes a sparse matrix in the binary CSR format.
+
+   @see BinaryCsrFile
+   */
+  template <typename N>
+  void write_binary_csr(const std::string& filename,
+                        const LocalCsrMatrix<N>& mat)
+  {
+    detail::write_binary_csr(filename,
+                             detail::BinaryNumberType<N>::value,
+                             mat.rows(),
+                             mat.cols(),
+                             mat.row_ptr().data(),
+                             mat.col_ind().data(),
+                             mat.values().data(),
+                             sizeof(N));
+  }
+
+  /**
+   @brief Reads the rows `row_begin <= row < row_end` of a sparse matrix
+   in the binary CSR format.
+
+   The result can be passed directly to the CsrSparseMatrixStorage
+   constructor.
+   */
+  template <typename N>
+  LocalCsrMatrix<N> read_binary_csr(
+      const std::string& filename,
+      global_size_t row_begin = 0,
+      global_size_t row_end = std::numeric_limits<global_size_t>::max())
+  {
+    BinaryCsrFile file(filename);
+    return file.read_rows<N>(row_begin, std::min(row_end, file.rows()));
+  }
+
+  /**
+   @brief Loads the local rows of a distributed matrix from a file in the
+   binary CSR format.
+
+   Only the local rows are read from the disk. They are passed to
+   SparseMatrixStorage::set_csr(), such that CSR based formats take them
+   over without sorting.
+   */
+  template <typename V>
+  void load_binary_csr(SparseMatrixStorage<V>& mat,
+                       const std::string& filename)
+  {
+    using Number = typename V::Number;
+
+    auto row_spec = mat.row_spec();
+    auto col_spec = mat.col_spec();
+    BinaryCsrFile file(filename);
+    if (file.rows() != row_spec.global_size()
+        || file.cols() != col_spec.global_size()) {
+      throw std::runtime_error("The matrix in " + filename
+                               + " has the wrong size.");
+    }
+
+    auto local = file.read_rows<Number>(row_spec.local_start(),
+                                        row_spec.local_end());
+    mat.set_csr(std::move(local));
+  }
+
+  /// @}
+}
+
+#endif
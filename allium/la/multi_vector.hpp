@@ -0,0 +1,101 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_MULTI_VECTOR_HPP
+#define ALLIUM_LA_MULTI_VECTOR_HPP
+
+#include <allium/util/extern.hpp>
+#include <allium/util/numeric.hpp>
+#include "local_matrix.hpp"
+#include "vector_spec.hpp"
+#include "vector_storage.hpp"
+#include <Eigen/Core>
+#include <vector>
+
+namespace allium {
+
+  /**
+    @brief A block of vectors, which share one VectorSpec.
+
+    The local parts of the vectors are stored in one dense matrix with a row
+    per local entry and a column per vector. With Eigen::ColMajor storage,
+    every vector is contiguous. With Eigen::RowMajor storage, the vectors are
+    interleaved, i.e., the entries of all vectors at one index are
+    contiguous, which suits sparse matrix times multi-vector products.
+
+    The block operations use dense kernels on the local matrices. Reductions
+    over several vectors, e.g., all inner products of two blocks, are summed
+    over the ranks by a single allreduce.
+   */
+  template <typename N, int StorageOrder = Eigen::ColMajor>
+  class MultiVector {
+    public:
+      using Number = N;
+      using Real = real_part_t<N>;
+      using LocalBlock = Eigen::Matrix<N, Eigen::Dynamic, Eigen::Dynamic, StorageOrder>;
+
+      /** Creates `count` vectors, all entries are zero. */
+      MultiVector(VectorSpec spec, size_t count);
+
+      virtual ~MultiVector() {}
+
+      VectorSpec spec() const { return m_spec; }
+
+      /** The number of vectors. */
+      size_t count() const { return m_block.cols(); }
+
+      /** The local parts of the vectors, one vector per column. */
+      LocalBlock& native() { return m_block; }
+      const LocalBlock& native() const { return m_block; }
+
+      MultiVector& operator*=(N factor);
+      void add_scaled(N factor, const MultiVector& other);
+      void fill(N value);
+
+      /** Copies the `i_vector`-th vector into `v`. */
+      void get(size_t i_vector, VectorStorage<N>& v) const;
+
+      /** Copies `v` into the `i_vector`-th vector. */
+      void set(size_t i_vector, const VectorStorage<N>& v);
+
+      /**
+        Computes `Y += X C`, where `Y` is this block, i.e., the j-th vector
+        of `Y` is increased by `sum_i C(i, j) X_i`. The matrix `C` has a row
+        per vector of `X` and a column per vector of `Y`.
+       */
+      void add_product(const MultiVector& x, const LocalMatrix<N>& c);
+
+      /**
+        Computes the matrix of inner products `X^H Y`, where `X` is this
+        block, i.e., the entry `(i, j)` is `sum_k conj(X_i[k]) Y_j[k]`.
+       */
+      LocalMatrix<N> inner_products(const MultiVector& y) const;
+
+      /** The 2-norms of all vectors. */
+      std::vector<Real> l2_norms() const;
+
+    private:
+      VectorSpec m_spec;
+      LocalBlock m_block;
+
+      void check_compatible(const MultiVector& other) const;
+  };
+
+  #define ALLIUM_MULTI_VECTOR_DECL(extern, N) \
+    extern template class MultiVector<N, Eigen::ColMajor>; \
+    extern template class MultiVector<N, Eigen::RowMajor>;
+  ALLIUM_EXTERN_N(ALLIUM_MULTI_VECTOR_DECL)
+}
+
+#endif
@@ -0,0 +1,128 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "multi_vector.hpp"
+
+#include <cmath>
+#include <stdexcept>
+
+namespace allium {
+
+  template <typename N, int StorageOrder>
+  MultiVector<N, StorageOrder>::MultiVector(VectorSpec spec, size_t count)
+    : m_spec(spec),
+      m_block(LocalBlock::Zero(spec.local_size(), count))
+  {}
+
+  template <typename N, int StorageOrder>
+  void MultiVector<N, StorageOrder>::check_compatible(const MultiVector& other) const
+  {
+    if (m_block.rows() != other.m_block.rows()) {
+      throw std::invalid_argument("The multi-vectors have different local sizes.");
+    }
+  }
+
+  template <typename N, int StorageOrder>
+  auto MultiVector<N, StorageOrder>::operator*=(N factor) -> MultiVector&
+  {
+    m_block *= factor;
+    return *this;
+  }
+
+  template <typename N, int StorageOrder>
+  void MultiVector<N, StorageOrder>::add_scaled(N factor, const MultiVector& other)
+  {
+    check_compatible(other);
+    if (count() != other.count()) {
+      throw std::invalid_argument("The multi-vectors have different vector counts.");
+    }
+
+    m_block += factor * other.m_block;
+  }
+
+  template <typename N, int StorageOrder>
+  void MultiVector<N, StorageOrder>::fill(N value)
+  {
+    m_block.setConstant(value);
+  }
+
+  template <typename N, int StorageOrder>
+  void MultiVector<N, StorageOrder>::get(size_t i_vector,
+                                         VectorStorage<N>& v) const
+  {
+    auto slice = local_slice(v);
+    if (slice.size() != static_cast<size_t>(m_block.rows())) {
+      throw std::invalid_argument("The vector has a different local size.");
+    }
+
+    Eigen::Map<Eigen::Matrix<N, Eigen::Dynamic, 1>>(slice.data(), slice.size())
+      = m_block.col(i_vector);
+  }
+
+  template <typename N, int StorageOrder>
+  void MultiVector<N, StorageOrder>::set(size_t i_vector,
+                                         const VectorStorage<N>& v)
+  {
+    auto slice = local_slice(v);
+    if (slice.size() != static_cast<size_t>(m_block.rows())) {
+      throw std::invalid_argument("The vector has a different local size.");
+    }
+
+    m_block.col(i_vector)
+      = Eigen::Map<const Eigen::Matrix<N, Eigen::Dynamic, 1>>(slice.data(),
+                                                              slice.size());
+  }
+
+  template <typename N, int StorageOrder>
+  void MultiVector<N, StorageOrder>::add_product(const MultiVector& x,
+                                                 const LocalMatrix<N>& c)
+  {
+    check_compatible(x);
+    if (static_cast<size_t>(c.native().rows()) != x.count()
+        || static_cast<size_t>(c.native().cols()) != count()) {
+      throw std::invalid_argument("The coefficient matrix has the wrong size.");
+    }
+
+    m_block.noalias() += x.m_block * c.native();
+  }
+
+  template <typename N, int StorageOrder>
+  LocalMatrix<N> MultiVector<N, StorageOrder>::inner_products(const MultiVector& y) const
+  {
+    check_compatible(y);
+
+    LocalMatrix<N> result(count(), y.count());
+    result.native().noalias() = m_block.adjoint() * y.m_block;
+
+    // a single reduction for all inner products
+    spec().comm().sum_allreduce(result.native().data(),
+                                static_cast<int>(result.native().size()));
+    return result;
+  }
+
+  template <typename N, int StorageOrder>
+  auto MultiVector<N, StorageOrder>::l2_norms() const -> std::vector<Real>
+  {
+    std::vector<Real> norms(count());
+    for (size_t i = 0; i < count(); ++i) {
+      norms[i] = m_block.col(i).squaredNorm();
+    }
+
+    spec().comm().sum_allreduce(norms.data(), static_cast<int>(norms.size()));
+    for (auto& norm : norms) {
+      norm = std::sqrt(norm);
+    }
+    return norms;
+  }
+}
@@ -0,0 +1,455 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_OPERATOR_ALGEBRA_HPP
+#define ALLIUM_LA_OPERATOR_ALGEBRA_HPP
+
+#include <allium/config.hpp>
+
+#include "linear_operator.hpp"
+#include "vector_storage.hpp"
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace allium {
+  /// @addtogroup linear_solver
+  /// @{
+
+  /**
+   @brief Linear operator that can add a multiple of the identity within its
+   own sweep over the vectors.
+
+   A LinearCombinationOperator folds its shift into such an operator, e.g.,
+   `A + s I` for a stencil operator `A` is applied in one sweep.
+   */
+  template <typename V>
+  class ShiftableOperator : public LinearOperator<V> {
+    public:
+      using typename LinearOperator<V>::Vector;
+      using typename LinearOperator<V>::Number;
+
+      /**
+       Computes `result = alpha (A + shift I) arg + beta result`. If `beta`
+       is zero, the previous content of `result` is not read.
+       */
+      virtual void apply_shifted_add(Vector& result,
+                                     Number alpha,
+                                     Number shift,
+                                     const Vector& arg,
+                                     Number beta) = 0;
+
+      void apply(Vector& result, const Vector& arg) override {
+        apply_shifted_add(result, 1, 0, arg, 0);
+      }
+
+      void apply_add(Vector& result,
+                     Number alpha,
+                     const Vector& arg,
+                     Number beta) override {
+        apply_shifted_add(result, alpha, 0, arg, beta);
+      }
+  };
+
+  /// @cond INTERNAL
+  namespace detail {
+    /**
+     Computes `y = alpha (shift + sum_j c_j d_j) * x + beta y` pointwise.
+     The pointers `x` and `y` may be equal.
+     */
+    template <typename N>
+    void apply_pointwise(N* y,
+                         N alpha,
+                         N shift,
+                         const std::vector<std::pair<N, const N*>>& diagonals,
+                         const N* x,
+                         N beta,
+                         size_t size)
+    {
+      const long n = size;
+      const bool read_y = beta != N(0);
+
+      #ifdef ALLIUM_USE_OPENMP
+      #pragma omp parallel for schedule(static)
+      #endif
+      for (long i = 0; i < n; ++i) {
+        N factor = shift;
+        for (const auto& d : diagonals) {
+          factor += d.first * d.second[i];
+        }
+        N value = alpha * factor * x[i];
+        y[i] = read_y ? beta * y[i] + value : value;
+      }
+    }
+  }
+  /// @endcond
+
+  /**
+   @brief Lazy linear combination of linear operators.
+
+   Represents the operator
+
+       sum_k c_k A_k + s I + sum_j e_j diag(d_j),
+
+   where the `A_k` are linear operators and the `d_j` are vectors. The
+   operators and the diagonal vectors are referenced, not copied. Hence,
+   changing them, e.g., updating a diagonal in each time step, changes this
+   operator as well.
+
+   The application does not need temporary vectors. The diagonal part is
+   evaluated in a single sweep over the vectors, and every operator term
+   accumulates into the result by LinearOperator::apply_add. The shift is
+   folded into the first term that is a ShiftableOperator, if there is one.
+   Then, `A + s I` costs the same as the application of `A` alone. The
+   result must not be the same vector as the argument.
+   */
+  template <typename V>
+  class LinearCombinationOperator final : public LinearOperator<V> {
+    public:
+      using typename LinearOperator<V>::Vector;
+      using typename LinearOperator<V>::Number;
+      using Term = std::pair<Number, std::shared_ptr<LinearOperator<V>>>;
+      using DiagonalTerm = std::pair<Number, std::shared_ptr<const V>>;
+
+      explicit LinearCombinationOperator(std::vector<Term> terms,
+                                         Number shift = 0,
+                                         std::vector<DiagonalTerm> diagonals = {})
+        : m_terms(std::move(terms)),
+          m_shift(shift),
+          m_diagonals(std::move(diagonals))
+      {}
+
+      void apply(Vector& result, const Vector& arg) override {
+        apply_add(result, 1, arg, 0);
+      }
+
+      void apply_add(Vector& result,
+                     Number alpha,
+                     const Vector& arg,
+                     Number beta) override;
+
+      /**
+       Applies the transposed operator. Since LinearOperator has no
+       accumulating transposed application, each operator term is applied
+       into a temporary vector.
+       */
+      void apply_transpose(Vector& result, const Vector& arg) override;
+
+      /**
+       Computes `vec = alpha (s I + sum_j e_j diag(d_j)) vec` in place. Only
+       the shift and the diagonal terms are taken into account.
+       */
+      void apply_pointwise(Vector& vec, Number alpha);
+
+      const std::vector<Term>& terms() const { return m_terms; }
+      Number shift() const { return m_shift; }
+      const std::vector<DiagonalTerm>& diagonals() const { return m_diagonals; }
+
+    private:
+      std::vector<Term> m_terms;
+      Number m_shift;
+      std::vector<DiagonalTerm> m_diagonals;
+
+      /** Computes `result = alpha (shift I + sum_j e_j diag(d_j)) arg + beta result`. */
+      void apply_diagonal_part(Vector& result,
+                               Number alpha,
+                               Number shift,
+                               const Vector& arg,
+                               Number beta);
+  };
+
+  template <typename V>
+  void LinearCombinationOperator<V>::apply_add(Vector& result,
+                                               Number alpha,
+                                               const Vector& arg,
+                                               Number beta)
+  {
+    // The index of the term, which absorbs the shift. The same operator may
+    // appear in several terms, hence the term is not identified by the
+    // operator.
+    ShiftableOperator<V>* shiftable = nullptr;
+    size_t i_shifted = m_terms.size();
+    if (m_shift != Number(0)) {
+      for (size_t i_term = 0; i_term < m_terms.size(); ++i_term) {
+        shiftable = dynamic_cast<ShiftableOperator<V>*>(m_terms[i_term].second.get());
+        if (shiftable != nullptr && m_terms[i_term].first != Number(0)) {
+          i_shifted = i_term;
+          break;
+        }
+        shiftable = nullptr;
+      }
+    }
+
+    Number shift = shiftable != nullptr ? Number(0) : m_shift;
+    if (shift != Number(0) || !m_diagonals.empty()) {
+      apply_diagonal_part(result, alpha, shift, arg, beta);
+      beta = 1;
+    } else if (m_terms.empty()) {
+      if (beta == Number(0))
+        result.fill(0);
+      else
+        result *= beta;
+    }
+
+    for (size_t i_term = 0; i_term < m_terms.size(); ++i_term) {
+      const auto& term = m_terms[i_term];
+      if (i_term == i_shifted) {
+        shiftable->apply_shifted_add(result, alpha * term.first,
+                                     m_shift / term.first, arg, beta);
+      } else {
+        term.second->apply_add(result, alpha * term.first, arg, beta);
+      }
+      beta = 1;
+    }
+  }
+
+  template <typename V>
+  void LinearCombinationOperator<V>::apply_transpose(Vector& result,
+                                                     const Vector& arg)
+  {
+    // the diagonal part is symmetric
+    bool overwrite = true;
+    if (m_shift != Number(0) || !m_diagonals.empty()) {
+      apply_diagonal_part(result, 1, m_shift, arg, 0);
+      overwrite = false;
+    }
+
+    std::unique_ptr<V> tmp;
+    for (const auto& term : m_terms) {
+      if (overwrite) {
+        term.second->apply_transpose(result, arg);
+        if (term.first != Number(1))
+          result *= term.first;
+        overwrite = false;
+      } else {
+        if (!tmp)
+          tmp = allocate_like(arg);
+        term.second->apply_transpose(*tmp, arg);
+        result.add_scaled(term.first, *tmp);
+      }
+    }
+
+    if (overwrite)
+      result.fill(0);
+  }
+
+  template <typename V>
+  void LinearCombinationOperator<V>::apply_diagonal_part(Vector& result,
+                                                         Number alpha,
+                                                         Number shift,
+                                                         const Vector& arg,
+                                                         Number beta)
+  {
+    auto y = local_slice(result);
+    auto x = local_slice(arg);
+
+    std::vector<LocalSlice<const VectorStorage<Number>*>> d_slices;
+    std::vector<std::pair<Number, const Number*>> d;
+    d_slices.reserve(m_diagonals.size());
+    d.reserve(m_diagonals.size());
+    for (const auto& diagonal : m_diagonals) {
+      d_slices.push_back(local_slice(*diagonal.second));
+      d.emplace_back(diagonal.first, d_slices.back().data());
+    }
+
+    detail::apply_pointwise(y.data(), alpha, shift, d, x.data(), beta,
+                            y.size());
+  }
+
+  template <typename V>
+  void LinearCombinationOperator<V>::apply_pointwise(Vector& vec, Number alpha)
+  {
+    auto y = local_slice(vec);
+
+    std::vector<LocalSlice<const VectorStorage<Number>*>> d_slices;
+    std::vector<std::pair<Number, const Number*>> d;
+    d_slices.reserve(m_diagonals.size());
+    d.reserve(m_diagonals.size());
+    for (const auto& diagonal : m_diagonals) {
+      d_slices.push_back(local_slice(*diagonal.second));
+      d.emplace_back(diagonal.first, d_slices.back().data());
+    }
+
+    detail::apply_pointwise(y.data(), alpha, m_shift, d, y.data(), Number(0),
+                            y.size());
+  }
+
+  /**
+   @brief Lazy composition `A B` of two square linear operators.
+
+   The intermediate vector `B arg` is allocated once, at the first
+   application. If `A` is a pure diagonal operator and the result is
+   overwritten, `B` is applied into the result, which is then scaled in
+   place, without the intermediate vector.
+   */
+  template <typename V>
+  class ComposedOperator final : public LinearOperator<V> {
+    public:
+      using typename LinearOperator<V>::Vector;
+      using typename LinearOperator<V>::Number;
+
+      ComposedOperator(std::shared_ptr<LinearOperator<V>> left,
+                       std::shared_ptr<LinearOperator<V>> right)
+        : m_left(std::move(left)), m_right(std::move(right))
+      {}
+
+      void apply(Vector& result, const Vector& arg) override {
+        apply_add(result, 1, arg, 0);
+      }
+
+      void apply_add(Vector& result,
+                     Number alpha,
+                     const Vector& arg,
+                     Number beta) override
+      {
+        auto diagonal
+          = dynamic_cast<LinearCombinationOperator<V>*>(m_left.get());
+        if (beta == Number(0) && diagonal != nullptr
+            && diagonal->terms().empty()) {
+          m_right->apply(result, arg);
+          diagonal->apply_pointwise(result, alpha);
+          return;
+        }
+
+        if (!m_intermediate)
+          m_intermediate = allocate_like(arg);
+        m_right->apply(*m_intermediate, arg);
+        m_left->apply_add(result, alpha, *m_intermediate, beta);
+      }
+
+      /** Computes `result = B^T A^T arg`. */
+      void apply_transpose(Vector& result, const Vector& arg) override
+      {
+        if (!m_intermediate)
+          m_intermediate = allocate_like(arg);
+        m_left->apply_transpose(*m_intermediate, arg);
+        m_right->apply_transpose(result, *m_intermediate);
+      }
+
+      const std::shared_ptr<LinearOperator<V>>& left() const { return m_left; }
+      const std::shared_ptr<LinearOperator<V>>& right() const { return m_right; }
+
+    private:
+      std::shared_ptr<LinearOperator<V>> m_left;
+      std::shared_ptr<LinearOperator<V>> m_right;
+      std::unique_ptr<V> m_intermediate;
+  };
+
+  /// @cond INTERNAL
+  namespace detail {
+    /** Returns the operator as a linear combination, without nesting. */
+    template <typename V>
+    LinearCombinationOperator<V>
+      as_linear_combination(std::shared_ptr<LinearOperator<V>> op)
+    {
+      auto combination
+        = std::dynamic_pointer_cast<LinearCombinationOperator<V>>(op);
+      if (combination)
+        return *combination;
+
+      using Term = typename LinearCombinationOperator<V>::Term;
+      return LinearCombinationOperator<V>({ Term(1, std::move(op)) });
+    }
+  }
+  /// @endcond
+
+  /** Returns the lazy sum `a + b` of two operators. */
+  template <typename A, typename B>
+  std::shared_ptr<LinearOperator<typename A::Vector>>
+    operator_sum(std::shared_ptr<A> a, std::shared_ptr<B> b)
+  {
+    using V = typename A::Vector;
+    auto lhs = detail::as_linear_combination<V>(std::move(a));
+    auto rhs = detail::as_linear_combination<V>(std::move(b));
+
+    auto terms = lhs.terms();
+    terms.insert(terms.end(), rhs.terms().begin(), rhs.terms().end());
+    auto diagonals = lhs.diagonals();
+    diagonals.insert(diagonals.end(),
+                     rhs.diagonals().begin(), rhs.diagonals().end());
+
+    return std::make_shared<LinearCombinationOperator<V>>(
+             std::move(terms), lhs.shift() + rhs.shift(), std::move(diagonals));
+  }
+
+  /** Returns the lazy product `alpha a` of a scalar and an operator. */
+  template <typename A>
+  std::shared_ptr<LinearOperator<typename A::Vector>>
+    scaled_operator(typename A::Number alpha, std::shared_ptr<A> a)
+  {
+    using V = typename A::Vector;
+    auto combination = detail::as_linear_combination<V>(std::move(a));
+
+    auto terms = combination.terms();
+    for (auto& term : terms) {
+      term.first *= alpha;
+    }
+    auto diagonals = combination.diagonals();
+    for (auto& diagonal : diagonals) {
+      diagonal.first *= alpha;
+    }
+
+    return std::make_shared<LinearCombinationOperator<V>>(
+             std::move(terms), alpha * combination.shift(), std::move(diagonals));
+  }
+
+  /** Returns the lazy operator `a + shift I`. */
+  template <typename A>
+  std::shared_ptr<LinearOperator<typename A::Vector>>
+    shifted_operator(std::shared_ptr<A> a, typename A::Number shift)
+  {
+    using V = typename A::Vector;
+    auto combination = detail::as_linear_combination<V>(std::move(a));
+
+    return std::make_shared<LinearCombinationOperator<V>>(
+             combination.terms(),
+             combination.shift() + shift,
+             combination.diagonals());
+  }
+
+  /**
+   Returns the diagonal operator `diag(d)`, which multiplies pointwise by
+   the given vector. The vector is referenced, not copied.
+   */
+  template <typename V>
+  std::shared_ptr<LinearOperator<std::remove_const_t<V>>>
+    diagonal_operator(std::shared_ptr<V> d)
+  {
+    using Vector = std::remove_const_t<V>;
+    using Diagonal = typename LinearCombinationOperator<Vector>::DiagonalTerm;
+
+    return std::make_shared<LinearCombinationOperator<Vector>>(
+             std::vector<typename LinearCombinationOperator<Vector>::Term>(),
+             0,
+             std::vector<Diagonal>({ Diagonal(1, std::move(d)) }));
+  }
+
+  /**
+   Returns the lazy composition `a b`, i.e., the operator that applies `b`
+   first and `a` second. Combined with diagonal_operator, it implements the
+   diagonal scaling `diag(d) b`.
+   */
+  template <typename A, typename B>
+  std::shared_ptr<LinearOperator<typename A::Vector>>
+    composed_operator(std::shared_ptr<A> a, std::shared_ptr<B> b)
+  {
+    using V = typename A::Vector;
+    return std::make_shared<ComposedOperator<V>>(std::move(a), std::move(b));
+  }
+
+  /// @}
+}
+
+#endif
@@ -0,0 +1,48 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "petsc_multi_vector.hpp"
+
+#ifdef ALLIUM_USE_PETSC
+
+#include "petsc_util.hpp"
+
+namespace allium {
+
+  PetscMultiVector::PetscMultiVector(VectorSpec spec, size_t count)
+    : MultiVector<PetscScalar, Eigen::ColMajor>(spec, count)
+  {
+    using namespace petsc;
+    PetscErrorCode ierr;
+
+    const size_t local_size = spec.local_size();
+    PetscScalar* data = native().data();
+
+    m_vectors.reserve(count);
+    for (size_t i_vector = 0; i_vector < count; ++i_vector) {
+      PetscObjectPtr<Vec> vec;
+      ierr = VecCreateMPIWithArray(spec.comm().handle(),
+                                   1, // block size
+                                   local_size,
+                                   spec.global_size(),
+                                   data + i_vector * local_size,
+                                   vec.writable_ptr()); chkerr(ierr);
+      m_vectors.push_back(
+        std::unique_ptr<PetscVectorStorage<PetscScalar>>(
+          new PetscVectorStorage<PetscScalar>(vec)));
+    }
+  }
+}
+
+#endif
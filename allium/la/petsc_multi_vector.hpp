@@ -0,0 +1,55 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_PETSC_MULTI_VECTOR_HPP
+#define ALLIUM_LA_PETSC_MULTI_VECTOR_HPP
+
+#include <allium/config.hpp>
+#ifdef ALLIUM_USE_PETSC
+
+#include "multi_vector.hpp"
+#include "petsc_vector.hpp"
+#include <memory>
+#include <vector>
+
+namespace allium {
+
+  /**
+    @brief A MultiVector, whose vectors are also available as PETSc vectors.
+
+    The vectors are stored contiguously in one array, which is shared with
+    an array of PETSc vectors created by `VecCreateMPIWithArray`. Hence,
+    the vectors can be passed to PETSc, e.g., to a PETSc matrix, without
+    copies, while the block operations still use the dense kernels.
+   */
+  class PetscMultiVector final : public MultiVector<PetscScalar, Eigen::ColMajor>
+  {
+    public:
+      PetscMultiVector(VectorSpec spec, size_t count);
+
+      PetscMultiVector(const PetscMultiVector&) = delete;
+      PetscMultiVector& operator= (const PetscMultiVector&) = delete;
+
+      /** The `i_vector`-th vector, which refers to the block storage. */
+      PetscVectorStorage<PetscScalar>& vector(size_t i_vector) {
+        return *m_vectors.at(i_vector);
+      }
+
+    private:
+      std::vector<std::unique_ptr<PetscVectorStorage<PetscScalar>>> m_vectors;
+  };
+}
+
+#endif
+#endif
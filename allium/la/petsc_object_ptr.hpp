@@ -45,6 +45,7 @@ template<> struct is_petsc_object<KSP> : std::true_type {};
 template<> struct is_petsc_object<PC>  : std::true_type {};
 template<> struct is_petsc_object<TS>  : std::true_type {};
 template<> struct is_petsc_object<DM>  : std::true_type {};
+template<> struct is_petsc_object<MatFDColoring> : std::true_type {};
 #ifdef USE_SLEPC
 template<> struct is_petsc_object<EPS> : std::true_type {};
 #endif
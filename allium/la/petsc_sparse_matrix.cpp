@@ -13,6 +13,8 @@
 // limitations under the License.
 
 #include "petsc_sparse_matrix.hpp"
+#include "entry_exchange.hpp"
+#include "local_csr_matrix.hpp"
 
 #ifdef ALLIUM_USE_PETSC
 
@@ -72,6 +74,36 @@ namespace allium {
   {
   }
 
+  PetscSparseMatrixStorage<PetscScalar>::PetscSparseMatrixStorage(
+      VectorSpec rows,
+      VectorSpec cols,
+      PetscObjectPtr<Mat> mat)
+    : SparseMatrixStorage(rows, cols),
+      ptr(mat)
+  {
+    PetscErrorCode ierr;
+
+    PetscInt local_rows, local_cols;
+    ierr = MatGetLocalSize(ptr, &local_rows, &local_cols); chkerr(ierr);
+    if (static_cast<size_t>(local_rows) != rows.local_size()
+        || static_cast<size_t>(local_cols) != cols.local_size()) {
+      throw std::invalid_argument("The matrix size does not match the vector specifications.");
+    }
+
+    PetscInt row_start, row_end;
+    ierr = MatGetOwnershipRange(ptr, &row_start, &row_end); chkerr(ierr);
+
+    m_pattern_row_ptr.assign(1, 0);
+    m_pattern_cols.clear();
+    for (PetscInt i_row = row_start; i_row < row_end; ++i_row) {
+      PetscMatRow row(ptr, i_row);
+      for (global_size_t i_col_entry = 0; i_col_entry < row.ncols(); ++i_col_entry) {
+        m_pattern_cols.push_back(row.col(i_col_entry));
+      }
+      m_pattern_row_ptr.push_back(m_pattern_cols.size());
+    }
+  }
+
   void PetscSparseMatrixStorage<PetscScalar>::set_entries(LocalCooMatrix<PetscScalar> mat)
   {
     PetscErrorCode ierr;
@@ -81,23 +113,114 @@ namespace allium {
         "PETSc requires the row and column communicator to be the same");
     }
 
-    // ToDo: Create interface to d_nz and o_nz
+    global_size_t row_start = row_spec().local_start();
+    global_size_t row_end = row_spec().local_end();
+    global_size_t col_start = col_spec().local_start();
+    global_size_t col_end = col_spec().local_end();
+
+    // Entries of rows that are owned by other ranks are sent to their owner
+    // in one exchange, instead of passing them to PETSc one by one.
+    mat = detail::send_remote_entries(row_spec(), std::move(mat));
+
+    // All ranks have to agree on an invalid entry before throwing, since the
+    // others would wait in MatCreateAIJ otherwise.
+    int invalid = 0;
+    for (auto col : mat.col_ind()) {
+      if (col >= col_spec().global_size()) {
+        invalid = 1;
+        break;
+      }
+    }
+    if (row_spec().comm().sum_allreduce(invalid) > 0) {
+      throw std::out_of_range("Matrix entry is out of the column range.");
+    }
+
+    // the local rows are sorted and their duplicates are summed first, such
+    // that they can be preallocated exactly and passed row by row
+    LocalCsrMatrix<PetscScalar> csr(row_end - row_start,
+                                    col_spec().global_size(),
+                                    mat,
+                                    row_start);
+
+    // the diagonal block consists of the locally owned columns
+    std::vector<PetscInt> d_nnz(csr.rows(), 0);
+    std::vector<PetscInt> o_nnz(csr.rows(), 0);
+    for (size_t i_row = 0; i_row < csr.rows(); ++i_row) {
+      for (size_t i_entry = csr.row_ptr()[i_row];
+           i_entry < csr.row_ptr()[i_row+1];
+           ++i_entry)
+      {
+        global_size_t col = csr.col_ind()[i_entry];
+        if (col >= col_start && col < col_end)
+          ++d_nnz[i_row];
+        else
+          ++o_nnz[i_row];
+      }
+    }
+
     ierr = MatCreateAIJ(row_spec().comm().handle(), // comm,
                         row_spec().local_size(), // local rows
                         col_spec().local_size(), // local cols
                         row_spec().global_size(), // global rows
                         col_spec().global_size(),  // global cols
-                        10, // d_nz
-                        NULL, // d_nnz
-                        10, // o_nz,
-                        NULL, // o_nnz,
+                        0, // d_nz
+                        d_nnz.data(), // d_nnz
+                        0, // o_nz,
+                        o_nnz.data(), // o_nnz,
                         ptr.writable_ptr()); chkerr(ierr);
 
-    auto entries = std::move(mat).entries();
+    // all entries are local, the assembly does not need to communicate
+    ierr = MatSetOption(ptr, MAT_NO_OFF_PROC_ENTRIES, PETSC_TRUE);
+    chkerr(ierr);
 
-    // @ToDo This is probably slow and can be optimized by using MatSetValues
-    for (auto& e : entries) {
-      ierr = MatSetValue(ptr, e.row(), e.col(), e.value(), ADD_VALUES);
+    std::vector<PetscInt> cols;
+    for (size_t i_row = 0; i_row < csr.rows(); ++i_row) {
+      size_t begin = csr.row_ptr()[i_row];
+      size_t end = csr.row_ptr()[i_row+1];
+      if (begin == end)
+        continue;
+
+      cols.assign(csr.col_ind().begin() + begin, csr.col_ind().begin() + end);
+      PetscInt row = row_start + i_row;
+      ierr = MatSetValues(ptr,
+                          1, &row,
+                          end - begin, cols.data(),
+                          csr.values().data() + begin,
+                          ADD_VALUES);
+      chkerr(ierr);
+    }
+
+    ierr = MatAssemblyBegin(ptr, MAT_FINAL_ASSEMBLY); chkerr(ierr);
+    ierr = MatAssemblyEnd(ptr, MAT_FINAL_ASSEMBLY); chkerr(ierr);
+
+    m_pattern_row_ptr.assign(csr.row_ptr().begin(), csr.row_ptr().end());
+    m_pattern_cols.assign(csr.col_ind().begin(), csr.col_ind().end());
+  }
+
+  void PetscSparseMatrixStorage<PetscScalar>::set_values(
+    const std::vector<PetscScalar>& values)
+  {
+    PetscErrorCode ierr;
+
+    if (values.size() != m_pattern_cols.size()) {
+      throw std::invalid_argument("The value count does not match the sparsity pattern.");
+    }
+
+    // The matrix object is kept, such that PETSc preconditioners only
+    // recompute their numeric part.
+    PetscInt row_start = row_spec().local_start();
+    for (size_t i_row = 0; i_row + 1 < m_pattern_row_ptr.size(); ++i_row) {
+      size_t begin = m_pattern_row_ptr[i_row];
+      size_t end = m_pattern_row_ptr[i_row+1];
+      if (begin == end)
+        continue;
+
+      PetscInt row = row_start + i_row;
+      ierr = MatSetValues(ptr,
+                          1, &row,
+                          end - begin, m_pattern_cols.data() + begin,
+                          values.data() + begin,
+                          INSERT_VALUES);
       chkerr(ierr);
     }
 
@@ -133,6 +256,64 @@ namespace allium {
     ierr = MatMult(ptr, arg.native(), result.native()); chkerr(ierr);
   }
 
+  void PetscSparseMatrixStorage<PetscScalar>
+          ::apply_add(PetscAbstractVectorStorage<PetscScalar>& result,
+                      PetscScalar alpha,
+                      const PetscAbstractVectorStorage<PetscScalar>& arg,
+                      PetscScalar beta)
+  {
+    PetscErrorCode ierr;
+
+    if (beta == PetscScalar(0)) {
+      ierr = MatMult(ptr, arg.native(), result.native()); chkerr(ierr);
+      if (alpha != PetscScalar(1)) {
+        ierr = VecScale(result.native(), alpha); chkerr(ierr);
+      }
+      return;
+    }
+
+    if (alpha == PetscScalar(1)) {
+      if (beta != PetscScalar(1)) {
+        ierr = VecScale(result.native(), beta); chkerr(ierr);
+      }
+      ierr = MatMultAdd(ptr, arg.native(), result.native(), result.native());
+      chkerr(ierr);
+      return;
+    }
+
+    // the product goes to a work vector, which is combined with the result
+    // in a single sweep
+    if (!m_work) {
+      ierr = VecDuplicate(result.native(), m_work.writable_ptr()); chkerr(ierr);
+    }
+    ierr = MatMult(ptr, arg.native(), m_work); chkerr(ierr);
+    ierr = VecAXPBY(result.native(), alpha, beta, m_work); chkerr(ierr);
+  }
+
+  void PetscSparseMatrixStorage<PetscScalar>
+          ::apply_transpose(PetscAbstractVectorStorage<PetscScalar>& result,
+                            const PetscAbstractVectorStorage<PetscScalar>& arg)
+  {
+    PetscErrorCode ierr;
+
+    ierr = MatMultTranspose(ptr, arg.native(), result.native()); chkerr(ierr);
+  }
+
+  void PetscSparseMatrixStorage<PetscScalar>
+          ::apply_block(MultiVector<PetscScalar, Eigen::RowMajor>& result,
+                        const MultiVector<PetscScalar, Eigen::RowMajor>& arg)
+  {
+    check_block_sizes(result, arg);
+
+    PetscVectorStorage<PetscScalar> x(col_spec());
+    PetscVectorStorage<PetscScalar> y(row_spec());
+    for (size_t i = 0; i < arg.count(); ++i) {
+      arg.get(i, x);
+      apply(y, x);
+      result.set(i, y);
+    }
+  }
+
 }
 
 #endif
@@ -46,13 +46,48 @@ namespace allium {
 
       PetscSparseMatrixStorage(VectorSpec rows, VectorSpec cols);
 
+      /**
+       Wraps an assembled PETSc matrix, e.g., one created by
+       `DMCreateMatrix`. Its layout must match the vector specifications.
+       */
+      PetscSparseMatrixStorage(VectorSpec rows,
+                               VectorSpec cols,
+                               PetscObjectPtr<Mat> mat);
+
       void set_entries(LocalCooMatrix<Number> mat) override;
       LocalCooMatrix<Number> get_entries() override;
+      void set_values(const std::vector<Number>& values) override;
 
       void apply(PetscAbstractVectorStorage<PetscScalar>& result,
                  const PetscAbstractVectorStorage<PetscScalar>& arg) override;
+
+      /**
+       Uses `MatMultAdd` for `alpha = 1`. Otherwise, the product is stored
+       in a work vector, which is allocated at the first call.
+       */
+      void apply_add(PetscAbstractVectorStorage<PetscScalar>& result,
+                     PetscScalar alpha,
+                     const PetscAbstractVectorStorage<PetscScalar>& arg,
+                     PetscScalar beta) override;
+
+      void apply_transpose(PetscAbstractVectorStorage<PetscScalar>& result,
+                           const PetscAbstractVectorStorage<PetscScalar>& arg) override;
+
+      /**
+       Applies `MatMult` to each vector. The vectors are copied through two
+       PETSc vectors, since PETSc has no product with interleaved vectors.
+       */
+      void apply_block(MultiVector<PetscScalar, Eigen::RowMajor>& result,
+                       const MultiVector<PetscScalar, Eigen::RowMajor>& arg) override;
+
+      PetscObjectPtr<Mat> native() const { return ptr; }
     private:
       PetscObjectPtr<Mat> ptr;
+      PetscObjectPtr<Vec> m_work;
+
+      // the sparsity pattern of the local rows, for set_values
+      std::vector<size_t> m_pattern_row_ptr;
+      std::vector<PetscInt> m_pattern_cols;
   };
 
   template <typename N>
@@ -71,35 +106,32 @@ namespace allium {
       {}
 
       void set_entries(LocalCooMatrix<Number> mat) override {
-        std::vector<MatrixEntry<N>> entries = std::move(mat).entries();
-
-        std::vector<MatrixEntry<PetscScalar>> converted(entries.size());
-        std::transform(entries.begin(), entries.end(),
-                       converted.begin(),
-                       [](MatrixEntry<N> e) -> MatrixEntry<PetscScalar> {
-                         return MatrixEntry<PetscScalar>(
-                                  e.row(),
-                                  e.col(),
-                                  e.value());
-                       });
-
-        m_native.set_entries(LocalCooMatrix<PetscScalar>(converted));
+        LocalCooMatrix<PetscScalar> converted;
+        converted.reserve(mat.entry_count());
+        for (auto e : mat.entries()) {
+          converted.add(e.row(), e.col(), e.value());
+        }
+
+        m_native.set_entries(std::move(converted));
       }
 
       LocalCooMatrix<Number> get_entries() override {
-        std::vector<MatrixEntry<PetscScalar>> entries = m_native.get_entries().entries();
-
-        std::vector<MatrixEntry<N>> converted(entries.size());
-        std::transform(entries.begin(), entries.end(),
-                       converted.begin(),
-                       [](MatrixEntry<PetscScalar> e) {
-                         return MatrixEntry<N>(
-                                  e.row(),
-                                  e.col(),
-                                  narrow_number<N, PetscScalar>()(e.value()));
-                       });
-
-        return LocalCooMatrix<N>(converted);
+        auto native_entries = m_native.get_entries();
+
+        LocalCooMatrix<N> converted;
+        converted.reserve(native_entries.entry_count());
+        for (auto e : native_entries.entries()) {
+          converted.add(e.row(),
+                        e.col(),
+                        narrow_number<N, PetscScalar>()(e.value()));
+        }
+
+        return converted;
+      }
+
+      void set_values(const std::vector<Number>& values) override {
+        m_native.set_values(
+          std::vector<PetscScalar>(values.begin(), values.end()));
       }
 
       void apply(PetscAbstractVectorStorage<N>& result,
@@ -108,6 +140,21 @@ namespace allium {
         m_native.apply(result.native_scalar(), arg.native_scalar());
       }
 
+      void apply_add(PetscAbstractVectorStorage<N>& result,
+                     N alpha,
+                     const PetscAbstractVectorStorage<N>& arg,
+                     N beta) override
+      {
+        m_native.apply_add(result.native_scalar(), alpha,
+                           arg.native_scalar(), beta);
+      }
+
+      void apply_transpose(PetscAbstractVectorStorage<N>& result,
+                           const PetscAbstractVectorStorage<N>& arg) override
+      {
+        m_native.apply_transpose(result.native_scalar(), arg.native_scalar());
+      }
+
     private:
       PetscSparseMatrixStorage<PetscScalar> m_native;
   };
@@ -0,0 +1,151 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "reordering.hpp"
+#include <numeric>
+
+namespace allium {
+
+  Permutation::Permutation(std::vector<global_size_t> old_indices)
+    : m_old_indices(std::move(old_indices)),
+      m_new_indices(m_old_indices.size(), m_old_indices.size())
+  {
+    const global_size_t size = m_old_indices.size();
+    for (global_size_t i = 0; i < size; ++i) {
+      global_size_t old = m_old_indices[i];
+      if (old >= size || m_new_indices[old] != size) {
+        throw std::invalid_argument("The indices are no permutation.");
+      }
+      m_new_indices[old] = i;
+    }
+  }
+
+  Permutation Permutation::identity(global_size_t size)
+  {
+    std::vector<global_size_t> old_indices(size);
+    std::iota(old_indices.begin(), old_indices.end(), 0);
+    return Permutation(std::move(old_indices));
+  }
+
+  Permutation Permutation::inverse() const
+  {
+    return Permutation(m_new_indices);
+  }
+
+  namespace {
+    /**
+     Breadth-first search from `start`, which appends the visited nodes
+     to `order`. The neighbors of each node are visited in the order of
+     increasing degree. Returns the number of levels and stores the
+     position of the first node of the last level in `last_level`.
+     */
+    size_t cuthill_mckee_level(const std::vector<size_t>& adj_ptr,
+                               const std::vector<global_size_t>& adj,
+                               global_size_t start,
+                               std::vector<char>& visited,
+                               std::vector<global_size_t>& order,
+                               size_t& last_level)
+    {
+      auto degree = [&](global_size_t i) { return adj_ptr[i+1] - adj_ptr[i]; };
+
+      size_t level_begin = order.size();
+      order.push_back(start);
+      visited[start] = true;
+
+      size_t level_count = 0;
+      while (level_begin < order.size()) {
+        last_level = level_begin;
+        size_t level_end = order.size();
+        for (size_t i_node = level_begin; i_node < level_end; ++i_node) {
+          global_size_t node = order[i_node];
+          size_t children_begin = order.size();
+          for (size_t i_adj = adj_ptr[node]; i_adj < adj_ptr[node+1]; ++i_adj) {
+            if (!visited[adj[i_adj]]) {
+              visited[adj[i_adj]] = true;
+              order.push_back(adj[i_adj]);
+            }
+          }
+          std::stable_sort(order.begin() + children_begin, order.end(),
+                           [&](global_size_t a, global_size_t b) {
+                             return degree(a) < degree(b);
+                           });
+        }
+        level_begin = level_end;
+        ++level_count;
+      }
+      return level_count;
+    }
+  }
+
+  Permutation reverse_cuthill_mckee(const std::vector<size_t>& adj_ptr,
+                                    const std::vector<global_size_t>& adj)
+  {
+    const global_size_t size = adj_ptr.size() - 1;
+    auto degree = [&](global_size_t i) { return adj_ptr[i+1] - adj_ptr[i]; };
+
+    std::vector<char> visited(size, false);
+    std::vector<char> probe_visited(size, false);
+    std::vector<global_size_t> order;
+    std::vector<global_size_t> probe;
+    order.reserve(size);
+
+    // Process the nodes in the order of increasing degree, such that each
+    // component is started close to its periphery.
+    std::vector<global_size_t> by_degree(size);
+    std::iota(by_degree.begin(), by_degree.end(), 0);
+    std::stable_sort(by_degree.begin(), by_degree.end(),
+                     [&](global_size_t a, global_size_t b) {
+                       return degree(a) < degree(b);
+                     });
+
+    for (auto candidate : by_degree) {
+      if (visited[candidate])
+        continue;
+
+      // Find a pseudo-peripheral node: move to a node of minimal degree
+      // in the last level, as long as the number of levels increases.
+      global_size_t start = candidate;
+      size_t levels = 0;
+      while (true) {
+        probe.clear();
+        size_t last_level;
+        size_t new_levels = cuthill_mckee_level(adj_ptr, adj, start,
+                                                probe_visited, probe,
+                                                last_level);
+        for (auto i : probe) {
+          probe_visited[i] = false;
+        }
+
+        if (new_levels <= levels)
+          break;
+        levels = new_levels;
+
+        global_size_t next = probe[last_level];
+        for (size_t i = last_level; i < probe.size(); ++i) {
+          if (degree(probe[i]) < degree(next))
+            next = probe[i];
+        }
+        if (next == start)
+          break;
+        start = next;
+      }
+
+      size_t last_level;
+      cuthill_mckee_level(adj_ptr, adj, start, visited, order, last_level);
+    }
+
+    std::reverse(order.begin(), order.end());
+    return Permutation(std::move(order));
+  }
+}
@@ -0,0 +1,223 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_REORDERING_HPP
+#define ALLIUM_LA_REORDERING_HPP
+
+#include "local_coo_matrix.hpp"
+#include "vector_storage.hpp"
+#include <allium/util/types.hpp>
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+namespace allium {
+
+  /**
+   @brief A renumbering of the indices `0, ..., size()-1`.
+
+   The entry with the old index `old_index(i)` gets the new index `i`.
+   */
+  class Permutation {
+    public:
+      Permutation() {}
+
+      /** Creates the permutation from the old index of every new index. */
+      explicit Permutation(std::vector<global_size_t> old_indices);
+
+      static Permutation identity(global_size_t size);
+
+      global_size_t size() const { return m_old_indices.size(); }
+
+      global_size_t old_index(global_size_t new_index) const {
+        return m_old_indices[new_index];
+      }
+
+      global_size_t new_index(global_size_t old_index) const {
+        return m_new_indices[old_index];
+      }
+
+      Permutation inverse() const;
+
+    private:
+      std::vector<global_size_t> m_old_indices;
+      std::vector<global_size_t> m_new_indices;
+  };
+
+  /**
+   @brief Reverse Cuthill-McKee ordering of an undirected graph.
+
+   The graph is given in CSR format, i.e., the neighbors of the node `i`
+   are `adj[adj_ptr[i]]`, ..., `adj[adj_ptr[i+1]-1]`. The adjacency has to
+   be symmetric. Each connected component is numbered starting from a
+   pseudo-peripheral node.
+   */
+  Permutation reverse_cuthill_mckee(const std::vector<size_t>& adj_ptr,
+                                    const std::vector<global_size_t>& adj);
+
+  /**
+   @brief Reverse Cuthill-McKee ordering for the given matrix.
+
+   The ordering reduces the bandwidth of the matrix, such that the
+   entries of the vectors, which are accessed by neighboring rows, are
+   close to each other in memory. It uses the sparsity pattern of
+   `A + A^T`; the values are not used. The matrix has to be square
+   with the given number of rows and it must not be distributed.
+   */
+  template <typename N>
+  Permutation reverse_cuthill_mckee(const LocalCooMatrix<N>& mat,
+                                    global_size_t size)
+  {
+    const auto& rows = mat.row_ind();
+    const auto& cols = mat.col_ind();
+    const size_t entry_count = mat.entry_count();
+
+    // count both directions of every off-diagonal entry
+    std::vector<size_t> adj_ptr(size + 1, 0);
+    for (size_t i_entry = 0; i_entry < entry_count; ++i_entry) {
+      if (rows[i_entry] >= size || cols[i_entry] >= size)
+        throw std::out_of_range("Matrix entry out of range.");
+
+      if (rows[i_entry] != cols[i_entry]) {
+        ++adj_ptr[rows[i_entry] + 1];
+        ++adj_ptr[cols[i_entry] + 1];
+      }
+    }
+    for (global_size_t i = 0; i < size; ++i) {
+      adj_ptr[i+1] += adj_ptr[i];
+    }
+
+    std::vector<global_size_t> adj(adj_ptr[size]);
+    std::vector<size_t> pos(adj_ptr.begin(), adj_ptr.end() - 1);
+    for (size_t i_entry = 0; i_entry < entry_count; ++i_entry) {
+      if (rows[i_entry] != cols[i_entry]) {
+        adj[pos[rows[i_entry]]++] = cols[i_entry];
+        adj[pos[cols[i_entry]]++] = rows[i_entry];
+      }
+    }
+
+    // remove duplicate edges, which would distort the degrees
+    size_t i_out = 0;
+    size_t row_begin = 0;
+    for (global_size_t i = 0; i < size; ++i) {
+      auto begin = adj.begin() + row_begin;
+      auto end = adj.begin() + adj_ptr[i+1];
+      std::sort(begin, end);
+      auto unique_end = std::unique(begin, end);
+
+      row_begin = adj_ptr[i+1];
+      adj_ptr[i+1] = i_out + (unique_end - begin);
+      std::copy(begin, unique_end, adj.begin() + i_out);
+      i_out = adj_ptr[i+1];
+    }
+    adj.resize(i_out);
+
+    return reverse_cuthill_mckee(adj_ptr, adj);
+  }
+
+  /**
+   @brief The largest distance `|i - j|` of an entry `(i, j)` of the matrix
+   to the diagonal.
+   */
+  template <typename N>
+  global_size_t bandwidth(const LocalCooMatrix<N>& mat)
+  {
+    global_size_t result = 0;
+    for (size_t i_entry = 0; i_entry < mat.entry_count(); ++i_entry) {
+      global_size_t row = mat.row_ind()[i_entry];
+      global_size_t col = mat.col_ind()[i_entry];
+      result = std::max(result, row > col ? row - col : col - row);
+    }
+    return result;
+  }
+
+  /**
+   @brief Renumbers the rows and columns of a square matrix, i.e., computes
+   `P A P^T`.
+   */
+  template <typename N>
+  LocalCooMatrix<N> permute(const LocalCooMatrix<N>& mat,
+                            const Permutation& perm)
+  {
+    LocalCooMatrix<N> result;
+    result.reserve(mat.entry_count());
+    for (size_t i_entry = 0; i_entry < mat.entry_count(); ++i_entry) {
+      result.add(perm.new_index(mat.row_ind()[i_entry]),
+                 perm.new_index(mat.col_ind()[i_entry]),
+                 mat.values()[i_entry]);
+    }
+    return result;
+  }
+
+  /** @brief Reverts permute(const LocalCooMatrix<N>&, const Permutation&). */
+  template <typename N>
+  LocalCooMatrix<N> unpermute(const LocalCooMatrix<N>& mat,
+                              const Permutation& perm)
+  {
+    return permute(mat, perm.inverse());
+  }
+
+  /**
+   @brief Renumbers the entries of a vector consistently with
+   permute(const LocalCooMatrix<N>&, const Permutation&), i.e., computes
+   `result = P arg`.
+
+   The vectors must not be distributed.
+   */
+  template <typename N>
+  void permute(VectorStorage<N>& result,
+               const VectorStorage<N>& arg,
+               const Permutation& perm)
+  {
+    auto result_spec = result.spec();
+    if (result_spec != arg.spec()
+        || result_spec.local_size() != perm.size()
+        || result_spec.global_size() != perm.size()) {
+      throw std::invalid_argument(
+        "The permutation requires undistributed vectors of equal size.");
+    }
+
+    auto lresult = local_slice(result);
+    auto larg = local_slice(arg);
+    for (global_size_t i = 0; i < perm.size(); ++i) {
+      lresult[i] = larg[perm.old_index(i)];
+    }
+  }
+
+  /**
+   @brief Reverts permute(VectorStorage<N>&, const VectorStorage<N>&, const Permutation&),
+   i.e., computes `result = P^T arg`.
+   */
+  template <typename N>
+  void unpermute(VectorStorage<N>& result,
+                 const VectorStorage<N>& arg,
+                 const Permutation& perm)
+  {
+    auto result_spec = result.spec();
+    if (result_spec != arg.spec()
+        || result_spec.local_size() != perm.size()
+        || result_spec.global_size() != perm.size()) {
+      throw std::invalid_argument(
+        "The permutation requires undistributed vectors of equal size.");
+    }
+
+    auto lresult = local_slice(result);
+    auto larg = local_slice(arg);
+    for (global_size_t i = 0; i < perm.size(); ++i) {
+      lresult[perm.old_index(i)] = larg[i];
+    }
+  }
+}
+
+#endif
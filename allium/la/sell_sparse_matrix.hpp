@@ -0,0 +1,107 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_SELL_SPARSE_MATRIX_HPP
+#define ALLIUM_LA_SELL_SPARSE_MATRIX_HPP
+
+#include "sparse_matrix.hpp"
+#include "eigen_vector.hpp"
+#include <allium/util/extern.hpp>
+#include <allium/util/parallel.hpp>
+#include <allium/util/memory.hpp>
+#include <Eigen/Core>
+
+namespace allium {
+
+  /**
+   @brief A sparse matrix in SELL-C-σ (sliced ELLPACK) format.
+
+   The rows are grouped into chunks of C rows, where C is the SIMD width of
+   the number type. The entries of a chunk are stored column by column, i.e.,
+   the j-th entries of all C rows are adjacent in memory, and shorter rows
+   are padded with zeros. Hence, the matrix-vector product processes C rows
+   at once with SIMD instructions.
+
+   To reduce the padding, the rows are sorted by their length within windows
+   of σ consecutive rows before they are grouped into chunks. A larger σ
+   reduces the padding but scatters the result vector over a larger range.
+
+   Like EigenVectorStorage, this matrix cannot be distributed.
+   */
+  template <typename N>
+  class SellSparseMatrixStorage final
+      : public SparseMatrixStorage<EigenVectorStorage<N>>
+  {
+    public:
+      using Vector = EigenVectorStorage<N>;
+      using DefaultVector = EigenVectorStorage<N>;
+      using typename SparseMatrixStorage<Vector>::Number;
+      using typename SparseMatrixStorage<Vector>::Real;
+      using SparseMatrixStorage<Vector>::row_spec;
+      using SparseMatrixStorage<Vector>::col_spec;
+
+      /** The number of rows per chunk (C). */
+      static constexpr int chunk_height
+        = Eigen::internal::packet_traits<N>::size;
+
+      /**
+       @param [in] sigma The size of the sorting window in rows (σ). It is
+                   rounded up to a multiple of the chunk height. A value of 1
+                   disables the sorting.
+       */
+      SellSparseMatrixStorage(VectorSpec rows,
+                              VectorSpec cols,
+                              size_t sigma = 32 * chunk_height);
+
+      void set_entries(LocalCooMatrix<N> lmat) override;
+      void set_csr(LocalCsrMatrix<N> mat) override;
+      LocalCooMatrix<N> get_entries() override;
+      void set_values(const std::vector<N>& values) override;
+
+      void apply(Vector& result, const Vector& arg) override;
+
+      /** The number of entries without padding divided by the number of
+          stored entries. */
+      double fill_ratio() const;
+
+      /**
+       Sets the number of threads used by the matrix-vector product,
+       independent of max_threads(). Zero, the default, uses max_threads().
+       */
+      void threads(int threads) { m_threads = threads; }
+      int threads() const { return m_threads > 0 ? m_threads : max_threads(); }
+
+    private:
+      size_t m_sigma;
+      size_t m_rows;
+
+      /// Position of the first entry of every chunk.
+      aligned_vector<size_t> m_chunk_ptr;
+      /// The row stored in every slot, or m_rows for padding rows.
+      aligned_vector<size_t> m_slot_row;
+      /// The number of (non-padding) entries of every slot.
+      aligned_vector<size_t> m_slot_length;
+      aligned_vector<global_size_t> m_col_ind;
+      aligned_vector<N> m_values;
+      /// The position of every entry in pattern order, i.e., row by row.
+      aligned_vector<size_t> m_entry_pos;
+      int m_threads = 0;
+  };
+
+  #define ALLIUM_SELL_SPARSE_MATRIX_DECL(extern, N) \
+    extern template class SellSparseMatrixStorage<N>;
+  ALLIUM_EXTERN_N(ALLIUM_SELL_SPARSE_MATRIX_DECL)
+}
+
+#endif
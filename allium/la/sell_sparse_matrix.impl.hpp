@@ -0,0 +1,233 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_SELL_SPARSE_MATRIX_IMPL_HPP
+#define ALLIUM_LA_SELL_SPARSE_MATRIX_IMPL_HPP
+
+#include "sell_sparse_matrix.hpp"
+
+#include "local_csr_matrix.hpp"
+#include <algorithm>
+#include <numeric>
+
+namespace allium {
+
+  template <typename N>
+  SellSparseMatrixStorage<N>::SellSparseMatrixStorage(VectorSpec rows,
+                                                      VectorSpec cols,
+                                                      size_t sigma)
+    : SparseMatrixStorage<Vector>(rows, cols),
+      m_sigma(std::max<size_t>(sigma, 1)),
+      m_rows(rows.local_size()),
+      m_chunk_ptr(1, 0)
+  {
+    if (rows.comm().size() != 1) {
+      throw std::logic_error("Objects of type SellSparseMatrixStorage cannot be distributed.");
+    }
+
+    if (m_sigma > 1) {
+      m_sigma = ((m_sigma + chunk_height - 1) / chunk_height) * chunk_height;
+    }
+
+    set_entries(LocalCooMatrix<N>());
+  }
+
+  template <typename N>
+  void SellSparseMatrixStorage<N>::set_entries(LocalCooMatrix<N> lmat)
+  {
+    set_csr(LocalCsrMatrix<N>(m_rows,
+                              col_spec().global_size(),
+                              lmat,
+                              row_spec().local_start()));
+  }
+
+  template <typename N>
+  void SellSparseMatrixStorage<N>::set_csr(LocalCsrMatrix<N> csr)
+  {
+    const size_t C = chunk_height;
+
+    this->check_csr_size(csr);
+    auto& row_ptr = csr.row_ptr();
+
+    size_t chunk_count = (m_rows + C - 1) / C;
+    size_t slot_count = chunk_count * C;
+
+    // sort the rows by decreasing length within each window
+    m_slot_row.resize(slot_count);
+    std::iota(m_slot_row.begin(), m_slot_row.end(), 0);
+
+    auto row_length = [&](size_t row) {
+      return row_ptr[row+1] - row_ptr[row];
+    };
+
+    if (m_sigma > 1) {
+      for (size_t i_begin = 0; i_begin < m_rows; i_begin += m_sigma) {
+        size_t i_end = std::min(i_begin + m_sigma, m_rows);
+        std::stable_sort(m_slot_row.begin() + i_begin,
+                         m_slot_row.begin() + i_end,
+                         [&](size_t a, size_t b) {
+                           return row_length(a) > row_length(b);
+                         });
+      }
+    }
+
+    m_slot_length.resize(slot_count);
+    for (size_t i_slot = 0; i_slot < slot_count; ++i_slot) {
+      if (i_slot < m_rows) {
+        m_slot_length[i_slot] = row_length(m_slot_row[i_slot]);
+      } else {
+        m_slot_row[i_slot] = m_rows;
+        m_slot_length[i_slot] = 0;
+      }
+    }
+
+    // every chunk is as wide as its longest row
+    m_chunk_ptr.resize(chunk_count + 1);
+    m_chunk_ptr[0] = 0;
+    for (size_t i_chunk = 0; i_chunk < chunk_count; ++i_chunk) {
+      size_t width = *std::max_element(m_slot_length.begin() + i_chunk * C,
+                                       m_slot_length.begin() + (i_chunk+1) * C);
+      m_chunk_ptr[i_chunk+1] = m_chunk_ptr[i_chunk] + width * C;
+    }
+
+    // store the entries column by column, the padding refers to the last
+    // column of the row (or column 0 for empty rows), such that it does not
+    // load additional cache lines of the argument
+    m_col_ind.resize(m_chunk_ptr[chunk_count]);
+    m_values.resize(m_chunk_ptr[chunk_count]);
+    m_entry_pos.resize(csr.nnz());
+    for (size_t i_chunk = 0; i_chunk < chunk_count; ++i_chunk) {
+      size_t width = (m_chunk_ptr[i_chunk+1] - m_chunk_ptr[i_chunk]) / C;
+      for (size_t i_lane = 0; i_lane < C; ++i_lane) {
+        size_t i_slot = i_chunk * C + i_lane;
+        size_t length = m_slot_length[i_slot];
+        size_t row_begin = length > 0 ? row_ptr[m_slot_row[i_slot]] : 0;
+
+        for (size_t j = 0; j < width; ++j) {
+          size_t pos = m_chunk_ptr[i_chunk] + j * C + i_lane;
+          if (j < length) {
+            m_col_ind[pos] = csr.col_ind()[row_begin + j];
+            m_values[pos] = csr.values()[row_begin + j];
+            m_entry_pos[row_begin + j] = pos;
+          } else {
+            m_col_ind[pos] = length > 0 ? csr.col_ind()[row_begin + length - 1] : 0;
+            m_values[pos] = 0;
+          }
+        }
+      }
+    }
+  }
+
+  template <typename N>
+  LocalCooMatrix<N> SellSparseMatrixStorage<N>::get_entries()
+  {
+    const size_t C = chunk_height;
+
+    // report the entries sorted by row, as the other formats do
+    std::vector<size_t> slot_of_row(m_rows);
+    for (size_t i_slot = 0; i_slot < m_slot_row.size(); ++i_slot) {
+      if (m_slot_row[i_slot] < m_rows)
+        slot_of_row[m_slot_row[i_slot]] = i_slot;
+    }
+
+    LocalCooMatrix<N> lmat;
+    global_size_t row_offset = row_spec().local_start();
+    for (size_t i_row = 0; i_row < m_rows; ++i_row) {
+      size_t i_slot = slot_of_row[i_row];
+      size_t i_chunk = i_slot / C;
+      size_t i_lane = i_slot % C;
+
+      for (size_t j = 0; j < m_slot_length[i_slot]; ++j) {
+        size_t pos = m_chunk_ptr[i_chunk] + j * C + i_lane;
+        lmat.add(row_offset + i_row, m_col_ind[pos], m_values[pos]);
+      }
+    }
+
+    return lmat;
+  }
+
+  template <typename N>
+  void SellSparseMatrixStorage<N>::set_values(const std::vector<N>& values)
+  {
+    if (values.size() != m_entry_pos.size()) {
+      throw std::invalid_argument("The value count does not match the sparsity pattern.");
+    }
+
+    // the padding keeps its zero values
+    for (size_t i_entry = 0; i_entry < values.size(); ++i_entry) {
+      m_values[m_entry_pos[i_entry]] = values[i_entry];
+    }
+  }
+
+  template <typename N>
+  void SellSparseMatrixStorage<N>::apply(Vector& result, const Vector& arg)
+  {
+    this->check_apply_sizes(result, arg);
+
+    constexpr size_t C = chunk_height;
+
+    const size_t* chunk_ptr = m_chunk_ptr.data();
+    const size_t* slot_row = m_slot_row.data();
+    const global_size_t* col_ind = m_col_ind.data();
+    const N* values = m_values.data();
+    const N* x = arg.native().data();
+    N* y = result.native().data();
+    const size_t rows = m_rows;
+    const long chunk_count = m_chunk_ptr.size() - 1;
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel for schedule(static) num_threads(threads())
+    #endif
+    for (long i_chunk = 0; i_chunk < chunk_count; ++i_chunk) {
+      N sum[C];
+      for (size_t i_lane = 0; i_lane < C; ++i_lane) {
+        sum[i_lane] = 0;
+      }
+
+      const N* chunk_values = values + chunk_ptr[i_chunk];
+      const global_size_t* chunk_cols = col_ind + chunk_ptr[i_chunk];
+      size_t width = (chunk_ptr[i_chunk+1] - chunk_ptr[i_chunk]) / C;
+
+      for (size_t j = 0; j < width; ++j) {
+        // the lanes are independent, which allows the compiler to
+        // vectorize this loop
+        for (size_t i_lane = 0; i_lane < C; ++i_lane) {
+          sum[i_lane] += chunk_values[i_lane] * x[chunk_cols[i_lane]];
+        }
+        chunk_values += C;
+        chunk_cols += C;
+      }
+
+      for (size_t i_lane = 0; i_lane < C; ++i_lane) {
+        size_t row = slot_row[i_chunk * C + i_lane];
+        if (row < rows)
+          y[row] = sum[i_lane];
+      }
+    }
+  }
+
+  template <typename N>
+  double SellSparseMatrixStorage<N>::fill_ratio() const
+  {
+    if (m_values.empty())
+      return 1.0;
+
+    size_t nnz = std::accumulate(m_slot_length.begin(),
+                                 m_slot_length.end(),
+                                 size_t(0));
+    return static_cast<double>(nnz) / m_values.size();
+  }
+}
+
+#endif
@@ -18,12 +18,57 @@
 #include <allium/config.hpp>
 
 #include "local_coo_matrix.hpp"
+#include "local_csr_matrix.hpp"
 #include "linear_operator.hpp"
+#include "multi_vector.hpp"
 #include "vector_storage.hpp"
+#include <allium/util/except.hpp>
+#include <algorithm>
 #include <memory>
+#include <numeric>
+#include <stdexcept>
+#include <type_traits>
 
 namespace allium {
 
+  /**
+    @brief Maps the entries of a matrix in coordinate format to the stored
+    values of a sparse matrix.
+
+    The i-th entry of the coordinate matrix is added to the stored value
+    `positions()[i]`. See SparseMatrixStorage::value_scatter.
+  */
+  class ValueScatter {
+    public:
+      ValueScatter() : m_value_count(0) {}
+
+      ValueScatter(size_t value_count, std::vector<size_t> positions)
+        : m_value_count(value_count), m_positions(std::move(positions)) {}
+
+      /** The number of values stored by the matrix. */
+      size_t value_count() const { return m_value_count; }
+
+      const std::vector<size_t>& positions() const { return m_positions; }
+
+      /** Sums the given entry values into the stored values. */
+      template <typename N>
+      std::vector<N> scatter(const std::vector<N>& entry_values) const {
+        if (entry_values.size() != m_positions.size()) {
+          throw std::invalid_argument("The entry count does not match the value scatter.");
+        }
+
+        std::vector<N> values(m_value_count, N(0));
+        for (size_t i = 0; i < m_positions.size(); ++i) {
+          values[m_positions[i]] += entry_values[i];
+        }
+        return values;
+      }
+
+    private:
+      size_t m_value_count;
+      std::vector<size_t> m_positions;
+  };
+
   /**
     @brief Abstract base type for all sparse-matrix classes.
   */
@@ -39,12 +84,177 @@ namespace allium {
       virtual void set_entries(LocalCooMatrix<Number> mat) = 0;
       virtual LocalCooMatrix<Number> get_entries() = 0;
 
+      /**
+        Sets the local rows of the matrix, given in CSR format with global
+        column indices. Must be called by all ranks, like set_entries().
+
+        Formats based on CSR take over the rows without sorting them. The
+        default implementation passes the entries to set_entries().
+       */
+      virtual void set_csr(LocalCsrMatrix<Number> mat) {
+        check_csr_size(mat);
+        set_entries(mat.to_coo(m_row_spec.local_start()));
+      }
+
+      /**
+        Replaces the stored values without changing the sparsity pattern.
+
+        The values are given in pattern order, which is the order of the
+        entries returned by get_entries(). Since the matrix object is kept,
+        data that only depends on the pattern (e.g., the symbolic
+        factorization of a preconditioner) stays valid.
+       */
+      virtual void set_values(const std::vector<Number>& /* values */) {
+        throw not_implemented();
+      }
+
+      /**
+        Computes the map from the given entries to the stored values of this
+        matrix. Every entry must be part of the current sparsity pattern,
+        several entries may refer to the same position.
+       */
+      ValueScatter value_scatter(const LocalCooMatrix<Number>& entries);
+
+      /**
+        Replaces the stored values by the sum of the given entries, which
+        must be in the order that was used to create the value scatter.
+       */
+      void update_values(const LocalCooMatrix<Number>& entries,
+                         const ValueScatter& scatter) {
+        set_values(scatter.scatter(entries.values()));
+      }
+
+      /**
+        Computes `Y = A X` for a block of vectors, which are stored
+        interleaved (see MultiVector). Formats with a native kernel load
+        every matrix entry once for all vectors, which is considerably
+        faster than one product per vector.
+
+        The default implementation copies the vectors one by one into
+        vectors of type `V` and applies the matrix to each of them. It
+        throws not_implemented if `V` cannot be created from a VectorSpec.
+       */
+      virtual void apply_block(MultiVector<Number, Eigen::RowMajor>& result,
+                               const MultiVector<Number, Eigen::RowMajor>& arg);
+
       VectorSpec row_spec() { return m_row_spec; }
       VectorSpec col_spec() { return m_col_spec; }
+
+    protected:
+      /** Checks the sizes of the arguments of apply_block. */
+      void check_block_sizes(const MultiVector<Number, Eigen::RowMajor>& result,
+                             const MultiVector<Number, Eigen::RowMajor>& arg);
+
+      /**
+        Checks the sizes of the arguments of apply. The kernels write the
+        result while reading the argument, hence they must be distinct.
+       */
+      void check_apply_sizes(const V& result, const V& arg);
+
+      /** Throws if the rows do not match the local rows of the matrix. */
+      void check_csr_size(const LocalCsrMatrix<Number>& mat) {
+        if (mat.rows() != m_row_spec.local_size()
+            || mat.cols() != m_col_spec.global_size()) {
+          throw std::invalid_argument("The matrix size does not match the vector specifications.");
+        }
+      }
+
     private:
       VectorSpec m_row_spec;
       VectorSpec m_col_spec;
+
+      void apply_by_vectors(MultiVector<Number, Eigen::RowMajor>& result,
+                            const MultiVector<Number, Eigen::RowMajor>& arg,
+                            std::true_type);
+      void apply_by_vectors(MultiVector<Number, Eigen::RowMajor>& result,
+                            const MultiVector<Number, Eigen::RowMajor>& arg,
+                            std::false_type) {
+        throw not_implemented();
+      }
   };
+
+  template <typename V>
+  void SparseMatrixStorage<V>::check_block_sizes(
+    const MultiVector<Number, Eigen::RowMajor>& result,
+    const MultiVector<Number, Eigen::RowMajor>& arg)
+  {
+    if (result.count() != arg.count()) {
+      throw std::invalid_argument("The blocks have different vector counts.");
+    }
+    if (static_cast<size_t>(result.native().rows()) != m_row_spec.local_size()
+        || static_cast<size_t>(arg.native().rows()) != m_col_spec.local_size()) {
+      throw std::invalid_argument("The block sizes do not match the matrix.");
+    }
+  }
+
+  template <typename V>
+  void SparseMatrixStorage<V>::check_apply_sizes(const V& result, const V& arg)
+  {
+    if (&result == &arg) {
+      throw std::invalid_argument("The result and the argument must be different vectors.");
+    }
+    if (result.spec().local_size() != m_row_spec.local_size()
+        || arg.spec().local_size() != m_col_spec.local_size()) {
+      throw std::invalid_argument("The vector sizes do not match the matrix.");
+    }
+  }
+
+  template <typename V>
+  void SparseMatrixStorage<V>::apply_block(
+    MultiVector<Number, Eigen::RowMajor>& result,
+    const MultiVector<Number, Eigen::RowMajor>& arg)
+  {
+    check_block_sizes(result, arg);
+    apply_by_vectors(result, arg, std::is_constructible<V, VectorSpec>());
+  }
+
+  template <typename V>
+  void SparseMatrixStorage<V>::apply_by_vectors(
+    MultiVector<Number, Eigen::RowMajor>& result,
+    const MultiVector<Number, Eigen::RowMajor>& arg,
+    std::true_type)
+  {
+    V x(m_col_spec);
+    V y(m_row_spec);
+    for (size_t i = 0; i < arg.count(); ++i) {
+      arg.get(i, x);
+      this->apply(y, x);
+      result.set(i, y);
+    }
+  }
+
+  template <typename V>
+  ValueScatter SparseMatrixStorage<V>::value_scatter(
+    const LocalCooMatrix<Number>& entries)
+  {
+    auto pattern = get_entries();
+    auto& rows = pattern.row_ind();
+    auto& cols = pattern.col_ind();
+
+    std::vector<size_t> order(pattern.entry_count());
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(),
+              [&](size_t a, size_t b) {
+                return rows[a] < rows[b] || (rows[a] == rows[b] && cols[a] < cols[b]);
+              });
+
+    std::vector<size_t> positions(entries.entry_count());
+    for (size_t i = 0; i < entries.entry_count(); ++i) {
+      global_size_t row = entries.row_ind()[i];
+      global_size_t col = entries.col_ind()[i];
+
+      auto it = std::lower_bound(order.begin(), order.end(), 0,
+                                 [&](size_t a, int) {
+                                   return rows[a] < row || (rows[a] == row && cols[a] < col);
+                                 });
+      if (it == order.end() || rows[*it] != row || cols[*it] != col) {
+        throw std::logic_error("Matrix entry is not part of the sparsity pattern.");
+      }
+      positions[i] = *it;
+    }
+
+    return ValueScatter(pattern.entry_count(), std::move(positions));
+  }
 }
 
 #endif
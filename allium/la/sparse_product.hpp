@@ -0,0 +1,242 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_SPARSE_PRODUCT_HPP
+#define ALLIUM_LA_SPARSE_PRODUCT_HPP
+
+#include "csr_sparse_matrix.hpp"
+#include "eigen_sparse_matrix.hpp"
+#include "local_csr_product.hpp"
+#include <memory>
+
+namespace allium {
+
+  /// @cond INTERNAL
+  namespace detail {
+    /**
+     Gives the product kernels access to the CSR arrays of a matrix. For
+     matrices that are stored by columns, the arrays are those of the
+     transposed matrix (`transposed == true`).
+     */
+    template <typename M>
+    class CsrAccess;
+
+    template <typename N>
+    class CsrAccess<CsrSparseMatrixStorage<N>> {
+      public:
+        using Matrix = CsrSparseMatrixStorage<N>;
+        static constexpr bool transposed = false;
+
+        explicit CsrAccess(std::shared_ptr<Matrix> mat) : m_mat(mat) {}
+
+        const LocalCsrMatrix<N>& csr() { return m_mat->local_matrix(); }
+
+        static std::shared_ptr<Matrix> create(VectorSpec rows,
+                                              VectorSpec cols,
+                                              const LocalCsrMatrix<N>& csr)
+        {
+          return std::make_shared<Matrix>(rows, cols, csr);
+        }
+
+      private:
+        std::shared_ptr<Matrix> m_mat;
+    };
+
+    template <typename N, int StorageOrder>
+    class CsrAccess<EigenSparseMatrixStorage<N, StorageOrder>> {
+      public:
+        using Matrix = EigenSparseMatrixStorage<N, StorageOrder>;
+        using NativeMatrix = typename Matrix::NativeMatrix;
+        static constexpr bool transposed = StorageOrder == Eigen::ColMajor;
+
+        // the compressed columns of a column-major matrix are the rows of
+        // its transpose
+        explicit CsrAccess(std::shared_ptr<Matrix> mat)
+          : m_mat(mat)
+        {
+          auto& native = mat->native();
+          size_t outer_size = native.outerSize();
+          size_t nnz = native.nonZeros();
+
+          aligned_vector<size_t> row_ptr(native.outerIndexPtr(),
+                                         native.outerIndexPtr() + outer_size + 1);
+          aligned_vector<global_size_t> col_ind(native.innerIndexPtr(),
+                                                native.innerIndexPtr() + nnz);
+          m_csr = LocalCsrMatrix<N>(native.innerSize(),
+                                    std::move(row_ptr),
+                                    std::move(col_ind),
+                                    aligned_vector<N>(nnz));
+        }
+
+        /** The arrays, with the current values of the matrix. */
+        const LocalCsrMatrix<N>& csr() {
+          auto& native = m_mat->native();
+          std::copy(native.valuePtr(),
+                    native.valuePtr() + native.nonZeros(),
+                    m_csr.values().begin());
+          return m_csr;
+        }
+
+        static std::shared_ptr<Matrix> create(VectorSpec rows,
+                                              VectorSpec cols,
+                                              const LocalCsrMatrix<N>& csr)
+        {
+          NativeMatrix native(rows.global_size(), cols.global_size());
+          native.resizeNonZeros(csr.nnz());
+          std::copy(csr.row_ptr().begin(), csr.row_ptr().end(),
+                    native.outerIndexPtr());
+          std::copy(csr.col_ind().begin(), csr.col_ind().end(),
+                    native.innerIndexPtr());
+          std::copy(csr.values().begin(), csr.values().end(),
+                    native.valuePtr());
+
+          return std::make_shared<Matrix>(rows, cols, std::move(native));
+        }
+
+      private:
+        std::shared_ptr<Matrix> m_mat;
+        LocalCsrMatrix<N> m_csr;
+    };
+
+    template <typename M, typename N>
+    void set_values(M& mat, const LocalCsrMatrix<N>& csr) {
+      mat.set_values(std::vector<N>(csr.values().begin(), csr.values().end()));
+    }
+  }
+  /// @endcond
+
+  /**
+   @brief The transpose of a sparse matrix.
+
+   Supported are CsrSparseMatrixStorage and EigenSparseMatrixStorage. The
+   constructor computes the sparsity pattern of the result. If only the
+   values of the original matrix change, update() recomputes the values of
+   the result, which is cheaper.
+   */
+  template <typename M>
+  class SparseTranspose {
+    public:
+      explicit SparseTranspose(std::shared_ptr<M> a)
+        : m_a(a),
+          m_kernel(m_a.csr()),
+          m_result(detail::CsrAccess<M>::create(a->col_spec(),
+                                                a->row_spec(),
+                                                m_kernel.result()))
+      {}
+
+      std::shared_ptr<M> result() const { return m_result; }
+
+      /** Recomputes the values of the result. */
+      void update() {
+        m_kernel.numeric(m_a.csr());
+        detail::set_values(*m_result, m_kernel.result());
+      }
+
+    private:
+      detail::CsrAccess<M> m_a;
+      LocalCsrTranspose<typename M::Number> m_kernel;
+      std::shared_ptr<M> m_result;
+  };
+
+  /**
+   @brief The product `C = A B` of two sparse matrices.
+
+   See SparseTranspose for the supported types and the split into the
+   symbolic and numeric phase.
+   */
+  template <typename M>
+  class SparseProduct {
+    public:
+      SparseProduct(std::shared_ptr<M> a, std::shared_ptr<M> b)
+        : m_a(a),
+          m_b(b),
+          m_kernel(left().csr(), right().csr()),
+          m_result(detail::CsrAccess<M>::create(a->row_spec(),
+                                                b->col_spec(),
+                                                m_kernel.result()))
+      {}
+
+      std::shared_ptr<M> result() const { return m_result; }
+
+      /** Recomputes the values of the result. */
+      void update() {
+        m_kernel.numeric(left().csr(), right().csr());
+        detail::set_values(*m_result, m_kernel.result());
+      }
+
+    private:
+      detail::CsrAccess<M> m_a;
+      detail::CsrAccess<M> m_b;
+      LocalCsrProduct<typename M::Number> m_kernel;
+      std::shared_ptr<M> m_result;
+
+      // (A B)^T = B^T A^T for matrices stored by columns
+      detail::CsrAccess<M>& left() {
+        return detail::CsrAccess<M>::transposed ? m_b : m_a;
+      }
+      detail::CsrAccess<M>& right() {
+        return detail::CsrAccess<M>::transposed ? m_a : m_b;
+      }
+  };
+
+  /**
+   @brief The Galerkin product `C = P^T A P` of two sparse matrices, e.g.,
+   the coarse operator of a multigrid method.
+
+   See SparseTranspose for the supported types and the split into the
+   symbolic and numeric phase.
+   */
+  template <typename M>
+  class SparseTripleProduct {
+    public:
+      SparseTripleProduct(std::shared_ptr<M> a, std::shared_ptr<M> p)
+        : m_a(a),
+          m_p(p),
+          m_p_transposed(detail::CsrAccess<M>::transposed
+                           ? new LocalCsrTranspose<Number>(m_p.csr())
+                           : nullptr),
+          m_kernel(m_a.csr(), p_csr()),
+          m_result(detail::CsrAccess<M>::create(p->col_spec(),
+                                                p->col_spec(),
+                                                m_kernel.result()))
+      {}
+
+      std::shared_ptr<M> result() const { return m_result; }
+
+      /** Recomputes the values of the result. */
+      void update() {
+        if (m_p_transposed)
+          m_p_transposed->numeric(m_p.csr());
+        m_kernel.numeric(m_a.csr(), p_csr());
+        detail::set_values(*m_result, m_kernel.result());
+      }
+
+    private:
+      using Number = typename M::Number;
+
+      detail::CsrAccess<M> m_a;
+      detail::CsrAccess<M> m_p;
+      // For matrices stored by columns, the result is the transpose
+      // (P^T A P)^T = P^T A^T P, hence, the CSR arrays of P are needed.
+      std::unique_ptr<LocalCsrTranspose<Number>> m_p_transposed;
+      LocalCsrTripleProduct<Number> m_kernel;
+      std::shared_ptr<M> m_result;
+
+      const LocalCsrMatrix<Number>& p_csr() {
+        return m_p_transposed ? m_p_transposed->result() : m_p.csr();
+      }
+  };
+}
+
+#endif
@@ -0,0 +1,82 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_SYMMETRIC_CSR_SPARSE_MATRIX_HPP
+#define ALLIUM_LA_SYMMETRIC_CSR_SPARSE_MATRIX_HPP
+
+#include "sparse_matrix.hpp"
+#include "eigen_vector.hpp"
+#include "local_csr_matrix.hpp"
+#include <allium/util/extern.hpp>
+
+namespace allium {
+
+  /**
+   @brief A native sparse matrix for symmetric (or Hermitian) matrices,
+   which stores the upper triangle in CSR format.
+
+   Entries below the diagonal are ignored by set_entries(), get_entries()
+   returns both triangles. For complex numbers, the matrix is Hermitian,
+   i.e., the lower triangle is the conjugate transpose of the upper one.
+
+   The matrix-vector product reads every off-diagonal entry once and uses it
+   for both triangles, which nearly halves the memory traffic compared to
+   CsrSparseMatrixStorage. The rows are split among the threads like for
+   CsrSparseMatrixStorage. The contributions of the lower triangle, which
+   fall into the rows of a later thread, are collected in a buffer per
+   thread and added in a second pass. The buffers are as long as the
+   bandwidth of the matrix reaches past the block of each thread.
+
+   Like EigenVectorStorage, this matrix cannot be distributed.
+   */
+  template <typename N>
+  class SymmetricCsrSparseMatrixStorage final
+      : public SparseMatrixStorage<EigenVectorStorage<N>>
+  {
+    public:
+      using Vector = EigenVectorStorage<N>;
+      using DefaultVector = EigenVectorStorage<N>;
+      using typename SparseMatrixStorage<Vector>::Number;
+      using typename SparseMatrixStorage<Vector>::Real;
+      using SparseMatrixStorage<Vector>::row_spec;
+      using SparseMatrixStorage<Vector>::col_spec;
+
+      SymmetricCsrSparseMatrixStorage(VectorSpec rows, VectorSpec cols);
+
+      void set_entries(LocalCooMatrix<N> lmat) override;
+      LocalCooMatrix<N> get_entries() override;
+
+      void apply(Vector& result, const Vector& arg) override;
+
+      /** The upper triangle, including the diagonal. */
+      const LocalCsrMatrix<N>& upper_triangle() const { return m_mat; }
+
+    private:
+      LocalCsrMatrix<N> m_mat;
+
+      /// First row of every thread's block, plus the row count.
+      std::vector<size_t> m_partition;
+
+      /// The contributions of every thread to the rows after its block.
+      std::vector<aligned_vector<N>> m_buffers;
+
+      void partition_rows(int parts);
+  };
+
+  #define ALLIUM_SYMMETRIC_CSR_SPARSE_MATRIX_DECL(extern, N) \
+    extern template class SymmetricCsrSparseMatrixStorage<N>;
+  ALLIUM_EXTERN_N(ALLIUM_SYMMETRIC_CSR_SPARSE_MATRIX_DECL)
+}
+
+#endif
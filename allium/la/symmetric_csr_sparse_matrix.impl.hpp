@@ -0,0 +1,181 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_LA_SYMMETRIC_CSR_SPARSE_MATRIX_IMPL_HPP
+#define ALLIUM_LA_SYMMETRIC_CSR_SPARSE_MATRIX_IMPL_HPP
+
+#include "symmetric_csr_sparse_matrix.hpp"
+
+#include <allium/util/numeric.hpp>
+#include <allium/util/parallel.hpp>
+
+namespace allium {
+
+  template <typename N>
+  SymmetricCsrSparseMatrixStorage<N>::SymmetricCsrSparseMatrixStorage(
+    VectorSpec rows, VectorSpec cols)
+    : SparseMatrixStorage<Vector>(rows, cols),
+      m_mat(rows.local_size(), cols.global_size())
+  {
+    if (rows.comm().size() != 1) {
+      throw std::logic_error("Objects of type SymmetricCsrSparseMatrixStorage cannot be distributed.");
+    }
+    if (rows.global_size() != cols.global_size()) {
+      throw std::logic_error("A symmetric matrix must be square.");
+    }
+  }
+
+  template <typename N>
+  void SymmetricCsrSparseMatrixStorage<N>::set_entries(LocalCooMatrix<N> lmat)
+  {
+    LocalCooMatrix<N> upper;
+    upper.reserve(lmat.entry_count() / 2 + row_spec().local_size());
+    for (size_t i_entry = 0; i_entry < lmat.entry_count(); ++i_entry) {
+      if (lmat.col_ind()[i_entry] >= lmat.row_ind()[i_entry]) {
+        upper.add(lmat.row_ind()[i_entry],
+                  lmat.col_ind()[i_entry],
+                  lmat.values()[i_entry]);
+      }
+    }
+
+    m_mat = LocalCsrMatrix<N>(row_spec().local_size(),
+                              col_spec().global_size(),
+                              upper,
+                              row_spec().local_start());
+    m_partition.clear();
+  }
+
+  template <typename N>
+  LocalCooMatrix<N> SymmetricCsrSparseMatrixStorage<N>::get_entries()
+  {
+    auto coo = m_mat.to_coo(row_spec().local_start());
+
+    size_t upper_count = coo.entry_count();
+    for (size_t i_entry = 0; i_entry < upper_count; ++i_entry) {
+      global_size_t row = coo.row_ind()[i_entry];
+      global_size_t col = coo.col_ind()[i_entry];
+      if (row != col) {
+        coo.add(col, row, conj(coo.values()[i_entry]));
+      }
+    }
+    return coo;
+  }
+
+  template <typename N>
+  void SymmetricCsrSparseMatrixStorage<N>::partition_rows(int parts)
+  {
+    const size_t rows = m_mat.rows();
+    const auto& row_ptr = m_mat.row_ptr();
+    const auto& col_ind = m_mat.col_ind();
+
+    m_partition = allium::partition_rows(row_ptr.data(), rows, parts);
+
+    // the buffer of a thread reaches up to the largest column of its block
+    m_buffers.resize(parts);
+    for (int i_part = 0; i_part < parts; ++i_part) {
+      size_t end = m_partition[i_part+1];
+      size_t length = 0;
+      for (size_t i_row = m_partition[i_part]; i_row < end; ++i_row) {
+        if (row_ptr[i_row] < row_ptr[i_row+1]) {
+          global_size_t last_col = col_ind[row_ptr[i_row+1]-1];
+          if (last_col >= end)
+            length = std::max<size_t>(length, last_col + 1 - end);
+        }
+      }
+      m_buffers[i_part].assign(length, N(0));
+    }
+  }
+
+  template <typename N>
+  void SymmetricCsrSparseMatrixStorage<N>::apply(Vector& result,
+                                                 const Vector& arg)
+  {
+    this->check_apply_sizes(result, arg);
+
+    int parts = max_threads();
+    if (m_partition.size() != static_cast<size_t>(parts) + 1) {
+      partition_rows(parts);
+    }
+
+    const size_t* row_ptr = m_mat.row_ptr().data();
+    const global_size_t* col_ind = m_mat.col_ind().data();
+    const N* values = m_mat.values().data();
+    const N* x = arg.native().data();
+    N* y = result.native().data();
+    const size_t* partition = m_partition.data();
+    auto& buffers = m_buffers;
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel num_threads(parts)
+    #endif
+    {
+      #ifdef ALLIUM_USE_OPENMP
+      #pragma omp for schedule(static, 1)
+      #endif
+      for (int i_part = 0; i_part < parts; ++i_part) {
+        const size_t begin = partition[i_part];
+        const size_t end = partition[i_part+1];
+        N* buffer = buffers[i_part].data();
+        std::fill(y + begin, y + end, N(0));
+        std::fill(buffers[i_part].begin(), buffers[i_part].end(), N(0));
+
+        for (size_t i_row = begin; i_row < end; ++i_row) {
+          const N x_i = x[i_row];
+          size_t i_entry = row_ptr[i_row];
+          N sum = 0;
+
+          // the entries are sorted, the diagonal comes first
+          if (i_entry < row_ptr[i_row+1] && col_ind[i_entry] == i_row) {
+            sum += values[i_entry] * x_i;
+            ++i_entry;
+          }
+
+          for (; i_entry < row_ptr[i_row+1]; ++i_entry) {
+            global_size_t col = col_ind[i_entry];
+            N value = values[i_entry];
+            sum += value * x[col];
+
+            N transposed = conj(value) * x_i;
+            if (col < end)
+              y[col] += transposed;
+            else
+              buffer[col - end] += transposed;
+          }
+
+          y[i_row] += sum;
+        }
+      }
+
+      // add the contributions of the previous threads
+      #ifdef ALLIUM_USE_OPENMP
+      #pragma omp for schedule(static, 1)
+      #endif
+      for (int i_part = 1; i_part < parts; ++i_part) {
+        const size_t begin = partition[i_part];
+        const size_t end = partition[i_part+1];
+
+        for (int i_other = 0; i_other < i_part; ++i_other) {
+          const size_t other_end = partition[i_other+1];
+          const auto& buffer = buffers[i_other];
+          size_t last = std::min(end, other_end + buffer.size());
+          for (size_t i_row = begin; i_row < last; ++i_row) {
+            y[i_row] += buffer[i_row - other_end];
+          }
+        }
+      }
+    }
+  }
+}
+
+#endif
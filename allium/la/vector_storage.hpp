@@ -209,6 +209,10 @@ namespace allium {
       }
 
       size_t size() const { return m_size; }
+
+      /** Pointer to the first local entry, valid until the slice is
+          released. */
+      DataPointer data() const { return m_data; }
     protected:
       DataPointer m_data;
       size_t m_size;
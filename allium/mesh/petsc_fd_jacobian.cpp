@@ -0,0 +1,84 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "petsc_fd_jacobian.hpp"
+
+#ifdef ALLIUM_USE_PETSC
+
+#include <allium/la/petsc_util.hpp>
+
+namespace allium {
+
+  PetscFdJacobian::PetscFdJacobian(std::shared_ptr<PetscMeshSpec<2>> spec,
+                                   Function f)
+    : m_spec(spec),
+      m_function(std::move(f))
+  {
+    using namespace petsc;
+    PetscErrorCode ierr;
+
+    auto dm = spec->dm();
+
+    // the pattern of the mesh stencil, filled with zeros
+    ierr = DMCreateMatrix(dm, m_mat.writable_ptr()); chkerr(ierr);
+
+    ISColoring is_coloring;
+    ierr = DMCreateColoring(dm, IS_COLORING_GLOBAL, &is_coloring); chkerr(ierr);
+    ierr = ISColoringGetColors(is_coloring, nullptr, &m_color_count, nullptr);
+    chkerr(ierr);
+
+    ierr = MatFDColoringCreate(m_mat, is_coloring, m_coloring.writable_ptr());
+    chkerr(ierr);
+    ierr = MatFDColoringSetFunction(m_coloring,
+                                    reinterpret_cast<PetscErrorCode (*)(void)>(&evaluate),
+                                    this);
+    chkerr(ierr);
+    ierr = MatFDColoringSetUp(m_mat, is_coloring, m_coloring); chkerr(ierr);
+    ierr = ISColoringDestroy(&is_coloring); chkerr(ierr);
+
+    auto vspec = spec->vector_spec();
+    m_matrix = std::make_shared<PetscSparseMatrixStorage<PetscScalar>>(vspec, vspec, m_mat);
+  }
+
+  void PetscFdJacobian::compute(const Mesh& u)
+  {
+    using namespace petsc;
+    PetscErrorCode ierr;
+
+    m_exception = nullptr;
+    ierr = MatFDColoringApply(m_mat, m_coloring, u.native(), nullptr);
+    if (m_exception) {
+      std::rethrow_exception(m_exception);
+    }
+    chkerr(ierr);
+  }
+
+  PetscErrorCode PetscFdJacobian::evaluate(void* context, Vec x, Vec f, void* self)
+  {
+    auto jacobian = static_cast<PetscFdJacobian*>(self);
+
+    try {
+      const Mesh arg(jacobian->m_spec, PetscObjectPtr<Vec>(x, false));
+      Mesh result(jacobian->m_spec, PetscObjectPtr<Vec>(f, false));
+      jacobian->m_function(result, arg);
+    } catch (...) {
+      jacobian->m_exception = std::current_exception();
+      return PETSC_ERR_USER;
+    }
+
+    return 0;
+  }
+}
+
+#endif
@@ -0,0 +1,89 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_MESH_PETSC_FD_JACOBIAN_HPP
+#define ALLIUM_MESH_PETSC_FD_JACOBIAN_HPP
+
+#include <allium/config.hpp>
+#ifdef ALLIUM_USE_PETSC
+
+#include <allium/la/petsc_sparse_matrix.hpp>
+#include "petsc_mesh.hpp"
+
+#include <exception>
+#include <functional>
+#include <memory>
+
+namespace allium {
+
+  /**
+   @brief Assembles the Jacobian of a function on a PETSc mesh by finite
+   differences.
+
+   The sparsity pattern of the Jacobian is the stencil of the mesh
+   specification, i.e., `F(u)(p)` may only depend on the values of `u` at
+   points within the stencil width and type around `p`. Points whose
+   stencils do not overlap can be perturbed at the same time, hence the
+   points are colored by a distance-2 coloring of the mesh stencil
+   (`DMCreateColoring`). Each Jacobian costs one evaluation of `F` per color
+   plus one at the base point, e.g., 5 to 9 colors for a 2D stencil of width
+   one, independent of the mesh size.
+   */
+  class PetscFdJacobian {
+    public:
+      using Mesh = PetscMesh<PetscScalar, 2>;
+      using Function = std::function<void(Mesh& result, const Mesh& arg)>;
+
+      /**
+       @param [in] spec The mesh specification of the argument and the
+                   result of the function.
+       @param [in] f The function `result = F(arg)`.
+       */
+      PetscFdJacobian(std::shared_ptr<PetscMeshSpec<2>> spec, Function f);
+
+      PetscFdJacobian(const PetscFdJacobian&) = delete;
+      PetscFdJacobian& operator= (const PetscFdJacobian&) = delete;
+
+      /**
+       Recomputes the Jacobian at `u`. The values of matrix() are replaced,
+       its sparsity pattern stays the same.
+       */
+      void compute(const Mesh& u);
+
+      /** The Jacobian, as computed by the last call to compute(). */
+      std::shared_ptr<PetscSparseMatrixStorage<PetscScalar>> matrix() {
+        return m_matrix;
+      }
+
+      /** The number of colors, i.e., the function evaluations per Jacobian
+          without the evaluation at the base point. */
+      PetscInt color_count() const { return m_color_count; }
+
+    private:
+      std::shared_ptr<PetscMeshSpec<2>> m_spec;
+      Function m_function;
+      PetscObjectPtr<Mat> m_mat;
+      PetscObjectPtr<MatFDColoring> m_coloring;
+      std::shared_ptr<PetscSparseMatrixStorage<PetscScalar>> m_matrix;
+      PetscInt m_color_count;
+
+      // exceptions must not propagate through PETSc
+      std::exception_ptr m_exception;
+
+      static PetscErrorCode evaluate(void* context, Vec x, Vec f, void* self);
+  };
+}
+
+#endif
+#endif
@@ -0,0 +1,365 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "petsc_stencil_operator.hpp"
+
+#ifdef ALLIUM_USE_PETSC
+
+#include <allium/la/petsc_util.hpp>
+#include <algorithm>
+#include <stdexcept>
+
+namespace allium {
+
+  StencilOperator<PetscMesh<PetscScalar, 2>>::StencilOperator(
+      std::shared_ptr<PetscMeshSpec<2>> spec,
+      Stencil<PetscScalar, 2> stencil,
+      PetscScalar shift)
+    : m_spec(spec),
+      m_stencil(std::move(stencil)),
+      m_shift(shift),
+      m_coefficient_values(m_stencil.size()),
+      m_scratch(spec)
+  {
+    using namespace petsc;
+    PetscErrorCode ierr;
+
+    PetscInt stencil_width;
+    DMBoundaryType bx, by;
+    DMDAStencilType stencil_type;
+    ierr = DMDAGetInfo(spec->dm(),
+                       nullptr, // dim
+                       nullptr, nullptr, nullptr, // global size
+                       nullptr, nullptr, nullptr, // processors per dim
+                       nullptr, // ndof
+                       &stencil_width,
+                       &bx, &by, nullptr,
+                       &stencil_type);
+    chkerr(ierr);
+
+    if (m_stencil.width() > stencil_width)
+      throw std::logic_error("The stencil is wider than the mesh stencil width.");
+
+    if (stencil_type == DMDA_STENCIL_STAR && !m_stencil.is_star())
+      throw std::logic_error("A box stencil requires a DMDA_STENCIL_BOX mesh.");
+
+    if (bx == DM_BOUNDARY_NONE || by == DM_BOUNDARY_NONE)
+      throw std::logic_error("The stencil operator requires ghost values at the boundary.");
+
+    m_zero_ghosts = { bx == DM_BOUNDARY_GHOSTED, by == DM_BOUNDARY_GHOSTED };
+  }
+
+  void StencilOperator<PetscMesh<PetscScalar, 2>>::coefficient_values(
+      size_t i_entry,
+      std::shared_ptr<const Mesh> values)
+  {
+    if (i_entry >= m_stencil.size())
+      throw std::out_of_range("Stencil entry out of range.");
+
+    if (values && values->mesh_spec() != m_spec)
+      throw std::logic_error("The coefficient mesh has a different specification.");
+
+    m_coefficient_values[i_entry] = values;
+  }
+
+  void StencilOperator<PetscMesh<PetscScalar, 2>>::zero_boundary()
+  {
+    using namespace petsc;
+    PetscErrorCode ierr;
+
+    if (!m_zero_ghosts[0] && !m_zero_ghosts[1])
+      return;
+
+    auto global_end = m_spec->range().end_pos();
+    auto ghost_range = m_spec->local_ghost_range();
+    int ndof = m_spec->ndof();
+
+    PetscScalar** u;
+    ierr = DMDAVecGetArray(m_spec->dm(), m_scratch.petsc_vec(), &u);
+    chkerr(ierr);
+
+    for (int j = ghost_range.begin_pos()[1]; j < ghost_range.end_pos()[1]; ++j) {
+      bool outside_row = m_zero_ghosts[1] && (j < 0 || j >= global_end[1]);
+      for (int i = ghost_range.begin_pos()[0]; i < ghost_range.end_pos()[0]; ++i) {
+        if (outside_row
+            || (m_zero_ghosts[0] && (i < 0 || i >= global_end[0]))) {
+          for (int i_dof = 0; i_dof < ndof; ++i_dof) {
+            u[j][i*ndof + i_dof] = 0;
+          }
+        }
+      }
+    }
+
+    ierr = DMDAVecRestoreArray(m_spec->dm(), m_scratch.petsc_vec(), &u);
+    chkerr(ierr);
+  }
+
+  void StencilOperator<PetscMesh<PetscScalar, 2>>::apply_shifted_add(
+    Mesh& result,
+    PetscScalar alpha,
+    PetscScalar shift,
+    const Mesh& arg,
+    PetscScalar beta)
+  {
+    using namespace petsc;
+    PetscErrorCode ierr;
+
+    auto dm = m_spec->dm();
+
+    m_scratch.assign(arg);
+    zero_boundary();
+
+    const size_t n_entries = m_stencil.size();
+    const int ndof = m_spec->ndof();
+
+    // Each stencil entry becomes a shift of the row pointers, such that the
+    // inner loops run over contiguous memory.
+    std::vector<int> row_offset(n_entries);
+    std::vector<int> col_offset(n_entries);
+    std::vector<PetscScalar> coefficient(n_entries);
+    for (size_t k = 0; k < n_entries; ++k) {
+      const auto& e = m_stencil.entries()[k];
+      col_offset[k] = e.offset[0] * ndof;
+      row_offset[k] = e.offset[1];
+      coefficient[k] = alpha * e.coefficient;
+    }
+
+    PetscScalar** u;
+    PetscScalar** f;
+    std::vector<PetscScalar**> c(n_entries, nullptr);
+
+    ierr = DMDAVecGetArrayRead(dm, m_scratch.petsc_vec(), &u); chkerr(ierr);
+    ierr = DMDAVecGetArray(dm, result.petsc_vec(), &f); chkerr(ierr);
+    for (size_t k = 0; k < n_entries; ++k) {
+      if (m_coefficient_values[k]) {
+        ierr = DMDAVecGetArrayRead(dm, m_coefficient_values[k]->native(), &c[k]);
+        chkerr(ierr);
+      }
+    }
+
+    auto range = m_spec->local_range();
+    const int i_begin = range.begin_pos()[0] * ndof;
+    const int i_end = range.end_pos()[0] * ndof;
+    const int j_begin = range.begin_pos()[1];
+    const int j_end = range.end_pos()[1];
+    const PetscScalar diagonal = alpha * (m_shift + shift);
+    const bool read_f = beta != PetscScalar(0);
+
+    #ifdef ALLIUM_USE_OPENMP
+    #pragma omp parallel for schedule(static)
+    #endif
+    for (int j = j_begin; j < j_end; ++j) {
+      PetscScalar* f_row = f[j];
+      const PetscScalar* u_row = u[j];
+
+      if (read_f) {
+        for (int i = i_begin; i < i_end; ++i) {
+          f_row[i] = beta * f_row[i] + diagonal * u_row[i];
+        }
+      } else {
+        for (int i = i_begin; i < i_end; ++i) {
+          f_row[i] = diagonal * u_row[i];
+        }
+      }
+
+      for (size_t k = 0; k < n_entries; ++k) {
+        const PetscScalar* src = u[j + row_offset[k]] + col_offset[k];
+        const PetscScalar a = coefficient[k];
+
+        if (c[k] != nullptr) {
+          const PetscScalar* c_row = c[k][j];
+          for (int i = i_begin; i < i_end; ++i) {
+            f_row[i] += a * c_row[i] * src[i];
+          }
+        } else {
+          for (int i = i_begin; i < i_end; ++i) {
+            f_row[i] += a * src[i];
+          }
+        }
+      }
+    }
+
+    for (size_t k = 0; k < n_entries; ++k) {
+      if (m_coefficient_values[k]) {
+        ierr = DMDAVecRestoreArrayRead(dm, m_coefficient_values[k]->native(), &c[k]);
+        chkerr(ierr);
+      }
+    }
+    ierr = DMDAVecRestoreArray(dm, result.petsc_vec(), &f); chkerr(ierr);
+    ierr = DMDAVecRestoreArrayRead(dm, m_scratch.petsc_vec(), &u); chkerr(ierr);
+  }
+
+  std::shared_ptr<PetscSparseMatrixStorage<PetscScalar>>
+    StencilOperator<PetscMesh<PetscScalar, 2>>::assemble()
+  {
+    using namespace petsc;
+    PetscErrorCode ierr;
+
+    auto dm = m_spec->dm();
+
+    DMBoundaryType bx, by;
+    ierr = DMDAGetInfo(dm,
+                       nullptr, // dim
+                       nullptr, nullptr, nullptr, // global size
+                       nullptr, nullptr, nullptr, // processors per dim
+                       nullptr, // ndof
+                       nullptr, // stencil width
+                       &bx, &by, nullptr,
+                       nullptr); // stencil type
+    chkerr(ierr);
+
+    if (bx == DM_BOUNDARY_MIRROR || by == DM_BOUNDARY_MIRROR)
+      throw not_implemented();
+
+    const std::array<bool, 2> periodic = { bx == DM_BOUNDARY_PERIODIC,
+                                           by == DM_BOUNDARY_PERIODIC };
+    const auto global_end = m_spec->range().end_pos();
+    auto range = m_spec->local_range();
+    const int ndof = m_spec->ndof();
+    const size_t n_entries = m_stencil.size();
+
+    // The neighbor of p for the k-th stencil entry, wrapped at periodic
+    // boundaries. Returns false if the neighbor is a zero ghost value.
+    auto neighbor = [&](Point<int, 2> p, size_t k, Point<int, 2>& q) {
+      q = p;
+      q += m_stencil.entries()[k].offset;
+      for (int i = 0; i < 2; ++i) {
+        if (q[i] < 0 || q[i] >= global_end[i]) {
+          if (!periodic[i])
+            return false;
+          q[i] = (q[i] % global_end[i] + global_end[i]) % global_end[i];
+        }
+      }
+      return true;
+    };
+
+    // Every degree of freedom couples to the same degree of freedom of the
+    // neighbors only, hence all rows of a point have the same pattern.
+    const size_t local_points = range.shape()[0] * range.shape()[1];
+    std::vector<PetscInt> d_nnz(local_points * ndof);
+    std::vector<PetscInt> o_nnz(local_points * ndof);
+    std::vector<Point<int, 2>> cols;
+    size_t i_point = 0;
+    for (int j = range.begin_pos()[1]; j < range.end_pos()[1]; ++j) {
+      for (int i = range.begin_pos()[0]; i < range.end_pos()[0]; ++i) {
+        Point<int, 2> p{i, j};
+
+        cols.assign(1, p);
+        for (size_t k = 0; k < n_entries; ++k) {
+          Point<int, 2> q;
+          if (neighbor(p, k, q))
+            cols.push_back(q);
+        }
+        std::sort(cols.begin(), cols.end(),
+                  [](const Point<int, 2>& a, const Point<int, 2>& b) {
+                    return a[1] < b[1] || (a[1] == b[1] && a[0] < b[0]);
+                  });
+        cols.erase(std::unique(cols.begin(), cols.end()), cols.end());
+
+        PetscInt d = 0;
+        for (auto& q : cols) {
+          if (range.in(q))
+            ++d;
+        }
+        for (int i_dof = 0; i_dof < ndof; ++i_dof) {
+          d_nnz[i_point * ndof + i_dof] = d;
+          o_nnz[i_point * ndof + i_dof] = cols.size() - d;
+        }
+        ++i_point;
+      }
+    }
+
+    // Only the preallocation is taken from the mesh, the pattern of its full
+    // stencil is not filled in. The setting is made on a clone, which shares
+    // the layout, since other users of the mesh spec, like PetscFdJacobian,
+    // rely on the full pattern.
+    PetscObjectPtr<DM> matrix_dm;
+    ierr = DMClone(dm, matrix_dm.writable_ptr()); chkerr(ierr);
+    ierr = DMSetMatrixPreallocateOnly(matrix_dm, PETSC_TRUE); chkerr(ierr);
+
+    PetscObjectPtr<Mat> mat;
+    ierr = DMCreateMatrix(matrix_dm, mat.writable_ptr()); chkerr(ierr);
+    ierr = MatXAIJSetPreallocation(mat, 1,
+                                   d_nnz.data(), o_nnz.data(),
+                                   nullptr, nullptr);
+    chkerr(ierr);
+    ierr = MatSetOption(mat, MAT_NEW_NONZERO_ALLOCATION_ERR, PETSC_TRUE);
+    chkerr(ierr);
+
+    std::vector<PetscScalar**> c(n_entries, nullptr);
+    for (size_t k = 0; k < n_entries; ++k) {
+      if (m_coefficient_values[k]) {
+        ierr = DMDAVecGetArrayRead(dm, m_coefficient_values[k]->native(), &c[k]);
+        chkerr(ierr);
+      }
+    }
+
+    std::vector<MatStencil> col_stencils;
+    std::vector<PetscScalar> values;
+    for (int j = range.begin_pos()[1]; j < range.end_pos()[1]; ++j) {
+      for (int i = range.begin_pos()[0]; i < range.end_pos()[0]; ++i) {
+        Point<int, 2> p{i, j};
+
+        for (int i_dof = 0; i_dof < ndof; ++i_dof) {
+          MatStencil row;
+          row.k = 0;
+          row.j = j;
+          row.i = i;
+          row.c = i_dof;
+
+          col_stencils.assign(1, row);
+          values.assign(1, m_shift);
+          for (size_t k = 0; k < n_entries; ++k) {
+            Point<int, 2> q;
+            if (!neighbor(p, k, q))
+              continue;
+
+            // unwrapped indices, PETSc maps them at periodic boundaries
+            MatStencil col = row;
+            col.i = i + m_stencil.entries()[k].offset[0];
+            col.j = j + m_stencil.entries()[k].offset[1];
+            col_stencils.push_back(col);
+
+            PetscScalar a = m_stencil.entries()[k].coefficient;
+            if (c[k] != nullptr)
+              a *= c[k][j][i*ndof + i_dof];
+            values.push_back(a);
+          }
+
+          ierr = MatSetValuesStencil(mat,
+                                     1, &row,
+                                     col_stencils.size(), col_stencils.data(),
+                                     values.data(),
+                                     ADD_VALUES);
+          chkerr(ierr);
+        }
+      }
+    }
+
+    for (size_t k = 0; k < n_entries; ++k) {
+      if (m_coefficient_values[k]) {
+        ierr = DMDAVecRestoreArrayRead(dm, m_coefficient_values[k]->native(), &c[k]);
+        chkerr(ierr);
+      }
+    }
+
+    ierr = MatAssemblyBegin(mat, MAT_FINAL_ASSEMBLY); chkerr(ierr);
+    ierr = MatAssemblyEnd(mat, MAT_FINAL_ASSEMBLY); chkerr(ierr);
+
+    auto spec = m_spec->vector_spec();
+    return std::make_shared<PetscSparseMatrixStorage<PetscScalar>>(spec, spec, mat);
+  }
+}
+
+#endif
@@ -0,0 +1,110 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_MESH_PETSC_STENCIL_OPERATOR_HPP
+#define ALLIUM_MESH_PETSC_STENCIL_OPERATOR_HPP
+
+#include <allium/config.hpp>
+#ifdef ALLIUM_USE_PETSC
+
+#include <allium/la/operator_algebra.hpp>
+#include <allium/la/petsc_sparse_matrix.hpp>
+#include "petsc_mesh.hpp"
+#include "stencil.hpp"
+
+#include <memory>
+#include <vector>
+
+namespace allium {
+
+  /**
+   @brief Matrix-free stencil operator for PETSc meshes.
+
+   Computes `f(p) = s u(p) + sum_k c_k(p) u(p + o_k)`, where `s` is the
+   diagonal shift. The coefficient `c_k(p)` is the coefficient of the k-th
+   stencil entry, optionally multiplied by the value of a coefficient mesh at
+   `p` (variable coefficients).
+
+   The ghost values are gathered into a local mesh that is allocated once,
+   when the operator is created. At `DM_BOUNDARY_GHOSTED` boundaries the
+   ghost values are zero, i.e., the operator implements homogeneous Dirichlet
+   boundary conditions there. The stencil must fit into the stencil width
+   and the stencil type of the mesh specification.
+
+   The operator is a ShiftableOperator, i.e., additional shifts and the
+   accumulation into the result are part of the same sweep.
+   */
+  template <>
+  class StencilOperator<PetscMesh<PetscScalar, 2>>
+    : public ShiftableOperator<PetscMesh<PetscScalar, 2>>
+  {
+    public:
+      using Mesh = PetscMesh<PetscScalar, 2>;
+
+      StencilOperator(std::shared_ptr<PetscMeshSpec<2>> spec,
+                      Stencil<PetscScalar, 2> stencil,
+                      PetscScalar shift = 0);
+
+      StencilOperator(const StencilOperator&) = delete;
+      StencilOperator& operator= (const StencilOperator&) = delete;
+
+      void apply_shifted_add(Mesh& result,
+                             PetscScalar alpha,
+                             PetscScalar shift,
+                             const Mesh& arg,
+                             PetscScalar beta) override;
+
+      /** The value that is added to the diagonal of the operator. */
+      PetscScalar shift() const { return m_shift; }
+      void shift(PetscScalar shift) { m_shift = shift; }
+
+      const Stencil<PetscScalar, 2>& stencil() const { return m_stencil; }
+
+      /**
+       Multiplies the coefficient of the `i_entry`-th stencil entry pointwise
+       by the values of the given mesh. The mesh must have the same
+       specification as the operator. Passing `nullptr` restores the constant
+       coefficient.
+       */
+      void coefficient_values(size_t i_entry,
+                              std::shared_ptr<const Mesh> values);
+
+      /**
+       Assembles the operator, with its current shift and coefficients, into
+       a sparse matrix, e.g., to set up an algebraic preconditioner.
+
+       The matrix is created by `DMCreateMatrix`, hence it has the layout and
+       the ordering of the mesh vectors. It is preallocated exactly with the
+       entries of the stencil, rather than the full stencil of the mesh, and
+       filled point by point with `MatSetValuesStencil`. Entries that refer
+       to the zero ghost values at `DM_BOUNDARY_GHOSTED` boundaries are
+       omitted. `DM_BOUNDARY_MIRROR` boundaries are not supported.
+       */
+      std::shared_ptr<PetscSparseMatrixStorage<PetscScalar>> assemble();
+
+    private:
+      std::shared_ptr<PetscMeshSpec<2>> m_spec;
+      Stencil<PetscScalar, 2> m_stencil;
+      PetscScalar m_shift;
+      std::vector<std::shared_ptr<const Mesh>> m_coefficient_values;
+
+      PetscLocalMesh<PetscScalar, 2> m_scratch;
+      std::array<bool, 2> m_zero_ghosts;
+
+      void zero_boundary();
+  };
+}
+
+#endif
+#endif
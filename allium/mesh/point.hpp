@@ -20,6 +20,7 @@
 #include <ostream>
 #include <algorithm>
 #include <numeric>
+#include <array>
 
 namespace allium {
 
@@ -0,0 +1,116 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_MESH_STENCIL_HPP
+#define ALLIUM_MESH_STENCIL_HPP
+
+#include <allium/util/numeric.hpp>
+#include "point.hpp"
+
+#include <cstdlib>
+#include <vector>
+
+namespace allium {
+
+  /**
+   @brief A compact description of a stencil on a structured mesh.
+
+   A stencil is a list of offsets with a coefficient each. Applied at the
+   point `p`, the stencil computes `sum_k c_k u(p + o_k)`. The same stencil
+   is applied to every degree of freedom of the mesh.
+   */
+  template <typename N, int D>
+  class Stencil {
+    public:
+      struct Entry {
+        Point<int, D> offset;
+        N coefficient;
+      };
+
+      Stencil() = default;
+
+      Stencil(std::initializer_list<Entry> entries)
+        : m_entries(entries)
+      {}
+
+      /** Adds the entry `coefficient * u(p + offset)`. */
+      void add(Point<int, D> offset, N coefficient) {
+        m_entries.push_back(Entry{offset, coefficient});
+      }
+
+      const std::vector<Entry>& entries() const { return m_entries; }
+
+      size_t size() const { return m_entries.size(); }
+
+      /** The largest distance from the center in any dimension. */
+      int width() const {
+        int w = 0;
+        for (const auto& e : m_entries) {
+          for (int i = 0; i < D; ++i) {
+            w = std::max(w, std::abs(e.offset[i]));
+          }
+        }
+        return w;
+      }
+
+      /** True if every offset differs from the center in at most one
+          dimension, i.e., the stencil has the shape of a star. */
+      bool is_star() const {
+        for (const auto& e : m_entries) {
+          int nonzero = 0;
+          for (int i = 0; i < D; ++i) {
+            if (e.offset[i] != 0)
+              ++nonzero;
+          }
+          if (nonzero > 1)
+            return false;
+        }
+        return true;
+      }
+
+    private:
+      std::vector<Entry> m_entries;
+  };
+
+  /**
+   The standard (2D+1)-point stencil of `-Δ` for the mesh width `h`.
+   */
+  template <typename N, int D>
+  Stencil<N, D> laplace_stencil(real_part_t<N> h) {
+    Stencil<N, D> stencil;
+
+    const N inv_h2 = N(1.0 / (h*h));
+    stencil.add(Point<int, D>::full(0), N(2*D) * inv_h2);
+    for (int i = 0; i < D; ++i) {
+      auto offset = Point<int, D>::full(0);
+      offset[i] = -1;
+      stencil.add(offset, -inv_h2);
+      offset[i] = 1;
+      stencil.add(offset, -inv_h2);
+    }
+
+    return stencil;
+  }
+
+  /**
+   @brief A matrix-free linear operator that applies a Stencil to the
+   vectors of a structured mesh.
+
+   The operator is specialized for each mesh backend that supports it.
+   */
+  template <typename V>
+  class StencilOperator;
+}
+
+#endif
@@ -0,0 +1,68 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "mapped_file.hpp"
+
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace allium {
+
+  MappedFile::MappedFile(const std::string& filename)
+    : m_data(nullptr), m_size(0)
+  {
+    int fd = open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw std::runtime_error("Could not open " + filename + ": "
+                               + std::strerror(errno));
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+      int error = errno;
+      close(fd);
+      throw std::runtime_error("Could not read " + filename + ": "
+                               + std::strerror(error));
+    }
+    m_size = info.st_size;
+
+    // mapping an empty file fails
+    if (m_size > 0) {
+      void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if (data == MAP_FAILED) {
+        int error = errno;
+        close(fd);
+        throw std::runtime_error("Could not map " + filename + ": "
+                                 + std::strerror(error));
+      }
+      m_data = static_cast<const char*>(data);
+    }
+
+    // the mapping stays valid after closing the file
+    close(fd);
+  }
+
+  MappedFile::~MappedFile()
+  {
+    if (m_data) {
+      munmap(const_cast<char*>(m_data), m_size);
+    }
+  }
+
+}
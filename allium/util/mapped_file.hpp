@@ -0,0 +1,47 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_UTIL_MAPPED_FILE_HPP
+#define ALLIUM_UTIL_MAPPED_FILE_HPP
+
+#include <cstddef>
+#include <string>
+
+namespace allium {
+
+  /**
+   @brief A file, which is mapped read-only into memory.
+
+   Only the pages that are accessed are read from the disk, hence, parts of
+   large files can be loaded efficiently.
+   */
+  class MappedFile {
+    public:
+      explicit MappedFile(const std::string& filename);
+      ~MappedFile();
+
+      MappedFile(const MappedFile&) = delete;
+      MappedFile& operator= (const MappedFile&) = delete;
+
+      const char* data() const { return m_data; }
+      size_t size() const { return m_size; }
+
+    private:
+      const char* m_data;
+      size_t m_size;
+  };
+
+}
+
+#endif
@@ -15,7 +15,10 @@
 #ifndef ALLIUM_UTIL_MEMORY_HPP
 #define ALLIUM_UTIL_MEMORY_HPP
 
+#include <cstdlib>
 #include <memory>
+#include <new>
+#include <vector>
 
 namespace allium {
 
@@ -37,6 +40,56 @@ namespace allium {
       return std::make_shared<typename std::remove_reference<T>::type>(std::forward<T>(v));
     }
 
+  /**
+   @brief Allocator, which aligns the allocated memory.
+
+   The default alignment of 64 bytes matches the cache line size and the
+   widest SIMD registers of common CPUs.
+   */
+  template <typename T, size_t Alignment = 64>
+  class AlignedAllocator {
+    public:
+      using value_type = T;
+
+      template <typename U>
+      struct rebind { using other = AlignedAllocator<U, Alignment>; };
+
+      AlignedAllocator() noexcept {}
+
+      template <typename U>
+      AlignedAllocator(const AlignedAllocator<U, Alignment>&) noexcept {}
+
+      T* allocate(size_t n) {
+        void* ptr = nullptr;
+        if (posix_memalign(&ptr, Alignment, n * sizeof(T)) != 0) {
+          throw std::bad_alloc();
+        }
+        return static_cast<T*>(ptr);
+      }
+
+      void deallocate(T* ptr, size_t) noexcept {
+        free(ptr);
+      }
+  };
+
+  template <typename T, typename U, size_t Alignment>
+  bool operator==(const AlignedAllocator<T, Alignment>&,
+                  const AlignedAllocator<U, Alignment>&) {
+    return true;
+  }
+
+  template <typename T, typename U, size_t Alignment>
+  bool operator!=(const AlignedAllocator<T, Alignment>&,
+                  const AlignedAllocator<U, Alignment>&) {
+    return false;
+  }
+
+  /**
+   @brief A std::vector whose data is aligned to cache lines.
+   */
+  template <typename T>
+  using aligned_vector = std::vector<T, AlignedAllocator<T>>;
+
 }
 
 #endif
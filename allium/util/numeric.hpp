@@ -138,6 +138,19 @@ namespace allium {
     return safe_lt(b, a);
   }
 
+  /**
+   The complex conjugate, which, unlike `std::conj`, keeps real numbers
+   real.
+   */
+  template <typename N>
+  N conj(N z) {
+    return std::conj(z);
+  }
+  template <>
+  double inline conj(double z) { return z; }
+  template <>
+  float inline conj(float z) { return z; }
+
 }
 
 #endif
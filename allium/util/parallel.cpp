@@ -0,0 +1,47 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "parallel.hpp"
+
+#include <allium/config.hpp>
+#include <stdexcept>
+#include <Eigen/Core>
+
+#ifdef ALLIUM_USE_OPENMP
+  #include <omp.h>
+#endif
+
+namespace allium {
+
+  int max_threads() {
+    #ifdef ALLIUM_USE_OPENMP
+      return omp_get_max_threads();
+    #else
+      return 1;
+    #endif
+  }
+
+  void set_max_threads(int threads) {
+    if (threads < 1) {
+      throw std::invalid_argument("At least one thread is required.");
+    }
+
+    #ifdef ALLIUM_USE_OPENMP
+      omp_set_num_threads(threads);
+      // Eigen's own kernels, e.g., the row-major sparse matrix-vector product
+      Eigen::setNbThreads(threads);
+    #endif
+  }
+
+}
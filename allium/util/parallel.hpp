@@ -0,0 +1,38 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_UTIL_PARALLEL_HPP
+#define ALLIUM_UTIL_PARALLEL_HPP
+
+namespace allium {
+
+  /**
+   @brief The maximal number of threads used by multithreaded kernels.
+
+   Without OpenMP support, this is always 1.
+   */
+  int max_threads();
+
+  /**
+   @brief Sets the maximal number of threads used by multithreaded kernels.
+
+   This overrides the `OMP_NUM_THREADS` environment variable and also
+   applies to the multithreaded kernels of Eigen. Without OpenMP support,
+   this function has no effect.
+   */
+  void set_max_threads(int threads);
+
+}
+
+#endif
@@ -0,0 +1,337 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark.hpp"
+
+#include <allium/config.hpp>
+#include <allium/util/parallel.hpp>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <ctime>
+#include <iomanip>
+#include <numeric>
+#include <regex>
+#include <sstream>
+#include <unistd.h>
+
+namespace bench {
+
+  double Result::min() const {
+    return *std::min_element(times.begin(), times.end());
+  }
+
+  double Result::max() const {
+    return *std::max_element(times.begin(), times.end());
+  }
+
+  double Result::mean() const {
+    return std::accumulate(times.begin(), times.end(), 0.0) / times.size();
+  }
+
+  double Result::median() const {
+    std::vector<double> sorted(times);
+    std::sort(sorted.begin(), sorted.end());
+
+    size_t n = sorted.size();
+    if (n % 2 == 1)
+      return sorted[n/2];
+    else
+      return 0.5 * (sorted[n/2-1] + sorted[n/2]);
+  }
+
+  double Result::stddev() const {
+    if (times.size() < 2)
+      return 0;
+
+    double m = mean();
+    double acc = 0;
+    for (auto t : times) {
+      acc += (t - m) * (t - m);
+    }
+    return std::sqrt(acc / (times.size() - 1));
+  }
+
+  State::State(const Options& options, allium::Comm comm, Result& result)
+    : m_options(options), m_comm(comm), m_result(result)
+  {}
+
+  double State::time_calls(const std::function<void()>& kernel, size_t calls)
+  {
+    using clock = std::chrono::steady_clock;
+
+    m_comm.barrier();
+    auto start = clock::now();
+    for (size_t i_call = 0; i_call < calls; ++i_call) {
+      kernel();
+    }
+    double elapsed
+      = std::chrono::duration<double>(clock::now() - start).count();
+
+    // the slowest rank determines the run time
+    double max_elapsed;
+    MPI_Allreduce(&elapsed, &max_elapsed, 1, MPI_DOUBLE, MPI_MAX,
+                  m_comm.handle());
+    return max_elapsed;
+  }
+
+  void State::run(const std::function<void()>& kernel)
+  {
+    for (int i_warmup = 0; i_warmup < m_options.warmup; ++i_warmup) {
+      kernel();
+    }
+
+    // Short kernels are called several times per repetition, such that
+    // the timer resolution does not distort the result.
+    size_t calls = 1;
+    while (time_calls(kernel, calls) < m_options.min_time) {
+      calls *= 2;
+    }
+
+    m_result.calls = calls;
+    m_result.times.clear();
+    for (int i_rep = 0; i_rep < m_options.repetitions; ++i_rep) {
+      m_result.times.push_back(time_calls(kernel, calls) / calls);
+    }
+  }
+
+  std::vector<Benchmark>& registry() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+  }
+
+  Registration::Registration(std::string name,
+                             std::vector<size_t> sizes,
+                             Function fun)
+  {
+    registry().push_back(Benchmark{name, sizes, fun});
+  }
+
+  std::vector<Result> run_benchmarks(const Options& options, allium::Comm comm)
+  {
+    std::regex filter(options.filter);
+
+    auto benchmarks = registry();
+    std::sort(benchmarks.begin(), benchmarks.end(),
+              [](const Benchmark& a, const Benchmark& b) {
+                return a.name < b.name;
+              });
+
+    std::vector<Result> results;
+    for (auto& b : benchmarks) {
+      if (!std::regex_search(b.name, filter))
+        continue;
+
+      for (auto size : b.sizes) {
+        Result result;
+        result.name = b.name;
+        result.size = size;
+
+        State state(options, comm, result);
+        b.function(state);
+
+        if (!result.skipped && result.times.empty()) {
+          throw std::logic_error("Benchmark " + b.name + " did not run.");
+        }
+
+        results.push_back(result);
+      }
+    }
+
+    return results;
+  }
+
+  static std::string format_rate(double value, const std::string& unit) {
+    const char* prefixes[] = { "", "k", "M", "G", "T", "P" };
+
+    int i_prefix = 0;
+    while (value >= 1000 && i_prefix < 5) {
+      value /= 1000;
+      ++i_prefix;
+    }
+
+    std::stringstream s;
+    s << std::fixed << std::setprecision(2) << value
+      << " " << prefixes[i_prefix] << unit;
+    return s.str();
+  }
+
+  void write_text(std::ostream& os, const std::vector<Result>& results)
+  {
+    os << std::left
+       << std::setw(40) << "benchmark"
+       << std::right
+       << std::setw(10) << "size"
+       << std::setw(14) << "median [s]"
+       << std::setw(10) << "dev [%]"
+       << std::setw(16) << "bandwidth"
+       << std::setw(16) << "flop rate"
+       << std::setw(14) << "item rate"
+       << std::endl;
+
+    for (auto& r : results) {
+      os << std::left << std::setw(40) << r.name
+         << std::right << std::setw(10) << r.size;
+
+      if (r.skipped) {
+        os << "  skipped: " << r.skip_reason << std::endl;
+        continue;
+      }
+
+      double median = r.median();
+      os << std::setw(14) << std::scientific << std::setprecision(3) << median
+         << std::setw(10) << std::fixed << std::setprecision(1)
+         << 100 * r.stddev() / r.mean()
+         << std::setw(16) << (r.bytes > 0 ? format_rate(r.bytes / median, "B/s") : "-")
+         << std::setw(16) << (r.flops > 0 ? format_rate(r.flops / median, "Flop/s") : "-")
+         << std::setw(14) << (r.items > 0 ? format_rate(r.items / median, "/s") : "-");
+
+      os << std::defaultfloat << std::setprecision(4);
+      for (auto& c : r.counters) {
+        os << "  " << c.first << "=" << c.second;
+      }
+      os << std::endl;
+    }
+  }
+
+  void write_csv(std::ostream& os, const std::vector<Result>& results)
+  {
+    os << "name,size,repetitions,calls,min,median,mean,max,stddev,"
+          "bytes,flops,items,counters" << std::endl;
+
+    os << std::setprecision(9);
+    for (auto& r : results) {
+      if (r.skipped)
+        continue;
+
+      os << r.name << ","
+         << r.size << ","
+         << r.times.size() << ","
+         << r.calls << ","
+         << r.min() << ","
+         << r.median() << ","
+         << r.mean() << ","
+         << r.max() << ","
+         << r.stddev() << ","
+         << r.bytes << ","
+         << r.flops << ","
+         << r.items << ",";
+
+      bool first = true;
+      for (auto& c : r.counters) {
+        if (first) first = false;
+        else os << ";";
+        os << c.first << "=" << c.second;
+      }
+      os << std::endl;
+    }
+  }
+
+  static std::string json_string(const std::string& s) {
+    std::stringstream out;
+    out << '"';
+    for (char c : s) {
+      switch (c) {
+        case '"': out << "\\\""; break;
+        case '\\': out << "\\\\"; break;
+        case '\n': out << "\\n"; break;
+        default: out << c;
+      }
+    }
+    out << '"';
+    return out.str();
+  }
+
+  void write_json(std::ostream& os,
+                  const Options& options,
+                  allium::Comm comm,
+                  const std::vector<Result>& results)
+  {
+    char hostname[256] = "";
+    gethostname(hostname, sizeof(hostname)-1);
+
+    char date[64] = "";
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", std::gmtime(&now));
+
+    os << std::setprecision(9);
+    os << "{" << std::endl
+       << "  \"context\": {" << std::endl
+       << "    \"label\": " << json_string(options.label) << "," << std::endl
+       << "    \"date\": " << json_string(date) << "," << std::endl
+       << "    \"host\": " << json_string(hostname) << "," << std::endl
+       << "    \"ranks\": " << comm.size() << "," << std::endl
+       << "    \"threads\": " << allium::max_threads() << "," << std::endl
+       << "    \"version\": " << json_string(ALLIUM_BENCHMARK_VERSION) << "," << std::endl
+       << "    \"build_type\": " << json_string(ALLIUM_BENCHMARK_BUILD_TYPE) << "," << std::endl
+       << "    \"compiler\": " << json_string(__VERSION__) << "," << std::endl
+       << "    \"repetitions\": " << options.repetitions << "," << std::endl
+       << "    \"warmup\": " << options.warmup << "," << std::endl
+       << "    \"min_time\": " << options.min_time << std::endl
+       << "  }," << std::endl
+       << "  \"benchmarks\": [";
+
+    bool first = true;
+    for (auto& r : results) {
+      if (first) first = false;
+      else os << ",";
+      os << std::endl;
+
+      os << "    {\"name\": " << json_string(r.name)
+         << ", \"size\": " << r.size;
+
+      if (r.skipped) {
+        os << ", \"skipped\": " << json_string(r.skip_reason) << "}";
+        continue;
+      }
+
+      os << ", \"calls\": " << r.calls
+         << ", \"min\": " << r.min()
+         << ", \"median\": " << r.median()
+         << ", \"mean\": " << r.mean()
+         << ", \"max\": " << r.max()
+         << ", \"stddev\": " << r.stddev()
+         << ", \"bytes\": " << r.bytes
+         << ", \"flops\": " << r.flops
+         << ", \"items\": " << r.items
+         << ", \"counters\": {";
+
+      bool first_counter = true;
+      for (auto& c : r.counters) {
+        if (first_counter) first_counter = false;
+        else os << ", ";
+        os << json_string(c.first) << ": " << c.second;
+      }
+
+      os << "}, \"times\": [";
+      for (size_t i = 0; i < r.times.size(); ++i) {
+        if (i > 0) os << ", ";
+        os << r.times[i];
+      }
+      os << "]}";
+    }
+    os << std::endl << "  ]" << std::endl
+       << "}" << std::endl;
+  }
+
+  allium::VectorSpec even_spec(allium::Comm comm, allium::global_size_t size)
+  {
+    size_t local_size = size / comm.size();
+    if (static_cast<size_t>(comm.rank()) < size % comm.size()) {
+      ++local_size;
+    }
+
+    return allium::VectorSpec(comm, local_size, size);
+  }
+}
@@ -0,0 +1,176 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_BENCHMARKS_BENCHMARK_HPP
+#define ALLIUM_BENCHMARKS_BENCHMARK_HPP
+
+#include <allium/config.hpp>
+#include <allium/ipc/comm.hpp>
+#include <allium/la/vector_spec.hpp>
+#include <allium/la/eigen_vector.hpp>
+#include <allium/la/cuda_vector.hpp>
+#include <functional>
+#include <map>
+#include <ostream>
+#include <string>
+#include <vector>
+
+namespace bench {
+
+  /**
+   @brief Settings that apply to all benchmarks of a run.
+   */
+  struct Options {
+    int repetitions = 10;
+    int warmup = 1;
+    double min_time = 0.05; ///< Minimal duration of one repetition in seconds.
+    std::string filter;
+    std::string format = "text";
+    std::string output;
+    std::string label;
+    bool roofline = false; ///< Compare the results with the machine peaks.
+  };
+
+  /**
+   @brief The measurements of a single benchmark at a single problem size.
+   */
+  struct Result {
+    std::string name;
+    size_t size = 0;
+    size_t calls = 0; ///< Number of kernel calls per repetition.
+    std::vector<double> times; ///< Seconds per kernel call, one per repetition.
+
+    double bytes = 0; ///< Bytes moved per kernel call.
+    double flops = 0; ///< Floating point operations per kernel call.
+    double items = 0; ///< Benchmark specific items per kernel call.
+    std::map<std::string, double> counters;
+
+    bool skipped = false;
+    std::string skip_reason;
+
+    double min() const;
+    double max() const;
+    double mean() const;
+    double median() const;
+    double stddev() const;
+  };
+
+  /**
+   @brief Interface between the benchmark runner and a benchmark function.
+
+   A benchmark function performs its setup, declares the amount of work done
+   by one call of its kernel, and finally passes the kernel to State::run,
+   which takes care of warm-up, calibration and repetitions.
+   */
+  class State {
+    public:
+      State(const Options& options, allium::Comm comm, Result& result);
+
+      /** The problem size the benchmark should use. */
+      size_t size() const { return m_result.size; }
+
+      allium::Comm comm() const { return m_comm; }
+
+      /** Bytes transferred from or to memory by one kernel call. */
+      void bytes(double value) { m_result.bytes = value; }
+
+      /** Floating point operations performed by one kernel call. */
+      void flops(double value) { m_result.flops = value; }
+
+      /** Number of items, e.g., time steps, processed by one kernel call. */
+      void items(double value) { m_result.items = value; }
+
+      /** Record an additional, benchmark specific value. */
+      void counter(const std::string& name, double value) {
+        m_result.counters[name] = value;
+      }
+
+      /** Mark the benchmark as not applicable for the current setting. */
+      void skip(const std::string& reason) {
+        m_result.skipped = true;
+        m_result.skip_reason = reason;
+      }
+
+      /** Time the kernel. */
+      void run(const std::function<void()>& kernel);
+
+    private:
+      const Options& m_options;
+      allium::Comm m_comm;
+      Result& m_result;
+
+      double time_calls(const std::function<void()>& kernel, size_t calls);
+  };
+
+  using Function = std::function<void(State&)>;
+
+  /**
+   @brief A benchmark that is run for a list of problem sizes.
+   */
+  struct Benchmark {
+    std::string name;
+    std::vector<size_t> sizes;
+    Function function;
+  };
+
+  std::vector<Benchmark>& registry();
+
+  /**
+   @brief Registers a benchmark when a static instance is constructed.
+   */
+  class Registration {
+    public:
+      Registration(std::string name, std::vector<size_t> sizes, Function fun);
+  };
+
+  /** Runs all registered benchmarks matching the filter. */
+  std::vector<Result> run_benchmarks(const Options& options, allium::Comm comm);
+
+  void write_text(std::ostream& os, const std::vector<Result>& results);
+  void write_csv(std::ostream& os, const std::vector<Result>& results);
+  void write_json(std::ostream& os,
+                  const Options& options,
+                  allium::Comm comm,
+                  const std::vector<Result>& results);
+
+  /** A vector specification, which splits the entries evenly across ranks. */
+  allium::VectorSpec even_spec(allium::Comm comm, allium::global_size_t size);
+
+  /** True if vectors of type V can be distributed across several ranks. */
+  template <typename V>
+  struct is_distributed : std::true_type {};
+
+  template <typename N>
+  struct is_distributed<allium::EigenVectorStorage<N>> : std::false_type {};
+
+  #ifdef ALLIUM_USE_CUDA
+  template <typename N>
+  struct is_distributed<allium::CudaVector<N>> : std::false_type {};
+  #endif
+
+  /**
+   Skips the benchmark if vectors of type V cannot be used with the current
+   number of ranks. Returns true if the benchmark can be run.
+   */
+  template <typename V>
+  bool require_ranks(State& state) {
+    if (!is_distributed<V>::value && state.comm().size() > 1) {
+      state.skip("not distributed");
+      return false;
+    }
+    return true;
+  }
+}
+
+#endif
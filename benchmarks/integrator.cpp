@@ -0,0 +1,122 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark.hpp"
+#include "problems.hpp"
+
+#include <allium/la/cg.hpp>
+#include <allium/la/default.hpp>
+#include <allium/ode/runge_kutta_4.hpp>
+#include <allium/ode/imex_euler.hpp>
+#include <allium/util/memory.hpp>
+
+using namespace allium;
+using namespace bench;
+
+namespace {
+
+  using Number = double;
+  using Matrix = DefaultSparseMatrix<Number>;
+  using Vector = typename Matrix::Vector;
+
+  // edge length of the 2D grid
+  const std::vector<size_t> sizes = { 32, 128, 512 };
+
+  // Number of time steps per kernel call. The step size is a power of two,
+  // such that the time steps are computed without rounding errors.
+  const int steps = 8;
+  const double dt = 0.125;
+
+  /** RK4 applied to the heat equation y' = -A y. */
+  void rk4_heat_2d(State& state) {
+    if (!require_ranks<DefaultVector<Number>>(state))
+      return;
+
+    global_size_t n = state.size();
+    auto spec = even_spec(state.comm(), n*n);
+
+    auto mat = std::make_shared<Matrix>(spec, spec);
+    mat->set_entries(laplace_2d<Number>(spec, n));
+
+    DefaultVector<Number> y0(spec);
+    y0.fill(1.0);
+
+    RungeKutta4<Vector> integrator(dt);
+    integrator.setup([mat](Vector& out, double t, const Vector& in) {
+      mat->apply(out, in);
+      out *= -1.0;
+    });
+    integrator.initial_value(0, y0);
+
+    state.items(steps);
+    state.run([&] {
+      integrator.integrate(integrator.current_argument() + steps * dt);
+    });
+  }
+
+  /**
+   IMEX Euler applied to the Fisher equation y' = -A y + y (1 - y), where the
+   implicit systems are solved by CG.
+   */
+  void imex_euler_fisher_2d(State& state) {
+    if (!require_ranks<DefaultVector<Number>>(state))
+      return;
+
+    global_size_t n = state.size();
+    auto spec = even_spec(state.comm(), n*n);
+
+    // (I + dt A) y = r is solved for the implicit part
+    auto mat = std::make_shared<Matrix>(spec, spec);
+    {
+      auto lmat = laplace_2d<Number>(spec, n, 1.0 / dt);
+      for (auto& value : lmat.values()) {
+        value *= dt;
+      }
+      mat->set_entries(std::move(lmat));
+    }
+
+    CgSolver<Vector> solver;
+    solver.setup(mat);
+
+    DefaultVector<Number> y0(spec);
+    y0.fill(0.5);
+
+    ImexEuler<Vector> integrator;
+    integrator.setup(
+      [](Vector& out, double t, const Vector& in) {
+        auto lout = local_slice(out);
+        auto lin = local_slice(in);
+        for (size_t i = 0; i < lin.size(); ++i) {
+          lout[i] = lin[i] * (1.0 - lin[i]);
+        }
+      },
+      [](Vector& out, double t, const Vector& in) {},
+      [&solver](Vector& y, double t, double a, const Vector& r,
+                InitialGuess initial_guess) {
+        solver.solve(y, r, initial_guess);
+      });
+    integrator.initial_value(0, y0);
+    integrator.dt(dt);
+
+    state.items(steps);
+    state.run([&] {
+      integrator.integrate(integrator.current_argument() + steps * dt);
+    });
+  }
+
+  Registration rk4("integrator/rk4/heat_2d", sizes, rk4_heat_2d);
+  Registration imex_euler("integrator/imex_euler/fisher_2d",
+                          sizes,
+                          imex_euler_fisher_2d);
+}
@@ -0,0 +1,144 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark.hpp"
+#include "roofline.hpp"
+
+#include <allium/main/init.hpp>
+#include <allium/util/parallel.hpp>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+
+using namespace bench;
+
+static void usage(const char* program) {
+  std::cerr
+    << "Usage: " << program << " [OPTIONS]" << std::endl
+    << std::endl
+    << "  --list               List the available benchmarks." << std::endl
+    << "  --filter=REGEX       Only run benchmarks matching REGEX." << std::endl
+    << "  --repetitions=N      Number of timed repetitions (default 10)." << std::endl
+    << "  --warmup=N           Number of untimed warm-up calls (default 1)." << std::endl
+    << "  --min-time=SECONDS   Minimal duration of a repetition (default 0.05)." << std::endl
+    << "  --format=FORMAT      Output format: text, csv or json." << std::endl
+    << "  --output=FILE        Write the results to FILE instead of stdout." << std::endl
+    << "  --label=TEXT         Label stored with the results, e.g., a commit." << std::endl
+    << "  --threads=N          Number of threads of multithreaded kernels." << std::endl
+    << "  --roofline           Report the performance relative to the measured" << std::endl
+    << "                       peak bandwidth and flop rate." << std::endl;
+}
+
+/** Returns true and stores the value if arg has the form `--name=value`. */
+static bool parse_option(const std::string& arg,
+                         const std::string& name,
+                         std::string& value)
+{
+  std::string prefix = "--" + name + "=";
+  if (arg.compare(0, prefix.size(), prefix) == 0) {
+    value = arg.substr(prefix.size());
+    return true;
+  }
+  return false;
+}
+
+int main(int argc, char** argv)
+{
+  allium::Init init(argc, argv);
+  auto comm = allium::Comm::world();
+
+  Options options;
+  bool list = false;
+
+  for (int i_arg = 1; i_arg < argc; ++i_arg) {
+    std::string arg = argv[i_arg];
+    std::string value;
+
+    if (arg == "--list") {
+      list = true;
+    } else if (arg == "--roofline") {
+      options.roofline = true;
+    } else if (arg == "--help") {
+      usage(argv[0]);
+      return EXIT_SUCCESS;
+    } else if (parse_option(arg, "filter", value)) {
+      options.filter = value;
+    } else if (parse_option(arg, "repetitions", value)) {
+      options.repetitions = std::stoi(value);
+    } else if (parse_option(arg, "warmup", value)) {
+      options.warmup = std::stoi(value);
+    } else if (parse_option(arg, "min-time", value)) {
+      options.min_time = std::stod(value);
+    } else if (parse_option(arg, "format", value)) {
+      options.format = value;
+    } else if (parse_option(arg, "output", value)) {
+      options.output = value;
+    } else if (parse_option(arg, "label", value)) {
+      options.label = value;
+    } else if (parse_option(arg, "threads", value)) {
+      allium::set_max_threads(std::stoi(value));
+    } else {
+      if (comm.rank() == 0) {
+        std::cerr << "Unknown option: " << arg << std::endl;
+        usage(argv[0]);
+      }
+      return EXIT_FAILURE;
+    }
+  }
+
+  if (options.repetitions < 1) {
+    std::cerr << "At least one repetition is required." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (options.format != "text"
+      && options.format != "csv"
+      && options.format != "json")
+  {
+    std::cerr << "Unknown output format: " << options.format << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (list) {
+    if (comm.rank() == 0) {
+      for (auto& b : registry()) {
+        std::cout << b.name << std::endl;
+      }
+    }
+    return EXIT_SUCCESS;
+  }
+
+  auto results = run_benchmarks(options, comm);
+  if (options.roofline) {
+    add_roofline(options, comm, results);
+  }
+
+  if (comm.rank() == 0) {
+    std::ofstream file;
+    if (!options.output.empty()) {
+      file.open(options.output);
+    }
+    std::ostream& os = options.output.empty() ? std::cout : file;
+
+    if (options.format == "text") {
+      write_text(os, results);
+    } else if (options.format == "csv") {
+      write_csv(os, results);
+    } else {
+      write_json(os, options, comm, results);
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
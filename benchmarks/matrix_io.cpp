@@ -0,0 +1,98 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark.hpp"
+#include "problems.hpp"
+
+#include <allium/la/csr_sparse_matrix.hpp>
+#include <allium/la/matrix_io.hpp>
+#include <cstdio>
+
+using namespace allium;
+using namespace bench;
+
+namespace {
+
+  // edge length of the 2D grid
+  const std::vector<size_t> sizes = { 64, 256, 1024 };
+
+  /** Reading the 2D Laplace operator from a Matrix Market file. */
+  void read_matrix_market_laplace_2d(State& state) {
+    global_size_t n = state.size();
+    auto spec = even_spec(state.comm(), n*n);
+    std::string filename
+      = "benchmark_laplace_2d_" + std::to_string(state.comm().rank()) + ".mtx";
+
+    write_matrix_market(filename, laplace_2d<double>(spec, n), n*n, n*n);
+
+    state.items(laplace_2d_nnz(n));
+    state.run([&] { read_matrix_market<double>(filename); });
+
+    std::remove(filename.c_str());
+  }
+
+  /** Reading the 2D Laplace operator from a binary CSR file. */
+  void read_binary_csr_laplace_2d(State& state) {
+    global_size_t n = state.size();
+    auto spec = even_spec(state.comm(), n*n);
+    std::string filename
+      = "benchmark_laplace_2d_" + std::to_string(state.comm().rank()) + ".csr";
+
+    write_binary_csr(filename,
+                     LocalCsrMatrix<double>(n*n, n*n,
+                                            laplace_2d<double>(spec, n)));
+
+    state.items(laplace_2d_nnz(n));
+    state.run([&] { read_binary_csr<double>(filename); });
+
+    std::remove(filename.c_str());
+  }
+
+  /**
+   Loading the 2D Laplace operator from a binary CSR file into a CSR matrix,
+   which takes over the rows without sorting them.
+   */
+  void load_binary_csr_laplace_2d(State& state) {
+    using Vector = EigenVectorStorage<double>;
+
+    if (!require_ranks<Vector>(state))
+      return;
+
+    global_size_t n = state.size();
+    auto spec = even_spec(state.comm(), n*n);
+    std::string filename
+      = "benchmark_laplace_2d_" + std::to_string(state.comm().rank()) + ".csr";
+
+    write_binary_csr(filename,
+                     LocalCsrMatrix<double>(n*n, n*n,
+                                            laplace_2d<double>(spec, n)));
+
+    CsrSparseMatrixStorage<double> mat(spec, spec);
+
+    state.items(laplace_2d_nnz(n));
+    state.run([&] { load_binary_csr(mat, filename); });
+
+    std::remove(filename.c_str());
+  }
+
+  Registration matrix_market("matrix_io/matrix_market/read_laplace_2d",
+                             sizes,
+                             read_matrix_market_laplace_2d);
+  Registration binary_csr("matrix_io/binary_csr/read_laplace_2d",
+                          sizes,
+                          read_binary_csr_laplace_2d);
+  Registration binary_csr_load("matrix_io/binary_csr/load_laplace_2d",
+                               sizes,
+                               load_binary_csr_laplace_2d);
+}
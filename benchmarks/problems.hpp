@@ -0,0 +1,92 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_BENCHMARKS_PROBLEMS_HPP
+#define ALLIUM_BENCHMARKS_PROBLEMS_HPP
+
+#include <allium/la/local_coo_matrix.hpp>
+#include <allium/la/vector_spec.hpp>
+
+namespace bench {
+
+  /**
+   Entries of the rows owned by the current rank of the five-point
+   discretization of the negative Laplace operator on an n x n grid with
+   Dirichlet boundary, plus `shift` times the identity.
+   */
+  template <typename N>
+  allium::LocalCooMatrix<N> laplace_2d(allium::VectorSpec spec,
+                                       allium::global_size_t n,
+                                       N shift = 0)
+  {
+    using allium::global_size_t;
+
+    allium::LocalCooMatrix<N> mat;
+    for (global_size_t row = spec.local_start(); row < spec.local_end(); ++row) {
+      global_size_t i = row % n;
+      global_size_t j = row / n;
+
+      if (j > 0)   mat.add(row, row - n, -1);
+      if (i > 0)   mat.add(row, row - 1, -1);
+      mat.add(row, row, N(4) + shift);
+      if (i < n-1) mat.add(row, row + 1, -1);
+      if (j < n-1) mat.add(row, row + n, -1);
+    }
+
+    return mat;
+  }
+
+  /**
+   Entries of the rows owned by the current rank of a 2D five-point stencil
+   for `b` components per grid point, where all components of neighboring
+   grid points are coupled, i.e., the matrix consists of dense b x b blocks.
+   The unknowns of a grid point are numbered consecutively.
+   */
+  template <typename N>
+  allium::LocalCooMatrix<N> coupled_laplace_2d(allium::VectorSpec spec,
+                                               allium::global_size_t n,
+                                               int b)
+  {
+    using allium::global_size_t;
+
+    allium::LocalCooMatrix<N> mat;
+    for (global_size_t row = spec.local_start(); row < spec.local_end(); ++row) {
+      global_size_t point = row / b;
+      global_size_t i = point % n;
+      global_size_t j = point / n;
+      int component = row % b;
+
+      auto add_block = [&](global_size_t other, N diagonal, N coupling) {
+        for (int c = 0; c < b; ++c) {
+          mat.add(row, other * b + c, c == component ? diagonal : coupling);
+        }
+      };
+
+      if (j > 0)   add_block(point - n, -1, -0.1);
+      if (i > 0)   add_block(point - 1, -1, -0.1);
+      add_block(point, 4 + b, -1);
+      if (i < n-1) add_block(point + 1, -1, -0.1);
+      if (j < n-1) add_block(point + n, -1, -0.1);
+    }
+
+    return mat;
+  }
+
+  /** The number of non-zero entries of laplace_2d. */
+  inline double laplace_2d_nnz(allium::global_size_t n) {
+    return 5.0 * n * n - 4.0 * n;
+  }
+}
+
+#endif
@@ -0,0 +1,225 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "roofline.hpp"
+
+#include <allium/config.hpp>
+#include <allium/util/parallel.hpp>
+#include <Eigen/Core>
+#include <algorithm>
+#include <memory>
+
+using namespace allium;
+
+namespace bench {
+
+  namespace {
+
+    // These sizes are per array. The largest one should exceed the caches.
+    const std::vector<size_t> stream_sizes = { 1 << 14, 1 << 18, 1 << 22 };
+
+    // Number of kernel iterations of the flop benchmark.
+    const std::vector<size_t> flop_sizes = { 1 << 20 };
+
+    /**
+     STREAM kernels on plain arrays. Every rank works on its share of the
+     arrays with max_threads() threads, i.e., the aggregated bandwidth is
+     measured.
+     */
+    enum class StreamKernel { COPY, SCALE, ADD, TRIAD };
+
+    template <StreamKernel kernel>
+    void stream(State& state) {
+      const long n = even_spec(state.comm(), state.size()).local_size();
+      const int threads = max_threads();
+      std::unique_ptr<double[]> va(new double[n]);
+      std::unique_ptr<double[]> vb(new double[n]);
+      std::unique_ptr<double[]> vc(new double[n]);
+      double* a = va.get();
+      double* b = vb.get();
+      double* c = vc.get();
+      const double s = 3.0;
+
+      // the arrays are first touched with the same schedule as the kernels,
+      // such that the pages are local to the threads using them
+      #ifdef ALLIUM_USE_OPENMP
+      #pragma omp parallel for schedule(static) num_threads(threads)
+      #endif
+      for (long i = 0; i < n; ++i) {
+        a[i] = 1.0;
+        b[i] = 2.0;
+        c[i] = 0.0;
+      }
+
+      switch (kernel) {
+        case StreamKernel::COPY:
+          state.bytes(2.0 * state.size() * sizeof(double));
+          state.run([=] {
+            #ifdef ALLIUM_USE_OPENMP
+            #pragma omp parallel for schedule(static) num_threads(threads)
+            #endif
+            for (long i = 0; i < n; ++i) c[i] = a[i];
+          });
+          break;
+        case StreamKernel::SCALE:
+          state.bytes(2.0 * state.size() * sizeof(double));
+          state.flops(1.0 * state.size());
+          state.run([=] {
+            #ifdef ALLIUM_USE_OPENMP
+            #pragma omp parallel for schedule(static) num_threads(threads)
+            #endif
+            for (long i = 0; i < n; ++i) b[i] = s*c[i];
+          });
+          break;
+        case StreamKernel::ADD:
+          state.bytes(3.0 * state.size() * sizeof(double));
+          state.flops(1.0 * state.size());
+          state.run([=] {
+            #ifdef ALLIUM_USE_OPENMP
+            #pragma omp parallel for schedule(static) num_threads(threads)
+            #endif
+            for (long i = 0; i < n; ++i) c[i] = a[i]+b[i];
+          });
+          break;
+        case StreamKernel::TRIAD:
+          state.bytes(3.0 * state.size() * sizeof(double));
+          state.flops(2.0 * state.size());
+          state.run([=] {
+            #ifdef ALLIUM_USE_OPENMP
+            #pragma omp parallel for schedule(static) num_threads(threads)
+            #endif
+            for (long i = 0; i < n; ++i) a[i] = b[i]+s*c[i];
+          });
+          break;
+      }
+    }
+
+    // Keep the compiler from evaluating the flop kernel at compile time or
+    // removing it.
+    volatile double flop_factor = 0.999;
+    volatile double flop_offset = 1e-3;
+    volatile double flop_sink;
+
+    /**
+     Multiply-add on many independent accumulators, which stay in registers.
+     Eigen vectorizes the update with the same instruction set the library
+     is compiled with. Every one of the max_threads() threads runs the
+     kernel.
+     */
+    void flops(State& state) {
+      using Accumulators = Eigen::Array<double, 32, 1>;
+      size_t iterations = state.size();
+      const int threads = max_threads();
+
+      state.flops(2.0 * Accumulators::SizeAtCompileTime
+                  * iterations * threads * state.comm().size());
+      state.run([=] {
+        double sum = 0;
+
+        #ifdef ALLIUM_USE_OPENMP
+        #pragma omp parallel num_threads(threads) reduction(+:sum)
+        #endif
+        {
+          double a = flop_factor;
+          double b = flop_offset;
+          Accumulators acc = Accumulators::LinSpaced(0.0, 1.0);
+          for (size_t i = 0; i < iterations; ++i) {
+            acc = acc * a + b;
+          }
+          sum += acc.sum();
+        }
+
+        flop_sink = sum;
+      });
+    }
+
+    Registration stream_copy("peak/stream/copy",
+                             stream_sizes, stream<StreamKernel::COPY>);
+    Registration stream_scale("peak/stream/scale",
+                              stream_sizes, stream<StreamKernel::SCALE>);
+    Registration stream_add("peak/stream/add",
+                            stream_sizes, stream<StreamKernel::ADD>);
+    Registration stream_triad("peak/stream/triad",
+                              stream_sizes, stream<StreamKernel::TRIAD>);
+    Registration flop_rate("peak/flops", flop_sizes, flops);
+
+    bool has_prefix(const std::string& s, const std::string& prefix) {
+      return s.compare(0, prefix.size(), prefix) == 0;
+    }
+  }
+
+  Peak find_peak(const std::vector<Result>& results)
+  {
+    Peak peak;
+
+    size_t stream_size = 0;
+    for (auto& r : results) {
+      if (has_prefix(r.name, "peak/stream/") && !r.skipped)
+        stream_size = std::max(stream_size, r.size);
+    }
+
+    for (auto& r : results) {
+      if (r.skipped)
+        continue;
+
+      if (has_prefix(r.name, "peak/stream/") && r.size == stream_size) {
+        peak.bandwidth = std::max(peak.bandwidth, r.bytes / r.median());
+      } else if (r.name == "peak/flops") {
+        peak.flop_rate = std::max(peak.flop_rate, r.flops / r.median());
+      }
+    }
+
+    return peak;
+  }
+
+  void add_roofline(const Options& options,
+                    allium::Comm comm,
+                    std::vector<Result>& results)
+  {
+    Peak peak = find_peak(results);
+    if (peak.bandwidth == 0 || peak.flop_rate == 0) {
+      Options peak_options = options;
+      peak_options.filter = "^peak/";
+
+      auto peak_results = run_benchmarks(peak_options, comm);
+      peak = find_peak(peak_results);
+
+      // replace a partial set of peak results
+      results.erase(std::remove_if(results.begin(), results.end(),
+                                   [](const Result& r) {
+                                     return has_prefix(r.name, "peak/");
+                                   }),
+                    results.end());
+      results.insert(results.begin(), peak_results.begin(), peak_results.end());
+    }
+
+    for (auto& r : results) {
+      if (r.skipped || r.bytes == 0)
+        continue;
+
+      double median = r.median();
+      double intensity = r.flops / r.bytes;
+      double percent;
+      if (r.flops > 0) {
+        double bound = std::min(peak.flop_rate, intensity * peak.bandwidth);
+        percent = 100 * (r.flops / median) / bound;
+      } else {
+        percent = 100 * (r.bytes / median) / peak.bandwidth;
+      }
+
+      r.counters["intensity"] = intensity;
+      r.counters["roofline_pct"] = percent;
+    }
+  }
+}
@@ -0,0 +1,51 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#ifndef ALLIUM_BENCHMARKS_ROOFLINE_HPP
+#define ALLIUM_BENCHMARKS_ROOFLINE_HPP
+
+#include "benchmark.hpp"
+
+namespace bench {
+
+  /**
+   @brief Machine peaks, as measured by the `peak/...` benchmarks.
+   */
+  struct Peak {
+    double bandwidth = 0; ///< Bytes per second.
+    double flop_rate = 0; ///< Floating point operations per second.
+  };
+
+  /**
+   Determines the peaks from the results of the `peak/...` benchmarks. The
+   peak bandwidth is the best STREAM result at the largest size, which is
+   the size least affected by caches.
+   */
+  Peak find_peak(const std::vector<Result>& results);
+
+  /**
+   Adds the counters `intensity` (flops per byte) and `roofline_pct` to all
+   results that declare their memory traffic. The latter is the achieved
+   performance in percent of the roofline bound
+   `min(peak flop rate, intensity * peak bandwidth)`. Kernels without flops
+   are compared against the peak bandwidth.
+
+   If the results do not contain the peak benchmarks, they are run first.
+   */
+  void add_roofline(const Options& options,
+                    allium::Comm comm,
+                    std::vector<Result>& results);
+}
+
+#endif
@@ -0,0 +1,91 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark.hpp"
+#include "problems.hpp"
+
+#include <allium/la/cg.hpp>
+#include <allium/la/gmres.hpp>
+#include <allium/la/default.hpp>
+#include <allium/la/incomplete_factorization.hpp>
+
+using namespace allium;
+using namespace bench;
+
+namespace {
+
+  using Number = double;
+  using Matrix = DefaultSparseMatrix<Number>;
+  using Vector = typename Matrix::Vector;
+
+  // edge length of the 2D grid
+  const std::vector<size_t> sizes = { 32, 64, 128 };
+
+  /** No preconditioner. */
+  struct NoPreconditioner {};
+
+  template <typename Solver>
+  void set_preconditioner(Solver&, Matrix&, NoPreconditioner*) {}
+
+  template <typename Solver, typename Preconditioner>
+  void set_preconditioner(Solver& solver, Matrix& mat, Preconditioner*) {
+    solver.preconditioner(std::make_shared<Preconditioner>(mat));
+  }
+
+  /**
+   Time to solve the 2D Laplace problem with the given solver. The
+   preconditioner is set up once, outside of the timed region.
+   */
+  template <typename Solver, typename Preconditioner = NoPreconditioner>
+  void solve_laplace_2d(State& state) {
+    if (!require_ranks<DefaultVector<Number>>(state))
+      return;
+
+    global_size_t n = state.size();
+    auto spec = even_spec(state.comm(), n*n);
+
+    auto mat = std::make_shared<Matrix>(spec, spec);
+    mat->set_entries(laplace_2d<Number>(spec, n));
+
+    DefaultVector<Number> rhs(spec);
+    DefaultVector<Number> solution(spec);
+    rhs.fill(1.0);
+
+    Solver solver;
+    solver.setup(mat);
+    set_preconditioner(solver, *mat, static_cast<Preconditioner*>(nullptr));
+
+    state.items(1);
+    state.run([&] {
+      solver.solve(solution, rhs, InitialGuess::NOT_PROVIDED);
+    });
+
+    state.counter("iterations", solver.iteration_count());
+  }
+
+  Registration cg("solver/cg/laplace_2d",
+                  sizes,
+                  solve_laplace_2d<CgSolver<Vector>>);
+  Registration gmres("solver/gmres/laplace_2d",
+                     sizes,
+                     solve_laplace_2d<GmresSolver<Vector>>);
+  Registration cg_ic("solver/cg_ic/laplace_2d",
+                     sizes,
+                     solve_laplace_2d<CgSolver<Vector>,
+                                      IcPreconditioner<Vector>>);
+  Registration gmres_ilu("solver/gmres_ilu/laplace_2d",
+                         sizes,
+                         solve_laplace_2d<GmresSolver<Vector>,
+                                          IluPreconditioner<Vector>>);
+}
@@ -0,0 +1,366 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark.hpp"
+#include "problems.hpp"
+
+#include <allium/config.hpp>
+#include <allium/la/autotuned_sparse_matrix.hpp>
+#include <allium/la/bsr_sparse_matrix.hpp>
+#include <allium/la/compact_csr_sparse_matrix.hpp>
+#include <allium/la/csr_sparse_matrix.hpp>
+#include <allium/la/distributed_csr_sparse_matrix.hpp>
+#include <allium/la/eigen_sparse_matrix.hpp>
+#include <allium/la/multi_vector.hpp>
+#include <allium/la/petsc_sparse_matrix.hpp>
+#include <allium/la/reordering.hpp>
+#include <allium/la/sell_sparse_matrix.hpp>
+#include <allium/la/sparse_product.hpp>
+#include <allium/la/symmetric_csr_sparse_matrix.hpp>
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+using namespace allium;
+using namespace bench;
+
+namespace {
+
+  // edge length of the 2D grid
+  const std::vector<size_t> sizes = { 64, 256, 1024 };
+
+  /** The number type, in which a format stores the matrix values. */
+  template <typename M>
+  struct StoredNumber { using type = typename M::Number; };
+
+  template <typename N, typename S>
+  struct StoredNumber<CompactCsrSparseMatrixStorage<N, S>> { using type = S; };
+
+  /** Sparse matrix-vector product with the 2D Laplace operator. */
+  template <typename M>
+  void apply_laplace_2d(State& state) {
+    using Number = typename M::Number;
+    using Vector = typename M::DefaultVector;
+
+    if (!require_ranks<Vector>(state))
+      return;
+
+    global_size_t n = state.size();
+    auto spec = even_spec(state.comm(), n*n);
+
+    M mat(spec, spec);
+    mat.set_entries(laplace_2d<Number>(spec, n));
+
+    Vector x(spec);
+    Vector y(spec);
+    x.fill(1.0);
+
+    // Minimal memory traffic: the matrix values and column indices, the row
+    // pointers, the input and the output vector. The actual index type
+    // depends on the format.
+    double nnz = laplace_2d_nnz(n);
+    state.bytes(nnz * (sizeof(typename StoredNumber<M>::type) + sizeof(int))
+                + n*n * (sizeof(int) + 2 * sizeof(Number)));
+    state.flops(2 * nnz);
+    state.run([&] { mat.apply(y, x); });
+  }
+
+  /**
+   Residual `r = b - A x` of the 2D Laplace operator, computed by apply_add
+   such that the product accumulates into the residual directly.
+   */
+  template <typename M>
+  void residual_laplace_2d(State& state) {
+    using Number = typename M::Number;
+    using Vector = typename M::DefaultVector;
+
+    if (!require_ranks<Vector>(state))
+      return;
+
+    global_size_t n = state.size();
+    auto spec = even_spec(state.comm(), n*n);
+
+    M mat(spec, spec);
+    mat.set_entries(laplace_2d<Number>(spec, n));
+
+    Vector x(spec);
+    Vector b(spec);
+    Vector r(spec);
+    x.fill(1.0);
+    b.fill(1.0);
+
+    // like apply, plus reading the right-hand side and the residual
+    double nnz = laplace_2d_nnz(n);
+    state.bytes(nnz * (sizeof(typename StoredNumber<M>::type) + sizeof(int))
+                + n*n * (sizeof(int) + 4 * sizeof(Number)));
+    state.flops(2 * nnz + n*n);
+    state.run([&] {
+      r.assign(b);
+      mat.apply_add(r, -1.0, x, 1.0);
+    });
+  }
+
+  /**
+   Product of the 2D Laplace operator with a block of k vectors. With
+   `block` set, the vectors are interleaved and multiplied by a single
+   apply_block, otherwise they are multiplied one at a time.
+   */
+  template <typename M, bool block>
+  void apply_block_laplace_2d(State& state) {
+    using Number = typename M::Number;
+    using Vector = typename M::DefaultVector;
+    using Block = MultiVector<Number, Eigen::RowMajor>;
+    const int k = 8;
+
+    if (!require_ranks<Vector>(state))
+      return;
+
+    global_size_t n = state.size();
+    auto spec = even_spec(state.comm(), n*n);
+
+    M mat(spec, spec);
+    mat.set_entries(laplace_2d<Number>(spec, n));
+
+    // The matrix is read once per block and once per vector, respectively.
+    double nnz = laplace_2d_nnz(n);
+    double matrix_bytes = nnz * (sizeof(Number) + sizeof(int))
+                          + n*n * sizeof(int);
+    state.bytes((block ? 1 : k) * matrix_bytes
+                + k * n*n * 2 * sizeof(Number));
+    state.flops(2 * k * nnz);
+
+    if (block) {
+      Block x(spec, k);
+      Block y(spec, k);
+      x.fill(1.0);
+      state.run([&] { mat.apply_block(y, x); });
+    }
+    else {
+      std::vector<Vector> x(k, Vector(spec));
+      std::vector<Vector> y(k, Vector(spec));
+      for (auto& v : x) {
+        v.fill(1.0);
+      }
+      state.run([&] {
+        for (int i = 0; i < k; ++i) {
+          mat.apply(y[i], x[i]);
+        }
+      });
+    }
+  }
+
+  /** Assembly of the 2D Laplace operator from coordinate format. */
+  template <typename M>
+  void assemble_laplace_2d(State& state) {
+    using Number = typename M::Number;
+    using Vector = typename M::DefaultVector;
+
+    if (!require_ranks<Vector>(state))
+      return;
+
+    global_size_t n = state.size();
+    auto spec = even_spec(state.comm(), n*n);
+
+    auto lmat = laplace_2d<Number>(spec, n);
+    M mat(spec, spec);
+
+    state.items(laplace_2d_nnz(n));
+    state.run([&] { mat.set_entries(lmat); });
+  }
+
+  /**
+   Sparse matrix-vector product with the 2D Laplace operator, whose unknowns
+   are numbered randomly, as it happens for unstructured inputs. Optionally,
+   the matrix is reordered by reverse Cuthill-McKee first.
+   */
+  template <bool reorder>
+  void apply_shuffled_laplace_2d(State& state) {
+    using Number = double;
+    using Vector = EigenVectorStorage<Number>;
+
+    if (!require_ranks<Vector>(state))
+      return;
+
+    global_size_t n = state.size();
+    auto spec = even_spec(state.comm(), n*n);
+
+    std::vector<global_size_t> indices(n*n);
+    std::iota(indices.begin(), indices.end(), 0);
+    std::shuffle(indices.begin(), indices.end(), std::mt19937(42));
+    auto lmat = permute(laplace_2d<Number>(spec, n),
+                        Permutation(std::move(indices)));
+
+    if (reorder) {
+      lmat = permute(lmat, reverse_cuthill_mckee(lmat, n*n));
+    }
+
+    CsrSparseMatrixStorage<Number> mat(spec, spec);
+    mat.set_entries(std::move(lmat));
+
+    Vector x(spec);
+    Vector y(spec);
+    x.fill(1.0);
+
+    double nnz = laplace_2d_nnz(n);
+    state.bytes(nnz * (sizeof(Number) + sizeof(int))
+                + n*n * (sizeof(int) + 2 * sizeof(Number)));
+    state.flops(2 * nnz);
+    state.run([&] { mat.apply(y, x); });
+  }
+
+  /**
+   Numeric phase of the product of the 2D Laplace operator with itself,
+   i.e., the time to update the product after the values have changed.
+   */
+  template <typename M>
+  void multiply_laplace_2d(State& state) {
+    using Number = typename M::Number;
+    using Vector = typename M::DefaultVector;
+
+    if (!require_ranks<Vector>(state))
+      return;
+
+    global_size_t n = state.size();
+    auto spec = even_spec(state.comm(), n*n);
+
+    auto mat = std::make_shared<M>(spec, spec);
+    mat->set_entries(laplace_2d<Number>(spec, n));
+
+    SparseProduct<M> product(mat, mat);
+
+    state.items(product.result()->get_entries().entry_count());
+    state.run([&] { product.update(); });
+  }
+
+  /**
+   Sparse matrix-vector product with the 2D Laplace operator for four
+   coupled components per grid point, using the block size as a hint for the
+   storage format.
+   */
+  template <int block_size>
+  void apply_coupled_laplace_2d(State& state) {
+    using Number = double;
+    using Vector = EigenVectorStorage<Number>;
+    const int b = 4;
+
+    if (!require_ranks<Vector>(state))
+      return;
+
+    global_size_t n = state.size();
+    auto spec = even_spec(state.comm(), n*n*b);
+
+    auto mat = make_block_sparse_matrix<Number>(spec, spec, block_size);
+    mat->set_entries(coupled_laplace_2d<Number>(spec, n, b));
+
+    Vector x(spec);
+    Vector y(spec);
+    x.fill(1.0);
+
+    // CSR and BSR store the same entries here, but BSR has fewer indices
+    double nnz = laplace_2d_nnz(n) * b * b;
+    double index_count = block_size > 1 ? nnz / (b*b) : nnz;
+    state.bytes(nnz * sizeof(Number) + index_count * sizeof(int)
+                + n*n*b * 2 * sizeof(Number));
+    state.flops(2 * nnz);
+    state.run([&] { mat->apply(y, x); });
+  }
+
+  Registration eigen_apply("sparse_matrix/eigen/apply_laplace_2d",
+                           sizes,
+                           apply_laplace_2d<EigenSparseMatrixStorage<double>>);
+  Registration eigen_row_major_apply("sparse_matrix/eigen_row_major/apply_laplace_2d",
+                                     sizes,
+                                     apply_laplace_2d<EigenRowMajorSparseMatrixStorage<double>>);
+  Registration eigen_row_major_residual("sparse_matrix/eigen_row_major/residual_laplace_2d",
+                                        sizes,
+                                        residual_laplace_2d<EigenRowMajorSparseMatrixStorage<double>>);
+  Registration csr_residual("sparse_matrix/csr/residual_laplace_2d",
+                            sizes,
+                            residual_laplace_2d<CsrSparseMatrixStorage<double>>);
+  Registration csr_apply_block("sparse_matrix/csr/apply_block_laplace_2d",
+                               sizes,
+                               apply_block_laplace_2d<CsrSparseMatrixStorage<double>, true>);
+  Registration csr_apply_separate("sparse_matrix/csr/apply_separate_laplace_2d",
+                                  sizes,
+                                  apply_block_laplace_2d<CsrSparseMatrixStorage<double>, false>);
+  Registration eigen_row_major_apply_block("sparse_matrix/eigen_row_major/apply_block_laplace_2d",
+                                           sizes,
+                                           apply_block_laplace_2d<EigenRowMajorSparseMatrixStorage<double>, true>);
+  Registration distributed_csr_apply_block("sparse_matrix/distributed_csr/apply_block_laplace_2d",
+                                           sizes,
+                                           apply_block_laplace_2d<DistributedCsrSparseMatrixStorage<double>, true>);
+  Registration csr_apply("sparse_matrix/csr/apply_laplace_2d",
+                         sizes,
+                         apply_laplace_2d<CsrSparseMatrixStorage<double>>);
+  Registration compact_csr_apply("sparse_matrix/compact_csr/apply_laplace_2d",
+                                 sizes,
+                                 apply_laplace_2d<CompactCsrSparseMatrixStorage<double>>);
+  Registration mixed_csr_apply("sparse_matrix/compact_csr_float/apply_laplace_2d",
+                               sizes,
+                               apply_laplace_2d<CompactCsrSparseMatrixStorage<double, float>>);
+  Registration distributed_csr_apply("sparse_matrix/distributed_csr/apply_laplace_2d",
+                                    sizes,
+                                    apply_laplace_2d<DistributedCsrSparseMatrixStorage<double>>);
+  Registration autotuned_apply("sparse_matrix/autotuned/apply_laplace_2d",
+                               sizes,
+                               apply_laplace_2d<AutotunedSparseMatrixStorage<double>>);
+  // the bandwidth is based on the entries of both triangles
+  Registration symmetric_csr_apply("sparse_matrix/symmetric_csr/apply_laplace_2d",
+                                   sizes,
+                                   apply_laplace_2d<SymmetricCsrSparseMatrixStorage<double>>);
+  Registration sell_apply("sparse_matrix/sell/apply_laplace_2d",
+                          sizes,
+                          apply_laplace_2d<SellSparseMatrixStorage<double>>);
+  Registration csr_coupled("sparse_matrix/csr/apply_coupled_laplace_2d",
+                           sizes,
+                           apply_coupled_laplace_2d<1>);
+  Registration bsr_coupled("sparse_matrix/bsr/apply_coupled_laplace_2d",
+                           sizes,
+                           apply_coupled_laplace_2d<4>);
+  Registration eigen_assemble("sparse_matrix/eigen/assemble_laplace_2d",
+                              sizes,
+                              assemble_laplace_2d<EigenSparseMatrixStorage<double>>);
+  Registration csr_assemble("sparse_matrix/csr/assemble_laplace_2d",
+                            sizes,
+                            assemble_laplace_2d<CsrSparseMatrixStorage<double>>);
+  Registration distributed_csr_assemble("sparse_matrix/distributed_csr/assemble_laplace_2d",
+                                       sizes,
+                                       assemble_laplace_2d<DistributedCsrSparseMatrixStorage<double>>);
+  Registration csr_shuffled("sparse_matrix/csr/apply_shuffled_laplace_2d",
+                            sizes,
+                            apply_shuffled_laplace_2d<false>);
+  Registration csr_rcm("sparse_matrix/csr/apply_rcm_laplace_2d",
+                       sizes,
+                       apply_shuffled_laplace_2d<true>);
+  Registration eigen_multiply("sparse_matrix/eigen/multiply_laplace_2d",
+                              sizes,
+                              multiply_laplace_2d<EigenSparseMatrixStorage<double>>);
+  Registration eigen_row_major_multiply("sparse_matrix/eigen_row_major/multiply_laplace_2d",
+                                        sizes,
+                                        multiply_laplace_2d<EigenRowMajorSparseMatrixStorage<double>>);
+  Registration csr_multiply("sparse_matrix/csr/multiply_laplace_2d",
+                            sizes,
+                            multiply_laplace_2d<CsrSparseMatrixStorage<double>>);
+  #ifdef ALLIUM_USE_PETSC
+  Registration petsc_assemble("sparse_matrix/petsc/assemble_laplace_2d",
+                              sizes,
+                              assemble_laplace_2d<PetscSparseMatrixStorage<double>>);
+  Registration petsc_apply("sparse_matrix/petsc/apply_laplace_2d",
+                           sizes,
+                           apply_laplace_2d<PetscSparseMatrixStorage<double>>);
+  Registration petsc_residual("sparse_matrix/petsc/residual_laplace_2d",
+                              sizes,
+                              residual_laplace_2d<PetscSparseMatrixStorage<double>>);
+  #endif
+}
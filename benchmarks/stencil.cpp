@@ -0,0 +1,167 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark.hpp"
+
+#include <allium/config.hpp>
+
+#ifdef ALLIUM_USE_PETSC
+
+#include <allium/mesh/petsc_mesh_spec.hpp>
+#include <allium/mesh/petsc_mesh.hpp>
+#include <allium/mesh/petsc_stencil_operator.hpp>
+
+using namespace allium;
+using namespace bench;
+
+namespace {
+
+  using Mesh = PetscMesh<double, 2>;
+  using LocalMesh = PetscLocalMesh<double, 2>;
+
+  // edge length of the 2D grid
+  const std::vector<size_t> sizes = { 64, 256, 1024 };
+
+  void zero_boundary(::LocalMesh& mesh)
+  {
+    auto global_range = mesh.mesh_spec()->range();
+    auto range = mesh.mesh_spec()->local_ghost_range();
+    auto lmesh = local_mesh(mesh);
+
+    for (auto p : range) {
+      if (p[0] == -1
+          || p[1] == -1
+          || p[0] == global_range.end_pos()[0]
+          || p[1] == global_range.end_pos()[1]) {
+        lmesh(p[0], p[1]) = 0;
+      }
+    }
+  }
+
+  /**
+   Compute `f = (-Δ + a I) u` the same way the demo applications do.
+   */
+  void apply_shifted_laplace(Mesh& f, double h, double a, const Mesh& u)
+  {
+    ::LocalMesh u_aux(u.mesh_spec());
+    u_aux.assign(u);
+
+    zero_boundary(u_aux);
+
+    auto range = u.mesh_spec()->local_range();
+    auto lu = local_mesh(u_aux);
+    auto lf = local_mesh(f);
+
+    for (auto p : range) {
+      lf(p[0], p[1])
+        = (1.0 / (h*h))
+          * ( (4+a*(h*h)) * lu(p[0],   p[1])
+              - lu(p[0]-1, p[1])
+              - lu(p[0],   p[1]-1)
+              - lu(p[0],   p[1]+1)
+              - lu(p[0]+1, p[1]));
+    }
+  }
+
+  std::shared_ptr<PetscMeshSpec<2>> mesh_spec(State& state) {
+    global_size_t n = state.size();
+    return std::shared_ptr<PetscMeshSpec<2>>(
+             new PetscMeshSpec<2>(
+               state.comm(),
+               {DM_BOUNDARY_GHOSTED, DM_BOUNDARY_GHOSTED},
+               DMDA_STENCIL_STAR,
+               {n, n}, // global size
+               {PETSC_DECIDE, PETSC_DECIDE}, // processors per dim
+               1, // ndof
+               1)); // stencil_width
+  }
+
+  void shifted_laplace(State& state) {
+    global_size_t n = state.size();
+    double h = 1.0 / (n-1);
+
+    auto spec = mesh_spec(state);
+
+    Mesh u(spec);
+    Mesh f(spec);
+    u.fill(1.0);
+
+    state.bytes(2.0 * n * n * sizeof(double));
+    state.flops(7.0 * n * n);
+    state.run([&] { apply_shifted_laplace(f, h, 1.0, u); });
+  }
+
+  /** The same operator, applied by StencilOperator. */
+  void stencil_operator(State& state) {
+    global_size_t n = state.size();
+    double h = 1.0 / (n-1);
+
+    auto spec = mesh_spec(state);
+    StencilOperator<Mesh> op(spec, laplace_stencil<double, 2>(h), 1.0);
+
+    Mesh u(spec);
+    Mesh f(spec);
+    u.fill(1.0);
+
+    state.bytes(2.0 * n * n * sizeof(double));
+    state.flops(7.0 * n * n);
+    state.run([&] { op.apply(f, u); });
+  }
+
+  /** The same operator, assembled into a sparse matrix. */
+  void assembled_operator(State& state) {
+    global_size_t n = state.size();
+    double h = 1.0 / (n-1);
+
+    auto spec = mesh_spec(state);
+    StencilOperator<Mesh> op(spec, laplace_stencil<double, 2>(h), 1.0);
+    auto mat = op.assemble();
+
+    Mesh u(spec);
+    Mesh f(spec);
+    u.fill(1.0);
+
+    state.bytes(2.0 * n * n * sizeof(double)
+                + 5.0 * n * n * (sizeof(double) + sizeof(PetscInt)));
+    state.flops(10.0 * n * n);
+    state.run([&] { mat->apply(f, u); });
+  }
+
+  /** Assembly of the operator into a sparse matrix. */
+  void assemble_operator(State& state) {
+    global_size_t n = state.size();
+    double h = 1.0 / (n-1);
+
+    auto spec = mesh_spec(state);
+    StencilOperator<Mesh> op(spec, laplace_stencil<double, 2>(h), 1.0);
+
+    state.items(5.0 * n * n);
+    state.run([&] { op.assemble(); });
+  }
+
+  Registration petsc_shifted_laplace("stencil/petsc/shifted_laplace",
+                                     sizes,
+                                     shifted_laplace);
+  Registration petsc_stencil_operator("stencil/petsc/stencil_operator",
+                                      sizes,
+                                      stencil_operator);
+  Registration petsc_assembled_operator("stencil/petsc/assembled_operator",
+                                        sizes,
+                                        assembled_operator);
+  Registration petsc_assemble_operator("stencil/petsc/assemble_operator",
+                                       sizes,
+                                       assemble_operator);
+}
+
+#endif
@@ -0,0 +1,247 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include "benchmark.hpp"
+
+#include <allium/config.hpp>
+#include <allium/la/distributed_vector.hpp>
+#include <allium/la/eigen_vector.hpp>
+#include <allium/la/multi_vector.hpp>
+#include <allium/la/petsc_vector.hpp>
+
+using namespace allium;
+using namespace bench;
+
+namespace {
+
+  const std::vector<size_t> sizes = { 1 << 10, 1 << 14, 1 << 18, 1 << 22 };
+
+  // The kernels copy, scale, add and triad correspond to the STREAM
+  // benchmark, such that their bandwidth can be compared to the peak
+  // bandwidth measured by the roofline benchmarks.
+
+  /** y = x */
+  template <typename V>
+  void copy(State& state) {
+    using Number = typename V::Number;
+
+    if (!require_ranks<V>(state))
+      return;
+
+    auto spec = even_spec(state.comm(), state.size());
+    V x(spec);
+    V y(spec);
+    x.fill(1.0);
+
+    state.bytes(2.0 * state.size() * sizeof(Number));
+    state.run([&] { y.assign(x); });
+  }
+
+  /** y = a y */
+  template <typename V>
+  void scale(State& state) {
+    using Number = typename V::Number;
+
+    if (!require_ranks<V>(state))
+      return;
+
+    auto spec = even_spec(state.comm(), state.size());
+    V y(spec);
+    y.fill(1.0);
+
+    state.bytes(2.0 * state.size() * sizeof(Number));
+    state.flops(1.0 * state.size());
+    state.run([&] { y *= 1.0; });
+  }
+
+  /** y = y + x */
+  template <typename V>
+  void add(State& state) {
+    using Number = typename V::Number;
+
+    if (!require_ranks<V>(state))
+      return;
+
+    auto spec = even_spec(state.comm(), state.size());
+    V x(spec);
+    V y(spec);
+    x.fill(0.0);
+    y.fill(1.0);
+
+    state.bytes(3.0 * state.size() * sizeof(Number));
+    state.flops(1.0 * state.size());
+    state.run([&] { y += x; });
+  }
+
+  /** y = y + a x */
+  template <typename V>
+  void triad(State& state) {
+    using Number = typename V::Number;
+
+    if (!require_ranks<V>(state))
+      return;
+
+    auto spec = even_spec(state.comm(), state.size());
+    V x(spec);
+    V y(spec);
+    x.fill(1.0);
+    y.fill(2.0);
+
+    state.bytes(3.0 * state.size() * sizeof(Number));
+    state.flops(2.0 * state.size());
+    state.run([&] { y.add_scaled(1e-3, x); });
+  }
+
+  template <typename V>
+  void dot(State& state) {
+    using Number = typename V::Number;
+
+    if (!require_ranks<V>(state))
+      return;
+
+    auto spec = even_spec(state.comm(), state.size());
+    V x(spec);
+    V y(spec);
+    x.fill(1.0);
+    y.fill(2.0);
+
+    state.bytes(2.0 * state.size() * sizeof(Number));
+    state.flops(2.0 * state.size());
+    state.run([&] { x.dot(y); });
+  }
+
+  template <typename V>
+  void local_slice_access(State& state) {
+    using Number = typename V::Number;
+
+    if (!require_ranks<V>(state))
+      return;
+
+    auto spec = even_spec(state.comm(), state.size());
+    V x(spec);
+    x.fill(1.0);
+
+    state.bytes(2.0 * state.size() * sizeof(Number));
+    state.flops(1.0 * state.size());
+    state.run([&] {
+      auto loc = local_slice(x);
+      for (size_t i = 0; i < loc.size(); ++i) {
+        loc[i] += 1.0;
+      }
+    });
+  }
+
+  // the number of vectors of a block
+  const size_t block_count = 8;
+  const std::vector<size_t> block_sizes = { 1 << 10, 1 << 14, 1 << 18 };
+
+  /** All inner products X^H Y of two blocks of vectors. */
+  template <int StorageOrder>
+  void inner_products(State& state) {
+    using Number = double;
+    using Block = MultiVector<Number, StorageOrder>;
+
+    auto spec = even_spec(state.comm(), state.size());
+    Block x(spec, block_count);
+    Block y(spec, block_count);
+    x.fill(1.0);
+    y.fill(2.0);
+
+    state.bytes(2.0 * block_count * state.size() * sizeof(Number));
+    state.flops(2.0 * block_count * block_count * state.size());
+    state.run([&] { x.inner_products(y); });
+  }
+
+  /** The same inner products, computed by separate dot products. */
+  void separate_inner_products(State& state) {
+    using Number = double;
+    using Vector = DistributedVectorStorage<Number>;
+
+    auto spec = even_spec(state.comm(), state.size());
+    std::vector<Vector> x(block_count, Vector(spec));
+    std::vector<Vector> y(block_count, Vector(spec));
+    for (size_t i = 0; i < block_count; ++i) {
+      x[i].fill(1.0);
+      y[i].fill(2.0);
+    }
+
+    state.bytes(2.0 * block_count * state.size() * sizeof(Number));
+    state.flops(2.0 * block_count * block_count * state.size());
+    state.run([&] {
+      for (size_t i = 0; i < block_count; ++i) {
+        for (size_t j = 0; j < block_count; ++j) {
+          y[j].dot(x[i]);
+        }
+      }
+    });
+  }
+
+  /** Y += X C for a dense block_count x block_count matrix C. */
+  template <int StorageOrder>
+  void add_product(State& state) {
+    using Number = double;
+    using Block = MultiVector<Number, StorageOrder>;
+
+    auto spec = even_spec(state.comm(), state.size());
+    Block x(spec, block_count);
+    Block y(spec, block_count);
+    x.fill(1.0);
+    y.fill(2.0);
+
+    LocalMatrix<Number> c(block_count, block_count);
+    c.native().setConstant(1e-3);
+
+    state.bytes(3.0 * block_count * state.size() * sizeof(Number));
+    state.flops(2.0 * block_count * block_count * state.size());
+    state.run([&] { y.add_product(x, c); });
+  }
+
+  Registration col_major_inner_products("multi_vector/col_major/inner_products",
+                                        block_sizes,
+                                        inner_products<Eigen::ColMajor>);
+  Registration row_major_inner_products("multi_vector/row_major/inner_products",
+                                        block_sizes,
+                                        inner_products<Eigen::RowMajor>);
+  Registration separate_dots("multi_vector/separate/inner_products",
+                             block_sizes,
+                             separate_inner_products);
+  Registration col_major_add_product("multi_vector/col_major/add_product",
+                                     block_sizes,
+                                     add_product<Eigen::ColMajor>);
+  Registration row_major_add_product("multi_vector/row_major/add_product",
+                                     block_sizes,
+                                     add_product<Eigen::RowMajor>);
+
+  #define ALLIUM_BENCH_VECTOR(backend, V) \
+    Registration backend##_copy("vector/" #backend "/copy", \
+                                sizes, copy<V>); \
+    Registration backend##_scale("vector/" #backend "/scale", \
+                                 sizes, scale<V>); \
+    Registration backend##_add("vector/" #backend "/add", \
+                               sizes, add<V>); \
+    Registration backend##_triad("vector/" #backend "/triad", \
+                                 sizes, triad<V>); \
+    Registration backend##_dot("vector/" #backend "/dot", \
+                               sizes, dot<V>); \
+    Registration backend##_local_slice("vector/" #backend "/local_slice", \
+                                       sizes, local_slice_access<V>);
+
+  ALLIUM_BENCH_VECTOR(eigen, EigenVectorStorage<double>)
+  #ifdef ALLIUM_USE_PETSC
+    ALLIUM_BENCH_VECTOR(petsc, PetscVectorStorage<double>)
+  #endif
+  #ifdef ALLIUM_USE_CUDA
+    ALLIUM_BENCH_VECTOR(cuda, CudaVector<double>)
+  #endif
+}
@@ -0,0 +1,49 @@
+#!/usr/bin/env python3
+#  Copyright 2021 Hannah Rittich
+#
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+# Compares two JSON files written by `benchmarks --format=json`.
+
+import json
+import sys
+
+def load(filename):
+    with open(filename) as f:
+        data = json.load(f)
+    results = {}
+    for b in data['benchmarks']:
+        if 'skipped' not in b:
+            results[(b['name'], b['size'])] = b
+    return data['context'], results
+
+if len(sys.argv) != 3:
+    print('Usage: {} BASE.json NEW.json'.format(sys.argv[0]))
+    sys.exit(1)
+
+base_context, base = load(sys.argv[1])
+new_context, new = load(sys.argv[2])
+
+for key in ['host', 'ranks', 'threads', 'build_type', 'compiler']:
+    if base_context.get(key) != new_context.get(key):
+        print('warning: {} differs: {} vs. {}'.format(
+            key, base_context.get(key), new_context.get(key)))
+
+print('{:<40} {:>10} {:>14} {:>14} {:>9}'.format(
+    'benchmark', 'size', 'base [s]', 'new [s]', 'change'))
+for key in sorted(base.keys() & new.keys()):
+    t_base = base[key]['median']
+    t_new = new[key]['median']
+    change = 100.0 * (t_new - t_base) / t_base
+    print('{:<40} {:>10} {:>14.3e} {:>14.3e} {:>+8.1f}%'.format(
+        key[0], key[1], t_base, t_new, change))
@@ -0,0 +1,142 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <allium/la/block_jacobi.hpp>
+#include <allium/la/bsr_sparse_matrix.hpp>
+#include <allium/la/cg.hpp>
+#include <allium/la/gmres.hpp>
+
+#include <complex>
+#include <gtest/gtest.h>
+
+using namespace allium;
+
+using Number = double;
+using Vector = EigenVectorStorage<Number>;
+
+/**
+ The 1D Laplace operator with b components per point, which are coupled by
+ the symmetric positive definite matrix [[2, 1], [1, 2]] (for b = 2).
+ */
+static LocalCooMatrix<Number> coupled_laplace(size_t points, size_t b,
+                                              bool couple_points = true)
+{
+  LocalCooMatrix<Number> coo;
+  for (size_t p = 0; p < points; ++p) {
+    for (size_t i = 0; i < b; ++i) {
+      size_t row = p * b + i;
+      for (size_t j = 0; j < b; ++j) {
+        coo.add(row, p * b + j, i == j ? 4 : 1);
+      }
+      if (couple_points && p > 0) coo.add(row, row - b, -1);
+      if (couple_points && p < points-1) coo.add(row, row + b, -1);
+    }
+  }
+  return coo;
+}
+
+TEST(BlockJacobi, InvertsBlockDiagonal)
+{
+  const size_t b = 3, points = 5, n = b * points;
+  VectorSpec spec(Comm::world(), n, n);
+
+  auto mat = make_block_sparse_matrix<Number>(spec, spec, b);
+  mat->set_entries(coupled_laplace(points, b, false));
+
+  BlockJacobiPreconditioner<Vector> pc(*mat, b);
+
+  Vector x(spec), ax(spec), y(spec);
+  { auto loc = local_slice(x);
+    for (size_t i = 0; i < n; ++i) {
+      loc[i] = i;
+    }
+  }
+  mat->apply(ax, x);
+  pc.apply(y, ax);
+
+  { auto loc_x = local_slice(x);
+    auto loc_y = local_slice(y);
+    for (size_t i = 0; i < n; ++i) {
+      EXPECT_NEAR(loc_y[i], loc_x[i], 1e-12);
+    }
+  }
+}
+
+TEST(BlockJacobi, SingularBlock)
+{
+  VectorSpec spec(Comm::world(), 2, 2);
+  auto mat = make_block_sparse_matrix<Number>(spec, spec, 2);
+
+  LocalCooMatrix<Number> coo;
+  coo.add(0, 0, 1);
+  mat->set_entries(coo);
+
+  EXPECT_THROW(BlockJacobiPreconditioner<Vector>(*mat, 2), std::runtime_error);
+}
+
+TEST(BlockJacobi, PreconditionedCg)
+{
+  const size_t b = 2, points = 50, n = b * points;
+  VectorSpec spec(Comm::world(), n, n);
+
+  auto mat = make_block_sparse_matrix<Number>(spec, spec, b);
+  mat->set_entries(coupled_laplace(points, b));
+
+  Vector rhs(spec), x(spec), x_pc(spec);
+  rhs.fill(1.0);
+
+  CgSolver<Vector> solver(1e-10);
+  solver.setup(mat);
+  solver.solve(x, rhs);
+  int iterations = solver.iteration_count();
+
+  solver.preconditioner(std::make_shared<BlockJacobiPreconditioner<Vector>>(*mat, b));
+  solver.solve(x_pc, rhs);
+
+  EXPECT_LE(solver.iteration_count(), iterations);
+  { auto loc = local_slice(x);
+    auto loc_pc = local_slice(x_pc);
+    for (size_t i = 0; i < n; ++i) {
+      EXPECT_NEAR(loc_pc[i], loc[i], 1e-8);
+    }
+  }
+}
+
+TEST(BlockJacobi, PreconditionedGmres)
+{
+  const size_t b = 4, points = 10, n = b * points;
+  VectorSpec spec(Comm::world(), n, n);
+
+  // for a block diagonal matrix, the preconditioner is the exact inverse
+  auto mat = make_block_sparse_matrix<Number>(spec, spec, b);
+  mat->set_entries(coupled_laplace(points, b, false));
+
+  Vector rhs(spec), x(spec), ax(spec);
+  rhs.fill(1.0);
+
+  GmresSolver<Vector> solver;
+  solver.tolerance(1e-10);
+  solver.setup(mat);
+  solver.preconditioner(std::make_shared<BlockJacobiPreconditioner<Vector>>(*mat, b));
+  solver.solve(x, rhs);
+
+  EXPECT_EQ(solver.iteration_count(), 1);
+
+  mat->apply(ax, x);
+  { auto loc = local_slice(ax);
+    for (size_t i = 0; i < n; ++i) {
+      EXPECT_NEAR(loc[i], 1.0, 1e-10);
+    }
+  }
+}
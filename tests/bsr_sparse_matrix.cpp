@@ -0,0 +1,112 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <allium/la/bsr_sparse_matrix.hpp>
+#include <allium/la/eigen_sparse_matrix.hpp>
+
+#include <complex>
+#include <gtest/gtest.h>
+
+using namespace allium;
+
+/** A block tridiagonal matrix with distinct entries. */
+template <typename N>
+static LocalCooMatrix<N> block_tridiagonal(size_t blocks, size_t b)
+{
+  LocalCooMatrix<N> coo;
+  size_t n = blocks * b;
+  for (size_t row = 0; row < n; ++row) {
+    size_t block_row = row / b;
+    size_t col_begin = block_row > 0 ? (block_row - 1) * b : 0;
+    size_t col_end = std::min(n, (block_row + 2) * b);
+    for (size_t col = col_begin; col < col_end; ++col) {
+      coo.add(row, col, N(1 + (row * 7 + col * 3) % 11));
+    }
+  }
+  return coo;
+}
+
+TEST(BsrSparseMatrix, MatVecMult)
+{
+  using Number = double;
+  using Vector = EigenVectorStorage<Number>;
+
+  for (int b = 1; b <= 8; ++b) {
+    size_t n = 10 * b;
+    VectorSpec spec(Comm::world(), n, n);
+
+    auto coo = block_tridiagonal<Number>(10, b);
+    auto mat = make_block_sparse_matrix<Number>(spec, spec, b);
+    mat->set_entries(coo);
+
+    EigenSparseMatrixStorage<Number> reference(spec, spec);
+    reference.set_entries(coo);
+
+    Vector v(spec);
+    { auto loc = local_slice(v);
+      for (size_t i = 0; i < n; ++i) {
+        loc[i] = i % 5;
+      }
+    }
+
+    Vector w(spec), w_ref(spec);
+    mat->apply(w, v);
+    reference.apply(w_ref, v);
+
+    { auto loc = local_slice(w);
+      auto loc_ref = local_slice(w_ref);
+      for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(loc[i], loc_ref[i]) << "block size " << b;
+      }
+    }
+  }
+}
+
+TEST(BsrSparseMatrix, SumDuplicatesAndFillBlocks)
+{
+  using Number = std::complex<double>;
+
+  VectorSpec spec(Comm::world(), 4, 4);
+  BsrSparseMatrixStorage<Number, 2> mat(spec, spec);
+
+  LocalCooMatrix<Number> coo;
+  coo.add(3, 0, 1);
+  coo.add(0, 0, 2);
+  coo.add(3, 0, 3);
+  mat.set_entries(coo);
+
+  ASSERT_EQ(mat.block_rows(), 2);
+  EXPECT_EQ(mat.block_row_ptr()[1], 1);
+  EXPECT_EQ(mat.block_row_ptr()[2], 2);
+  EXPECT_EQ(mat.block_col_ind()[1], 0);
+
+  LocalCooMatrix<Number> expected;
+  expected.add(0, 0, 2);
+  expected.add(0, 1, 0);
+  expected.add(1, 0, 0);
+  expected.add(1, 1, 0);
+  expected.add(2, 0, 0);
+  expected.add(2, 1, 0);
+  expected.add(3, 0, 4);
+  expected.add(3, 1, 0);
+  auto entries = mat.get_entries();
+  EXPECT_EQ(entries.entries(), expected.entries());
+}
+
+TEST(BsrSparseMatrix, InvalidSize)
+{
+  VectorSpec spec(Comm::world(), 5, 5);
+  using Matrix = BsrSparseMatrixStorage<double, 2>;
+  EXPECT_THROW(Matrix(spec, spec), std::logic_error);
+}
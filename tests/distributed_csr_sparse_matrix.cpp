@@ -0,0 +1,295 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <allium/la/distributed_csr_sparse_matrix.hpp>
+#include <allium/la/multi_vector.hpp>
+#include <allium/la/cg.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace allium;
+
+namespace {
+  /** Distributes `size` entries evenly over the ranks of the world. */
+  VectorSpec even_spec(global_size_t size)
+  {
+    auto comm = Comm::world();
+    size_t local_size = size / comm.size();
+    if (static_cast<global_size_t>(comm.rank()) < size % comm.size()) {
+      ++local_size;
+    }
+    return VectorSpec(comm, local_size, size);
+  }
+
+  /** The local rows of the tridiagonal matrix with stencil (-1, 2, -1). */
+  LocalCooMatrix<double> tridiagonal(VectorSpec spec)
+  {
+    global_size_t n = spec.global_size();
+
+    LocalCooMatrix<double> lmat;
+    for (global_size_t i = spec.local_start(); i < spec.local_end(); ++i) {
+      if (i > 0) lmat.add(i, i-1, -1);
+      lmat.add(i, i, 2);
+      if (i < n-1) lmat.add(i, i+1, -1);
+    }
+    return lmat;
+  }
+}
+
+TEST(DistributedVector, Reductions)
+{
+  const global_size_t n = 100;
+  auto spec = even_spec(n);
+
+  DistributedVectorStorage<double> v(spec);
+  { auto loc = local_slice(v);
+    for (size_t i = 0; i < loc.size(); ++i) {
+      loc[i] = spec.local_start() + i;
+    }
+  }
+
+  DistributedVectorStorage<double> w(spec);
+  w.fill(1.0);
+
+  EXPECT_EQ(v.dot(w), n * (n-1) / 2);
+  EXPECT_DOUBLE_EQ(w.l2_norm(), std::sqrt(double(n)));
+}
+
+TEST(DistributedCsrSparseMatrix, GhostColumns)
+{
+  const global_size_t n = 100;
+  auto spec = even_spec(n);
+
+  DistributedCsrSparseMatrixStorage<double> mat(spec, spec);
+  mat.set_entries(tridiagonal(spec));
+
+  std::vector<global_size_t> expected;
+  if (spec.local_start() > 0)
+    expected.push_back(spec.local_start() - 1);
+  if (spec.local_end() < n)
+    expected.push_back(spec.local_end());
+
+  EXPECT_EQ(mat.ghost_columns(), expected);
+  EXPECT_EQ(mat.off_diagonal_block().nnz(), expected.size());
+  EXPECT_EQ(mat.diagonal_block().nnz() + mat.off_diagonal_block().nnz(),
+            tridiagonal(spec).entry_count());
+}
+
+TEST(DistributedCsrSparseMatrix, Tridiagonal)
+{
+  const global_size_t n = 100;
+  auto spec = even_spec(n);
+
+  DistributedCsrSparseMatrixStorage<double> mat(spec, spec);
+  mat.set_entries(tridiagonal(spec));
+
+  DistributedVectorStorage<double> v(spec);
+  { auto loc = local_slice(v);
+    for (size_t i = 0; i < loc.size(); ++i) {
+      global_size_t k = spec.local_start() + i;
+      loc[i] = k * k;
+    }
+  }
+
+  DistributedVectorStorage<double> w(spec);
+  mat.apply(w, v);
+
+  { auto loc = local_slice(w);
+    for (size_t i = 0; i < loc.size(); ++i) {
+      global_size_t k = spec.local_start() + i;
+      if (k == 0) {
+        EXPECT_EQ(loc[i], -1.0);
+      } else if (k == n-1) {
+        EXPECT_EQ(loc[i], 2.0 * (n-1) * (n-1) - 1.0 * (n-2) * (n-2));
+      } else {
+        EXPECT_EQ(loc[i], -2.0);
+      }
+    }
+  }
+}
+
+TEST(DistributedCsrSparseMatrix, DistantColumns)
+{
+  // row i sums the entries i and (i + n/2) % n, which are owned by distant
+  // ranks, and the columns are distributed differently than the rows
+  const global_size_t n = 64;
+  auto row_spec = even_spec(n);
+  auto col_spec = even_spec(n);
+  if (col_spec.comm().size() > 1) {
+    size_t local_size = col_spec.comm().rank() == 0 ? n : 0;
+    col_spec = VectorSpec(col_spec.comm(), local_size, n);
+  }
+
+  LocalCooMatrix<double> lmat;
+  for (global_size_t i = row_spec.local_start(); i < row_spec.local_end(); ++i) {
+    lmat.add(i, i, 1.0);
+    lmat.add(i, (i + n/2) % n, 1.0);
+  }
+
+  DistributedCsrSparseMatrixStorage<double> mat(row_spec, col_spec);
+  mat.set_entries(lmat);
+
+  DistributedVectorStorage<double> v(col_spec);
+  { auto loc = local_slice(v);
+    for (size_t i = 0; i < loc.size(); ++i) {
+      loc[i] = col_spec.local_start() + i;
+    }
+  }
+
+  DistributedVectorStorage<double> w(row_spec);
+  mat.apply(w, v);
+
+  { auto loc = local_slice(w);
+    for (size_t i = 0; i < loc.size(); ++i) {
+      global_size_t k = row_spec.local_start() + i;
+      EXPECT_EQ(loc[i], double(k + (k + n/2) % n));
+    }
+  }
+}
+
+TEST(DistributedCsrSparseMatrix, ApplyBlock)
+{
+  // the same matrix as above, applied to blocks of vectors
+  const global_size_t n = 64;
+  auto row_spec = even_spec(n);
+  auto col_spec = even_spec(n);
+  if (col_spec.comm().size() > 1) {
+    size_t local_size = col_spec.comm().rank() == 0 ? n : 0;
+    col_spec = VectorSpec(col_spec.comm(), local_size, n);
+  }
+
+  LocalCooMatrix<double> lmat;
+  for (global_size_t i = row_spec.local_start(); i < row_spec.local_end(); ++i) {
+    lmat.add(i, i, 1.0);
+    lmat.add(i, (i + n/2) % n, 1.0);
+  }
+
+  DistributedCsrSparseMatrixStorage<double> mat(row_spec, col_spec);
+  mat.set_entries(lmat);
+
+  for (size_t k : { 4, 3 }) {
+    MultiVector<double, Eigen::RowMajor> x(col_spec, k), y(row_spec, k);
+    for (size_t i = 0; i < col_spec.local_size(); ++i) {
+      for (size_t j = 0; j < k; ++j) {
+        x.native()(i, j) = double((col_spec.local_start() + i) * (j + 1));
+      }
+    }
+
+    mat.apply_block(y, x);
+
+    for (size_t i = 0; i < row_spec.local_size(); ++i) {
+      global_size_t g = row_spec.local_start() + i;
+      for (size_t j = 0; j < k; ++j) {
+        EXPECT_EQ(y.native()(i, j), double((g + (g + n/2) % n) * (j + 1)));
+      }
+    }
+  }
+}
+
+TEST(DistributedCsrSparseMatrix, SetCsr)
+{
+  // the same matrix as above, given by its local rows
+  const global_size_t n = 64;
+  auto row_spec = even_spec(n);
+  auto col_spec = even_spec(n);
+  if (col_spec.comm().size() > 1) {
+    size_t local_size = col_spec.comm().rank() == 0 ? n : 0;
+    col_spec = VectorSpec(col_spec.comm(), local_size, n);
+  }
+
+  LocalCooMatrix<double> lmat;
+  for (global_size_t i = row_spec.local_start(); i < row_spec.local_end(); ++i) {
+    lmat.add(i, i, i + 1.0);
+    lmat.add(i, (i + n/2) % n, 1.0);
+  }
+
+  DistributedCsrSparseMatrixStorage<double> expected(row_spec, col_spec);
+  expected.set_entries(lmat);
+
+  DistributedCsrSparseMatrixStorage<double> mat(row_spec, col_spec);
+  mat.set_csr(LocalCsrMatrix<double>(row_spec.local_size(), n, lmat,
+                                     row_spec.local_start()));
+  auto entries = mat.get_entries();
+  auto expected_entries = expected.get_entries();
+  EXPECT_EQ(entries.entries(), expected_entries.entries());
+  EXPECT_EQ(mat.ghost_columns(), expected.ghost_columns());
+
+  DistributedVectorStorage<double> v(col_spec);
+  v.fill(1.0);
+  DistributedVectorStorage<double> w(row_spec), w_expected(row_spec);
+  mat.apply(w, v);
+  expected.apply(w_expected, v);
+  w.add_scaled(-1.0, w_expected);
+  EXPECT_EQ(w.l2_norm(), 0.0);
+}
+
+TEST(DistributedCsrSparseMatrix, ElementAssembly)
+{
+  // Every rank assembles the 1D elements [i, i+1] for its rows i, the last
+  // element contributes to the first row of the next rank. The result is
+  // the tridiagonal matrix, except for the corners.
+  const global_size_t n = 50;
+  auto spec = even_spec(n);
+
+  LocalCooMatrix<double> lmat;
+  for (global_size_t i = spec.local_start(); i < spec.local_end(); ++i) {
+    if (i == n-1)
+      continue;
+    lmat.add(i,   i,    1);
+    lmat.add(i,   i+1, -1);
+    lmat.add(i+1, i,   -1);
+    lmat.add(i+1, i+1,  1);
+  }
+
+  DistributedCsrSparseMatrixStorage<double> mat(spec, spec);
+  mat.set_entries(lmat);
+
+  auto expected = tridiagonal(spec);
+  for (size_t i = 0; i < expected.entry_count(); ++i) {
+    global_size_t row = expected.row_ind()[i];
+    if ((row == 0 || row == n-1) && expected.col_ind()[i] == row)
+      expected.values()[i] = 1;
+  }
+
+  // the order of the entries depends on the ghost columns
+  auto entries = LocalCsrMatrix<double>(spec.local_size(), n,
+                                        mat.get_entries(),
+                                        spec.local_start())
+                   .to_coo(spec.local_start());
+  EXPECT_EQ(entries.entries(), expected.entries());
+}
+
+TEST(DistributedCsrSparseMatrix, Cg)
+{
+  using Vector = DistributedVectorStorage<double>;
+
+  const global_size_t n = 100;
+  auto spec = even_spec(n);
+
+  auto mat = std::make_shared<DistributedCsrSparseMatrixStorage<double>>(spec, spec);
+  mat->set_entries(tridiagonal(spec));
+
+  Vector rhs(spec);
+  rhs.fill(1.0);
+
+  Vector solution(spec);
+  CgSolver<Vector> solver(1e-10);
+  solver.setup(mat);
+  solver.solve(solution, rhs);
+
+  Vector residual(spec);
+  mat->apply(residual, solution);
+  residual.add_scaled(-1.0, rhs);
+  EXPECT_LT(residual.l2_norm(), 1e-8);
+}
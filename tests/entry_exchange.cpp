@@ -0,0 +1,73 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <allium/la/entry_exchange.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace allium;
+
+TEST(ExchangeEntries, SumsContributions)
+{
+  auto comm = Comm::world();
+  const int ranks = comm.size();
+  const global_size_t n = ranks;
+
+  // one row per rank, every rank contributes to every row
+  VectorSpec spec(comm, 1, n);
+
+  LocalCooMatrix<double> lmat;
+  for (global_size_t i = 0; i < n; ++i) {
+    lmat.add(i, i, 1.0);
+    lmat.add(i, 0, comm.rank());
+  }
+
+  auto owned = exchange_entries(spec, n, lmat);
+
+  LocalCooMatrix<double> expected;
+  global_size_t row = comm.rank();
+  double rank_sum = ranks * (ranks - 1) / 2.0;
+  if (row == 0) {
+    expected.add(row, 0, ranks + rank_sum);
+  } else {
+    expected.add(row, 0, rank_sum);
+    expected.add(row, row, ranks);
+  }
+  EXPECT_EQ(owned.entries(), expected.entries());
+}
+
+TEST(ExchangeEntries, OutOfRange)
+{
+  VectorSpec spec(Comm::world(), 1, Comm::world().size());
+
+  LocalCooMatrix<double> lmat;
+  lmat.add(spec.global_size(), 0, 1.0);
+
+  EXPECT_THROW(exchange_entries(spec, 1, lmat), std::out_of_range);
+}
+
+TEST(ExchangeEntries, OutOfRangeOnOneRank)
+{
+  // the other ranks must not wait for the rank with the invalid entry
+  auto comm = Comm::world();
+  VectorSpec spec(comm, 1, comm.size());
+
+  LocalCooMatrix<double> lmat;
+  lmat.add(comm.rank(), 0, 1.0);
+  if (comm.rank() == 0) {
+    lmat.add(spec.global_size(), 0, 1.0);
+  }
+
+  EXPECT_THROW(exchange_entries(spec, 1, lmat), std::out_of_range);
+}
@@ -0,0 +1,252 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <allium/la/incomplete_factorization.hpp>
+#include <allium/la/cg.hpp>
+#include <allium/la/csr_sparse_matrix.hpp>
+#include <allium/la/eigen_sparse_matrix.hpp>
+#include <allium/la/gmres.hpp>
+#include <allium/util/parallel.hpp>
+
+#include <complex>
+#include <gtest/gtest.h>
+
+using namespace allium;
+
+namespace {
+  /** A tridiagonal matrix, whose factors have no fill-in. */
+  template <typename N>
+  LocalCooMatrix<N> tridiagonal(size_t n, N lower, N diag, N upper)
+  {
+    LocalCooMatrix<N> coo;
+    for (size_t i = 0; i < n; ++i) {
+      if (i > 0) coo.add(i, i-1, lower);
+      coo.add(i, i, diag);
+      if (i < n-1) coo.add(i, i+1, upper);
+    }
+    return coo;
+  }
+
+  LocalCooMatrix<double> laplace_2d(size_t n)
+  {
+    LocalCooMatrix<double> coo;
+    for (size_t row = 0; row < n*n; ++row) {
+      size_t i = row % n;
+      size_t j = row / n;
+      if (j > 0)   coo.add(row, row - n, -1);
+      if (i > 0)   coo.add(row, row - 1, -1);
+      coo.add(row, row, 4);
+      if (i < n-1) coo.add(row, row + 1, -1);
+      if (j < n-1) coo.add(row, row + n, -1);
+    }
+    return coo;
+  }
+
+  /** Checks that the preconditioner is the exact inverse. */
+  template <typename N, typename P>
+  void expect_inverse(CsrSparseMatrixStorage<N>& mat, P& pc)
+  {
+    using Vector = EigenVectorStorage<N>;
+    auto spec = mat.row_spec();
+
+    Vector x(spec), ax(spec), y(spec);
+    { auto loc = local_slice(x);
+      for (size_t i = 0; i < loc.size(); ++i) {
+        loc[i] = N(i % 7) - N(3);
+      }
+    }
+    mat.apply(ax, x);
+    pc.apply(y, ax);
+
+    auto loc_x = local_slice(x);
+    auto loc_y = local_slice(y);
+    for (size_t i = 0; i < loc_x.size(); ++i) {
+      EXPECT_NEAR(std::abs(loc_y[i] - loc_x[i]), 0, 1e-12);
+    }
+  }
+}
+
+TEST(IluPreconditioner, ExactForTridiagonal)
+{
+  const size_t n = 50;
+  VectorSpec spec(Comm::world(), n, n);
+
+  CsrSparseMatrixStorage<double> mat(spec, spec);
+  mat.set_entries(tridiagonal<double>(n, -1, 3, -1.5));
+
+  IluPreconditioner<EigenVectorStorage<double>> pc(mat);
+  expect_inverse(mat, pc);
+
+  // every row depends on the previous one
+  EXPECT_EQ(pc.lower_level_count(), n);
+  EXPECT_EQ(pc.upper_level_count(), n);
+}
+
+TEST(IluPreconditioner, Levels)
+{
+  const size_t n = 20;
+  VectorSpec spec(Comm::world(), n*n, n*n);
+
+  CsrSparseMatrixStorage<double> mat(spec, spec);
+  mat.set_entries(laplace_2d(n));
+
+  // the rows of each anti-diagonal of the grid are independent
+  IluPreconditioner<EigenVectorStorage<double>> pc(mat);
+  EXPECT_EQ(pc.lower_level_count(), 2*n - 1);
+  EXPECT_EQ(pc.upper_level_count(), 2*n - 1);
+}
+
+TEST(IluPreconditioner, Errors)
+{
+  VectorSpec spec(Comm::world(), 3, 3);
+  CsrSparseMatrixStorage<double> mat(spec, spec);
+
+  LocalCooMatrix<double> coo;
+  coo.add(0, 0, 1.0);
+  coo.add(1, 2, 1.0);
+  coo.add(2, 2, 1.0);
+  mat.set_entries(coo);
+  EXPECT_THROW(IluPreconditioner<EigenVectorStorage<double>> pc(mat),
+               std::runtime_error);
+
+  mat.set_entries(tridiagonal<double>(3, 1, 1, 1));
+  EXPECT_THROW(IluPreconditioner<EigenVectorStorage<double>> pc(mat),
+               std::runtime_error);
+}
+
+TEST(IluPreconditioner, PreconditionedGmres)
+{
+  const size_t n = 20;
+  VectorSpec spec(Comm::world(), n*n, n*n);
+  using Vector = EigenVectorStorage<double>;
+
+  // a convection-diffusion operator
+  auto coo = laplace_2d(n);
+  for (size_t row = 1; row < n*n; ++row) {
+    coo.add(row, row - 1, -0.5);
+    coo.add(row, row, 0.5);
+  }
+  auto mat = std::make_shared<CsrSparseMatrixStorage<double>>(spec, spec);
+  mat->set_entries(coo);
+
+  Vector rhs(spec), x(spec), x_pc(spec);
+  rhs.fill(1.0);
+
+  GmresSolver<Vector> solver;
+  solver.tolerance(1e-10);
+  solver.setup(mat);
+  solver.solve(x, rhs);
+  int iterations = solver.iteration_count();
+
+  solver.preconditioner(std::make_shared<IluPreconditioner<Vector>>(*mat));
+  solver.solve(x_pc, rhs);
+
+  EXPECT_LT(solver.iteration_count(), iterations / 2);
+  { auto loc = local_slice(x);
+    auto loc_pc = local_slice(x_pc);
+    for (size_t i = 0; i < n*n; ++i) {
+      EXPECT_NEAR(loc_pc[i], loc[i], 1e-8);
+    }
+  }
+}
+
+TEST(IcPreconditioner, ExactForTridiagonal)
+{
+  const size_t n = 50;
+  VectorSpec spec(Comm::world(), n, n);
+
+  CsrSparseMatrixStorage<double> mat(spec, spec);
+  mat.set_entries(tridiagonal<double>(n, -1, 3, -1));
+
+  IcPreconditioner<EigenVectorStorage<double>> pc(mat);
+  expect_inverse(mat, pc);
+}
+
+TEST(IcPreconditioner, ExactForHermitianTridiagonal)
+{
+  using Number = std::complex<double>;
+  const size_t n = 30;
+  VectorSpec spec(Comm::world(), n, n);
+
+  CsrSparseMatrixStorage<Number> mat(spec, spec);
+  mat.set_entries(tridiagonal<Number>(n, {-1, 0.5}, 3, {-1, -0.5}));
+
+  IcPreconditioner<EigenVectorStorage<Number>> pc(mat);
+  expect_inverse(mat, pc);
+}
+
+TEST(IcPreconditioner, NotPositiveDefinite)
+{
+  VectorSpec spec(Comm::world(), 3, 3);
+  CsrSparseMatrixStorage<double> mat(spec, spec);
+  mat.set_entries(tridiagonal<double>(3, 2, 1, 2));
+
+  EXPECT_THROW(IcPreconditioner<EigenVectorStorage<double>> pc(mat),
+               std::runtime_error);
+}
+
+TEST(IcPreconditioner, PreconditionedCg)
+{
+  const size_t n = 30;
+  VectorSpec spec(Comm::world(), n*n, n*n);
+  using Vector = EigenVectorStorage<double>;
+
+  auto mat = std::make_shared<EigenSparseMatrixStorage<double>>(spec, spec);
+  mat->set_entries(laplace_2d(n));
+
+  Vector rhs(spec), x(spec), x_pc(spec);
+  rhs.fill(1.0);
+
+  CgSolver<Vector> solver(1e-10);
+  solver.setup(mat);
+  solver.solve(x, rhs);
+  int iterations = solver.iteration_count();
+
+  solver.preconditioner(std::make_shared<IcPreconditioner<Vector>>(*mat));
+  solver.solve(x_pc, rhs);
+
+  EXPECT_LT(solver.iteration_count(), iterations);
+  { auto loc = local_slice(x);
+    auto loc_pc = local_slice(x_pc);
+    for (size_t i = 0; i < n*n; ++i) {
+      EXPECT_NEAR(loc_pc[i], loc[i], 1e-8);
+    }
+  }
+}
+
+TEST(IcPreconditioner, ThreadCountIndependent)
+{
+  const size_t n = 40;
+  VectorSpec spec(Comm::world(), n*n, n*n);
+  using Vector = EigenVectorStorage<double>;
+
+  CsrSparseMatrixStorage<double> mat(spec, spec);
+  mat.set_entries(laplace_2d(n));
+
+  Vector x(spec), y1(spec), y4(spec);
+  x.fill(1.0);
+
+  int threads = max_threads();
+  set_max_threads(1);
+  IcPreconditioner<Vector>(mat).apply(y1, x);
+  set_max_threads(4);
+  IcPreconditioner<Vector>(mat).apply(y4, x);
+  set_max_threads(threads);
+
+  auto loc1 = local_slice(y1);
+  auto loc4 = local_slice(y4);
+  for (size_t i = 0; i < n*n; ++i) {
+    EXPECT_EQ(loc1[i], loc4[i]);
+  }
+}
@@ -0,0 +1,178 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <allium/la/local_csr_matrix.hpp>
+#include <allium/util/parallel.hpp>
+
+#include <complex>
+#include <cstdint>
+#include <map>
+#include <gtest/gtest.h>
+
+using TestTypes = ::testing::Types<float,
+                                   double,
+                                   std::complex<float>,
+                                   std::complex<double>>;
+template <typename T>
+struct LocalCsrMatrixTest : public testing::Test {};
+TYPED_TEST_SUITE(LocalCsrMatrixTest, TestTypes);
+
+using namespace allium;
+
+TYPED_TEST(LocalCsrMatrixTest, Empty)
+{
+  using Number = TypeParam;
+  LocalCsrMatrix<Number> m(3, 2, LocalCooMatrix<Number>());
+
+  EXPECT_EQ(m.rows(), 3);
+  EXPECT_EQ(m.cols(), 2);
+  EXPECT_EQ(m.nnz(), 0);
+  EXPECT_EQ(m.to_coo().entry_count(), 0);
+}
+
+TYPED_TEST(LocalCsrMatrixTest, SortAndSumDuplicates)
+{
+  using Number = TypeParam;
+
+  LocalCooMatrix<Number> coo;
+  coo.add(2, 1, 1);
+  coo.add(0, 2, 2);
+  coo.add(2, 0, 3);
+  coo.add(0, 0, 4);
+  coo.add(2, 1, 5);
+
+  LocalCsrMatrix<Number> m(3, 3, coo);
+
+  ASSERT_EQ(m.nnz(), 4);
+  EXPECT_EQ(m.row_ptr()[0], 0);
+  EXPECT_EQ(m.row_ptr()[1], 2);
+  EXPECT_EQ(m.row_ptr()[2], 2);
+  EXPECT_EQ(m.row_ptr()[3], 4);
+
+  EXPECT_EQ(m.col_ind()[0], 0);
+  EXPECT_EQ(m.col_ind()[1], 2);
+  EXPECT_EQ(m.col_ind()[2], 0);
+  EXPECT_EQ(m.col_ind()[3], 1);
+
+  EXPECT_EQ(m.values()[0], Number(4));
+  EXPECT_EQ(m.values()[1], Number(2));
+  EXPECT_EQ(m.values()[2], Number(3));
+  EXPECT_EQ(m.values()[3], Number(6));
+}
+
+TYPED_TEST(LocalCsrMatrixTest, RowOffset)
+{
+  using Number = TypeParam;
+
+  LocalCooMatrix<Number> coo;
+  coo.add(5, 1, 1);
+  coo.add(6, 0, 2);
+
+  LocalCsrMatrix<Number> m(2, 2, coo, 5);
+  auto converted = m.to_coo(5);
+  EXPECT_EQ(converted.entries(), coo.entries());
+
+  LocalCooMatrix<Number> outside;
+  outside.add(4, 0, 1);
+  EXPECT_THROW(LocalCsrMatrix<Number>(2, 2, outside, 5), std::out_of_range);
+}
+
+TYPED_TEST(LocalCsrMatrixTest, Aligned)
+{
+  using Number = TypeParam;
+
+  LocalCooMatrix<Number> coo;
+  coo.add(0, 0, 1);
+
+  LocalCsrMatrix<Number> m(1, 1, coo);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(m.values().data()) % 64, 0);
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(m.col_ind().data()) % 64, 0);
+}
+
+TYPED_TEST(LocalCsrMatrixTest, ParallelAssembly)
+{
+  using Number = TypeParam;
+
+  // enough entries to split the conversion into several parts, with long
+  // rows and many duplicates, and fewer rows than parts
+  for (size_t rows : { 500, 1001, 3 }) {
+    const size_t cols = 300;
+
+    LocalCooMatrix<Number> coo;
+    std::map<std::pair<size_t, size_t>, Number> expected;
+    for (size_t i = 0; i < 100000; ++i) {
+      size_t row = (i * 7919) % rows;
+      size_t col = (i / 3) % cols;
+      Number value = Number(i % 5);
+      coo.add(row, col, value);
+      expected[std::make_pair(row, col)] += value;
+    }
+
+    int threads = max_threads();
+    set_max_threads(4);
+    LocalCsrMatrix<Number> m(rows, cols, coo);
+    set_max_threads(threads);
+
+    // the map is ordered by row and column, like the CSR matrix
+    auto result = m.to_coo();
+    ASSERT_EQ(result.entry_count(), expected.size());
+
+    size_t i_entry = 0;
+    for (auto& e : expected) {
+      auto entry = result.entries()[i_entry];
+      EXPECT_EQ(entry.row(), e.first.first);
+      EXPECT_EQ(entry.col(), e.first.second);
+      EXPECT_EQ(entry.value(), e.second);
+      ++i_entry;
+    }
+  }
+}
+
+TYPED_TEST(LocalCsrMatrixTest, BlockProduct)
+{
+  using Number = TypeParam;
+
+  // row i has the entries 1, ..., i % 5 in the columns i, ..., i + i % 5 - 1
+  const size_t rows = 40;
+  const size_t cols = 45;
+  LocalCooMatrix<Number> coo;
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t j = 0; j < i % 5; ++j) {
+      coo.add(i, i + j, Number(j + 1));
+    }
+  }
+  LocalCsrMatrix<Number> m(rows, cols, coo);
+  auto partition = partition_rows(m.row_ptr().data(), rows, 3);
+
+  // fixed and variable widths
+  for (size_t width : { 1, 2, 3, 4, 8, 16 }) {
+    std::vector<Number> x(cols * width);
+    for (size_t i = 0; i < x.size(); ++i) {
+      x[i] = Number(i % 7);
+    }
+    std::vector<Number> y(rows * width, Number(1));
+
+    csr_block_product(m, partition, width, x.data(), y.data(), true);
+
+    for (size_t i = 0; i < rows; ++i) {
+      for (size_t v = 0; v < width; ++v) {
+        Number expected = 1;
+        for (size_t j = 0; j < i % 5; ++j) {
+          expected += Number(j + 1) * x[(i + j) * width + v];
+        }
+        EXPECT_EQ(y[i * width + v], expected);
+      }
+    }
+  }
+}
@@ -0,0 +1,260 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <allium/la/matrix_io.hpp>
+#include <allium/la/csr_sparse_matrix.hpp>
+
+#include <cstdio>
+#include <fstream>
+#include <gtest/gtest.h>
+
+using namespace allium;
+
+namespace {
+  /** A file name in the working directory, which is removed afterwards. */
+  class TemporaryFile {
+    public:
+      explicit TemporaryFile(std::string name) : m_name(name) {}
+      ~TemporaryFile() { std::remove(m_name.c_str()); }
+
+      const std::string& name() const { return m_name; }
+
+      void write(const std::string& content) {
+        std::ofstream os(m_name);
+        os << content;
+      }
+
+    private:
+      std::string m_name;
+  };
+
+  template <typename N>
+  LocalCooMatrix<N> example_matrix(global_size_t rows, global_size_t cols)
+  {
+    LocalCooMatrix<N> mat;
+    for (global_size_t i = 0; i < rows; ++i) {
+      for (global_size_t j = 0; j < cols; ++j) {
+        if ((i + 2*j) % 3 == 0)
+          mat.add(i, j, N(1.0 / (i + j + 1)));
+      }
+    }
+    return mat;
+  }
+}
+
+template <typename T>
+struct MatrixIoTest : public testing::Test {};
+using TestTypes = ::testing::Types<float,
+                                   double,
+                                   std::complex<float>,
+                                   std::complex<double>>;
+TYPED_TEST_SUITE(MatrixIoTest, TestTypes);
+
+TYPED_TEST(MatrixIoTest, MatrixMarketRoundTrip)
+{
+  using Number = TypeParam;
+  TemporaryFile file("matrix_io_round_trip.mtx");
+
+  auto mat = example_matrix<Number>(7, 5);
+  write_matrix_market(file.name(), mat, 7, 5);
+
+  auto header = read_matrix_market_header(file.name());
+  EXPECT_EQ(header.rows, 7);
+  EXPECT_EQ(header.cols, 5);
+  EXPECT_EQ(header.entry_count, mat.entry_count());
+  EXPECT_EQ(header.symmetry, MatrixMarketSymmetry::GENERAL);
+
+  auto result = read_matrix_market<Number>(file.name());
+  EXPECT_EQ(result.entries(), mat.entries());
+}
+
+TYPED_TEST(MatrixIoTest, BinaryCsrRoundTrip)
+{
+  using Number = TypeParam;
+  TemporaryFile file("matrix_io_round_trip.csr");
+
+  LocalCsrMatrix<Number> mat(7, 5, example_matrix<Number>(7, 5));
+  write_binary_csr(file.name(), mat);
+
+  auto result = read_binary_csr<Number>(file.name());
+  EXPECT_EQ(result.rows(), 7);
+  EXPECT_EQ(result.cols(), 5);
+  EXPECT_EQ(result.row_ptr(), mat.row_ptr());
+  EXPECT_EQ(result.col_ind(), mat.col_ind());
+  EXPECT_EQ(result.values(), mat.values());
+
+  // a block of rows
+  auto block = read_binary_csr<Number>(file.name(), 2, 5);
+  auto expected = mat.to_coo();
+  LocalCooMatrix<Number> expected_block;
+  for (auto e : expected.entries()) {
+    if (e.row() >= 2 && e.row() < 5)
+      expected_block.add(e.row(), e.col(), e.value());
+  }
+  auto block_coo = block.to_coo(2);
+  EXPECT_EQ(block_coo.entries(), expected_block.entries());
+}
+
+TEST(BinaryCsr, Corrupted)
+{
+  TemporaryFile file("matrix_io_corrupted.csr");
+
+  // every row holds the columns 0 and 2
+  LocalCooMatrix<double> coo;
+  for (global_size_t i = 0; i < 3; ++i) {
+    coo.add(i, 0, 1.0);
+    coo.add(i, 2, 1.0);
+  }
+  LocalCsrMatrix<double> mat(3, 3, coo);
+
+  // overwrites the 64 bit integer at the given position of the arrays
+  auto corrupt = [&](size_t index, uint64_t value) {
+    write_binary_csr(file.name(), mat);
+    std::fstream fs(file.name(),
+                    std::ios::in | std::ios::out | std::ios::binary);
+    fs.seekp(sizeof(detail::BinaryCsrHeader) + index * sizeof(uint64_t));
+    fs.write(reinterpret_cast<const char*>(&value), sizeof(value));
+  };
+
+  // the row pointers are at 0, ..., 3, the column indices at 4, ..., 9
+  corrupt(1, 3);
+  EXPECT_THROW(read_binary_csr<double>(file.name()), std::runtime_error);
+  corrupt(5, 3);
+  EXPECT_THROW(read_binary_csr<double>(file.name()), std::runtime_error);
+  corrupt(5, 0);
+  EXPECT_THROW(read_binary_csr<double>(file.name()), std::runtime_error);
+
+  // rows outside of the read range are not checked
+  corrupt(9, 0);
+  EXPECT_NO_THROW(read_binary_csr<double>(file.name(), 0, 2));
+  EXPECT_THROW(read_binary_csr<double>(file.name(), 2, 3), std::runtime_error);
+}
+
+TEST(MatrixMarket, Symmetric)
+{
+  TemporaryFile file("matrix_io_symmetric.mtx");
+  file.write("%%MatrixMarket matrix coordinate real symmetric\n"
+             "% a comment\n"
+             "\n"
+             "3 3 3\n"
+             "1 1 2.0\n"
+             "3 1 -1.5e0\n"
+             "3 3 4\n");
+
+  auto mat = read_matrix_market<double>(file.name());
+  LocalCooMatrix<double> expected;
+  expected.add(0, 0, 2.0);
+  expected.add(2, 0, -1.5);
+  expected.add(0, 2, -1.5);
+  expected.add(2, 2, 4.0);
+  EXPECT_EQ(mat.entries(), expected.entries());
+
+  // only the last row
+  auto block = read_matrix_market<double>(file.name(), 2, 3);
+  LocalCooMatrix<double> expected_block;
+  expected_block.add(2, 0, -1.5);
+  expected_block.add(2, 2, 4.0);
+  EXPECT_EQ(block.entries(), expected_block.entries());
+}
+
+TEST(MatrixMarket, HermitianPattern)
+{
+  TemporaryFile file("matrix_io_hermitian.mtx");
+  file.write("%%MatrixMarket matrix coordinate complex hermitian\n"
+             "2 2 2\n"
+             "1 1 1 0\n"
+             "2 1 2 3\n");
+
+  auto mat = read_matrix_market<std::complex<double>>(file.name());
+  LocalCooMatrix<std::complex<double>> expected;
+  expected.add(0, 0, {1, 0});
+  expected.add(1, 0, {2, 3});
+  expected.add(0, 1, {2, -3});
+  EXPECT_EQ(mat.entries(), expected.entries());
+
+  EXPECT_THROW(read_matrix_market<double>(file.name()),
+               std::invalid_argument);
+
+  file.write("%%MatrixMarket matrix coordinate pattern general\n"
+             "2 3 2\n"
+             "1 3\n"
+             "2 1\n");
+  auto pattern = read_matrix_market<double>(file.name());
+  LocalCooMatrix<double> expected_pattern;
+  expected_pattern.add(0, 2, 1.0);
+  expected_pattern.add(1, 0, 1.0);
+  EXPECT_EQ(pattern.entries(), expected_pattern.entries());
+}
+
+TEST(MatrixMarket, Invalid)
+{
+  TemporaryFile file("matrix_io_invalid.mtx");
+
+  file.write("%%MatrixMarket matrix coordinate real general\n"
+             "2 2 2\n"
+             "1 1 1.0\n");
+  EXPECT_THROW(read_matrix_market<double>(file.name()), std::runtime_error);
+
+  file.write("%%MatrixMarket matrix coordinate real general\n"
+             "2 2 1\n"
+             "3 1 1.0\n");
+  EXPECT_THROW(read_matrix_market<double>(file.name()), std::runtime_error);
+
+  file.write("%%MatrixMarket matrix array real general\n"
+             "2 2\n");
+  EXPECT_THROW(read_matrix_market<double>(file.name()), std::runtime_error);
+
+  EXPECT_THROW(read_matrix_market<double>("matrix_io_missing.mtx"),
+               std::runtime_error);
+}
+
+TEST(MatrixMarket, LargeFile)
+{
+  // large enough to be parsed in several chunks
+  TemporaryFile file("matrix_io_large.mtx");
+  auto mat = example_matrix<double>(300, 300);
+  write_matrix_market(file.name(), mat, 300, 300);
+
+  auto result = read_matrix_market<double>(file.name());
+  EXPECT_EQ(result.entries(), mat.entries());
+}
+
+TEST(MatrixIo, LoadIntoStorage)
+{
+  TemporaryFile mtx_file("matrix_io_load.mtx");
+  TemporaryFile csr_file("matrix_io_load.csr");
+
+  auto coo = example_matrix<double>(6, 6);
+  write_matrix_market(mtx_file.name(), coo, 6, 6);
+  write_binary_csr(csr_file.name(), LocalCsrMatrix<double>(6, 6, coo));
+
+  VectorSpec spec(Comm::world(), 6, 6);
+  CsrSparseMatrixStorage<double> expected(spec, spec);
+  CsrSparseMatrixStorage<double> from_mtx(spec, spec);
+  CsrSparseMatrixStorage<double> from_csr(spec, spec);
+  expected.set_entries(coo);
+  load_matrix_market(from_mtx, mtx_file.name());
+  load_binary_csr(from_csr, csr_file.name());
+
+  EXPECT_EQ(from_mtx.local_matrix().values(),
+            expected.local_matrix().values());
+  EXPECT_EQ(from_csr.local_matrix().col_ind(),
+            expected.local_matrix().col_ind());
+  EXPECT_EQ(from_csr.local_matrix().values(),
+            expected.local_matrix().values());
+
+  VectorSpec wrong_spec(Comm::world(), 5, 5);
+  CsrSparseMatrixStorage<double> wrong(wrong_spec, wrong_spec);
+  EXPECT_THROW(load_binary_csr(wrong, csr_file.name()), std::runtime_error);
+}
@@ -0,0 +1,200 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <allium/config.hpp>
+#include <allium/la/distributed_vector.hpp>
+#include <allium/la/multi_vector.hpp>
+#include <allium/la/petsc_multi_vector.hpp>
+
+#include <cmath>
+#include <complex>
+#include <gtest/gtest.h>
+
+using namespace allium;
+
+namespace {
+  VectorSpec even_spec(global_size_t size)
+  {
+    auto comm = Comm::world();
+    size_t local_size = size / comm.size();
+    if (static_cast<global_size_t>(comm.rank()) < size % comm.size()) {
+      ++local_size;
+    }
+    return VectorSpec(comm, local_size, size);
+  }
+
+  template <typename N, int StorageOrder>
+  void fill_values(MultiVector<N, StorageOrder>& x, int seed)
+  {
+    auto spec = x.spec();
+    for (size_t j = 0; j < x.count(); ++j) {
+      for (size_t i = 0; i < spec.local_size(); ++i) {
+        global_size_t global = spec.local_start() + i;
+        x.native()(i, j) = N((global * 7 + j * 3 + seed) % 5) - N(2);
+      }
+    }
+  }
+
+  template <typename T>
+  struct MultiVectorTest : public testing::Test {};
+}
+
+template <typename N, int S>
+struct MultiVectorType {
+  using Number = N;
+  using Type = MultiVector<N, S>;
+};
+
+typedef testing::Types<
+    MultiVectorType<double, Eigen::ColMajor>
+    , MultiVectorType<double, Eigen::RowMajor>
+    , MultiVectorType<std::complex<double>, Eigen::ColMajor>
+    , MultiVectorType<std::complex<double>, Eigen::RowMajor>
+  > MultiVectorTypes;
+
+TYPED_TEST_SUITE(MultiVectorTest, MultiVectorTypes);
+
+TYPED_TEST(MultiVectorTest, GetAndSet)
+{
+  using Number = typename TypeParam::Number;
+  using MV = typename TypeParam::Type;
+
+  auto spec = even_spec(10);
+  MV x(spec, 3);
+  fill_values(x, 1);
+
+  DistributedVectorStorage<Number> v(spec);
+  x.get(1, v);
+  x.set(2, v);
+
+  for (size_t i = 0; i < spec.local_size(); ++i) {
+    EXPECT_EQ(x.native()(i, 2), x.native()(i, 1));
+    EXPECT_EQ(v.native()[i], x.native()(i, 1));
+  }
+}
+
+TYPED_TEST(MultiVectorTest, InnerProducts)
+{
+  using Number = typename TypeParam::Number;
+  using MV = typename TypeParam::Type;
+
+  auto spec = even_spec(17);
+  MV x(spec, 3), y(spec, 4);
+  fill_values(x, 1);
+  fill_values(y, 2);
+
+  auto c = x.inner_products(y);
+  ASSERT_EQ(c.rows(), 3);
+  ASSERT_EQ(c.cols(), 4);
+
+  // the same values, computed by separate dot products
+  DistributedVectorStorage<Number> xi(spec), yj(spec);
+  for (size_t i = 0; i < 3; ++i) {
+    x.get(i, xi);
+    for (size_t j = 0; j < 4; ++j) {
+      y.get(j, yj);
+      Number expected = yj.dot(xi);
+      EXPECT_NEAR(std::abs(c(i, j) - expected), 0.0, 1e-12);
+    }
+  }
+}
+
+TYPED_TEST(MultiVectorTest, AddProduct)
+{
+  using Number = typename TypeParam::Number;
+  using MV = typename TypeParam::Type;
+
+  auto spec = even_spec(11);
+  MV x(spec, 2), y(spec, 3);
+  fill_values(x, 1);
+  fill_values(y, 2);
+  MV expected(spec, 3);
+  expected.add_scaled(1.0, y);
+
+  LocalMatrix<Number> c { { 1, 0, 2 },
+                          { -1, 3, 0 } };
+  y.add_product(x, c);
+
+  for (size_t i = 0; i < spec.local_size(); ++i) {
+    expected.native()(i, 0) += x.native()(i, 0) - x.native()(i, 1);
+    expected.native()(i, 1) += 3.0 * x.native()(i, 1);
+    expected.native()(i, 2) += 2.0 * x.native()(i, 0);
+  }
+
+  expected.add_scaled(-1.0, y);
+  for (auto norm : expected.l2_norms()) {
+    EXPECT_EQ(norm, 0.0);
+  }
+
+  LocalMatrix<Number> wrong_size(3, 3);
+  EXPECT_THROW(y.add_product(x, wrong_size), std::invalid_argument);
+}
+
+TYPED_TEST(MultiVectorTest, Norms)
+{
+  using Number = typename TypeParam::Number;
+  using MV = typename TypeParam::Type;
+
+  auto spec = even_spec(9);
+  MV x(spec, 3);
+  fill_values(x, 4);
+  x *= 2.0;
+
+  auto norms = x.l2_norms();
+  ASSERT_EQ(norms.size(), 3);
+
+  DistributedVectorStorage<Number> v(spec);
+  for (size_t i = 0; i < 3; ++i) {
+    x.get(i, v);
+    EXPECT_NEAR(norms[i], v.l2_norm(), 1e-12);
+  }
+
+  x.fill(1.0);
+  for (auto norm : x.l2_norms()) {
+    EXPECT_NEAR(norm, 3.0, 1e-12);
+  }
+}
+
+TEST(MultiVector, InnerProductsConjugate)
+{
+  using Number = std::complex<double>;
+
+  auto spec = even_spec(1);
+  MultiVector<Number> x(spec, 1), y(spec, 1);
+  if (spec.local_size() > 0) {
+    x.native()(0, 0) = Number(0, 1);
+    y.native()(0, 0) = Number(2, 0);
+  }
+
+  // conj(i) * 2
+  auto c = x.inner_products(y);
+  EXPECT_EQ(c(0, 0), Number(0, -2));
+}
+
+#ifdef ALLIUM_USE_PETSC
+TEST(PetscMultiVector, SharesStorage)
+{
+  auto spec = even_spec(10);
+  PetscMultiVector x(spec, 2);
+  fill_values(x, 1);
+
+  // the PETSc vectors see the values of the block and vice versa
+  auto norms = x.l2_norms();
+  EXPECT_NEAR(x.vector(0).l2_norm(), norms[0], 1e-12);
+  EXPECT_NEAR(x.vector(1).l2_norm(), norms[1], 1e-12);
+
+  x.vector(1).fill(1.0);
+  EXPECT_NEAR(x.l2_norms()[1], std::sqrt(10.0), 1e-12);
+}
+#endif
@@ -0,0 +1,235 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <allium/la/cg.hpp>
+#include <allium/la/csr_sparse_matrix.hpp>
+#include <allium/la/eigen_vector.hpp>
+#include <allium/la/operator_algebra.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace allium;
+
+using Number = double;
+using Vector = EigenVectorStorage<Number>;
+using Matrix = CsrSparseMatrixStorage<Number>;
+
+static std::shared_ptr<Matrix> laplace_1d(VectorSpec spec)
+{
+  size_t n = spec.global_size();
+  LocalCooMatrix<Number> coo;
+  for (size_t i = 0; i < n; ++i) {
+    coo.add(i, i, 2);
+    if (i > 0) coo.add(i, i-1, -1);
+    if (i < n-1) coo.add(i, i+1, -1);
+  }
+
+  auto mat = std::make_shared<Matrix>(spec, spec);
+  mat->set_entries(std::move(coo));
+  return mat;
+}
+
+static void fill_values(Vector& v, int seed)
+{
+  auto loc = local_slice(v);
+  for (size_t i = 0; i < loc.size(); ++i) {
+    loc[i] = (i * 7 + seed) % 5 - 2.0;
+  }
+}
+
+/** Scales by a constant and counts the calls of each method. */
+class CountingScaling : public ShiftableOperator<Vector> {
+  public:
+    explicit CountingScaling(Number factor) : factor(factor) {}
+
+    void apply_shifted_add(Vector& result,
+                           Number alpha,
+                           Number shift,
+                           const Vector& arg,
+                           Number beta) override
+    {
+      ++shifted_calls;
+      auto y = local_slice(result);
+      auto x = local_slice(arg);
+      for (size_t i = 0; i < y.size(); ++i) {
+        Number value = alpha * (factor + shift) * x[i];
+        y[i] = beta == 0.0 ? value : beta * y[i] + value;
+      }
+    }
+
+    Number factor;
+    int shifted_calls = 0;
+};
+
+TEST(OperatorAlgebra, Sum)
+{
+  VectorSpec spec(Comm::world(), 8, 8);
+  auto a = laplace_1d(spec);
+
+  // 2 A + A + 3 I - I
+  auto op = operator_sum(scaled_operator(2.0, a),
+                         shifted_operator(a, 3.0));
+  op = shifted_operator(op, -1.0);
+
+  auto combination
+    = std::dynamic_pointer_cast<LinearCombinationOperator<Vector>>(op);
+  ASSERT_TRUE(combination);
+  EXPECT_EQ(combination->terms().size(), 2);
+  EXPECT_EQ(combination->shift(), 2.0);
+
+  Vector x(spec), y(spec), expected(spec);
+  fill_values(x, 1);
+  op->apply(y, x);
+
+  a->apply(expected, x);
+  expected *= 3.0;
+  expected.add_scaled(2.0, x);
+
+  expected.add_scaled(-1.0, y);
+  EXPECT_NEAR(expected.l2_norm(), 0.0, 1e-12);
+}
+
+TEST(OperatorAlgebra, ApplyAdd)
+{
+  VectorSpec spec(Comm::world(), 8, 8);
+  auto a = laplace_1d(spec);
+  auto op = shifted_operator(scaled_operator(-1.0, a), 4.0);
+
+  Vector x(spec), y(spec), expected(spec), ax(spec);
+  fill_values(x, 1);
+  fill_values(y, 3);
+
+  // expected = 0.5 (-A + 4 I) x + 2 y
+  a->apply(ax, x);
+  expected.assign(y);
+  expected *= 2.0;
+  expected.add_scaled(-0.5, ax);
+  expected.add_scaled(2.0, x);
+
+  op->apply_add(y, 0.5, x, 2.0);
+
+  expected.add_scaled(-1.0, y);
+  EXPECT_NEAR(expected.l2_norm(), 0.0, 1e-12);
+}
+
+TEST(OperatorAlgebra, ShiftIsFolded)
+{
+  VectorSpec spec(Comm::world(), 4, 4);
+  auto a = std::make_shared<CountingScaling>(2.0);
+  auto op = shifted_operator(scaled_operator(3.0, a), 1.5);
+
+  Vector x(spec), y(spec);
+  fill_values(x, 1);
+  op->apply(y, x);
+
+  // 3 (2 + 0.5) = 7.5, in a single call of the shiftable operator
+  EXPECT_EQ(a->shifted_calls, 1);
+  auto loc_x = local_slice(x);
+  auto loc_y = local_slice(y);
+  for (size_t i = 0; i < loc_y.size(); ++i) {
+    EXPECT_NEAR(loc_y[i], 7.5 * loc_x[i], 1e-12);
+  }
+}
+
+TEST(OperatorAlgebra, ShiftWithDuplicatedTerm)
+{
+  VectorSpec spec(Comm::world(), 4, 4);
+  auto a = std::make_shared<CountingScaling>(2.0);
+  auto op = operator_sum(shifted_operator(a, 3.0), a);
+
+  Vector x(spec), y(spec);
+  fill_values(x, 1);
+  op->apply(y, x);
+
+  // (2 + 3) + 2 = 7, the shift is applied once
+  auto loc_x = local_slice(x);
+  auto loc_y = local_slice(y);
+  for (size_t i = 0; i < loc_y.size(); ++i) {
+    EXPECT_NEAR(loc_y[i], 7.0 * loc_x[i], 1e-12);
+  }
+}
+
+TEST(OperatorAlgebra, DiagonalScaling)
+{
+  VectorSpec spec(Comm::world(), 8, 8);
+  auto a = laplace_1d(spec);
+
+  auto d = std::make_shared<Vector>(spec);
+  fill_values(*d, 2);
+  auto op = composed_operator(diagonal_operator(d), a);
+
+  Vector x(spec), y(spec), ax(spec);
+  fill_values(x, 1);
+  a->apply(ax, x);
+
+  op->apply(y, x);
+  { auto loc_y = local_slice(y);
+    auto loc_ax = local_slice(ax);
+    auto loc_d = local_slice(*d);
+    for (size_t i = 0; i < loc_y.size(); ++i) {
+      EXPECT_NEAR(loc_y[i], loc_d[i] * loc_ax[i], 1e-12);
+    }
+  }
+
+  // the operator refers to the diagonal, updates are visible
+  d->fill(2.0);
+  fill_values(y, 3);
+  Vector expected(spec);
+  expected.assign(y);
+  expected.add_scaled(2.0, ax);
+
+  op->apply_add(y, 1.0, x, 1.0);
+
+  expected.add_scaled(-1.0, y);
+  EXPECT_NEAR(expected.l2_norm(), 0.0, 1e-12);
+}
+
+TEST(OperatorAlgebra, Composition)
+{
+  VectorSpec spec(Comm::world(), 8, 8);
+  auto a = laplace_1d(spec);
+  auto op = composed_operator(shifted_operator(a, 1.0), a);
+
+  Vector x(spec), y(spec), expected(spec), ax(spec);
+  fill_values(x, 1);
+  a->apply(ax, x);
+  a->apply(expected, ax);
+  expected.add_scaled(1.0, ax);
+
+  op->apply(y, x);
+  expected.add_scaled(-1.0, y);
+  EXPECT_NEAR(expected.l2_norm(), 0.0, 1e-12);
+}
+
+TEST(OperatorAlgebra, Cg)
+{
+  VectorSpec spec(Comm::world(), 16, 16);
+  auto a = laplace_1d(spec);
+  auto d = std::make_shared<Vector>(spec);
+  d->fill(0.5);
+
+  // A + 0.5 I + diag(d) is symmetric positive definite
+  auto op = operator_sum(shifted_operator(a, 0.5), diagonal_operator(d));
+
+  Vector b(spec), x(spec), r(spec);
+  fill_values(b, 1);
+
+  CgSolver<Vector> solver;
+  solver.setup(op);
+  solver.solve(x, b);
+
+  op->apply(r, x);
+  r.add_scaled(-1.0, b);
+  EXPECT_LT(r.l2_norm(), 1e-6 * b.l2_norm());
+}
@@ -0,0 +1,134 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <allium/la/reordering.hpp>
+#include <allium/la/csr_sparse_matrix.hpp>
+
+#include <random>
+#include <gtest/gtest.h>
+
+using namespace allium;
+
+namespace {
+  /** The 2D Laplace operator on an n x n grid with shuffled numbering. */
+  LocalCooMatrix<double> shuffled_laplace_2d(global_size_t n,
+                                             const Permutation& shuffle)
+  {
+    LocalCooMatrix<double> mat;
+    auto index = [&](global_size_t i, global_size_t j) {
+      return shuffle.new_index(i*n + j);
+    };
+
+    for (global_size_t i = 0; i < n; ++i) {
+      for (global_size_t j = 0; j < n; ++j) {
+        mat.add(index(i, j), index(i, j), 4.0);
+        if (i > 0)   mat.add(index(i, j), index(i-1, j), -1.0);
+        if (i < n-1) mat.add(index(i, j), index(i+1, j), -1.0);
+        if (j > 0)   mat.add(index(i, j), index(i, j-1), -1.0);
+        if (j < n-1) mat.add(index(i, j), index(i, j+1), -1.0);
+      }
+    }
+    return mat;
+  }
+
+  Permutation random_permutation(global_size_t size)
+  {
+    std::vector<global_size_t> indices(size);
+    std::iota(indices.begin(), indices.end(), 0);
+    std::shuffle(indices.begin(), indices.end(), std::mt19937(42));
+    return Permutation(indices);
+  }
+}
+
+TEST(Permutation, Inverse)
+{
+  Permutation p({2, 0, 1});
+
+  EXPECT_EQ(p.old_index(0), 2);
+  EXPECT_EQ(p.new_index(2), 0);
+
+  auto q = p.inverse();
+  for (global_size_t i = 0; i < p.size(); ++i) {
+    EXPECT_EQ(q.old_index(i), p.new_index(i));
+  }
+}
+
+TEST(Permutation, Invalid)
+{
+  EXPECT_THROW(Permutation({0, 0, 1}), std::invalid_argument);
+  EXPECT_THROW(Permutation({0, 3, 1}), std::invalid_argument);
+}
+
+TEST(ReverseCuthillMcKee, ReducesBandwidth)
+{
+  const global_size_t n = 20;
+  auto mat = shuffled_laplace_2d(n, random_permutation(n*n));
+
+  auto perm = reverse_cuthill_mckee(mat, n*n);
+  auto reordered = permute(mat, perm);
+
+  EXPECT_GT(bandwidth(mat), 10*n);
+  EXPECT_LE(bandwidth(reordered), n+1);
+  auto restored = unpermute(reordered, perm);
+  EXPECT_EQ(restored.entries(), mat.entries());
+}
+
+TEST(ReverseCuthillMcKee, DisconnectedComponents)
+{
+  LocalCooMatrix<double> mat;
+  mat.add(0, 3, 1.0);
+  mat.add(3, 0, 1.0);
+  mat.add(1, 4, 1.0);
+  mat.add(4, 1, 1.0);
+  mat.add(2, 2, 1.0);
+
+  auto perm = reverse_cuthill_mckee(mat, 5);
+  ASSERT_EQ(perm.size(), 5);
+  EXPECT_EQ(bandwidth(permute(mat, perm)), 1);
+}
+
+TEST(ReverseCuthillMcKee, ConsistentVectors)
+{
+  const global_size_t n = 8;
+  VectorSpec spec(Comm::world(), n*n, n*n);
+
+  auto coo = shuffled_laplace_2d(n, random_permutation(n*n));
+  auto perm = reverse_cuthill_mckee(coo, n*n);
+
+  CsrSparseMatrixStorage<double> mat(spec, spec);
+  CsrSparseMatrixStorage<double> reordered(spec, spec);
+  mat.set_entries(coo);
+  reordered.set_entries(permute(coo, perm));
+
+  EigenVectorStorage<double> x(spec), y(spec);
+  {
+    auto lx = local_slice(x);
+    for (size_t i = 0; i < lx.size(); ++i) {
+      lx[i] = i;
+    }
+  }
+  mat.apply(y, x);
+
+  // (P A P^T) (P x) = P y
+  EigenVectorStorage<double> px(spec), py(spec), z(spec);
+  permute(px, x, perm);
+  reordered.apply(py, px);
+  unpermute(z, py, perm);
+
+  auto ly = local_slice(y);
+  auto lz = local_slice(z);
+  for (size_t i = 0; i < ly.size(); ++i) {
+    EXPECT_EQ(lz[i], ly[i]);
+  }
+}
@@ -13,9 +13,22 @@
 // limitations under the License.
 
 #include <allium/config.hpp>
+#include <allium/la/autotuned_sparse_matrix.hpp>
+#include <allium/la/bsr_sparse_matrix.hpp>
+#include <allium/la/compact_csr_sparse_matrix.hpp>
+#include <allium/la/csr_sparse_matrix.hpp>
+#include <allium/la/distributed_csr_sparse_matrix.hpp>
 #include <allium/la/eigen_sparse_matrix.hpp>
+#include <allium/la/local_csr_matrix.hpp>
+#include <allium/la/multi_vector.hpp>
 #include <allium/la/petsc_sparse_matrix.hpp>
+#include <allium/la/sell_sparse_matrix.hpp>
+#include <allium/la/symmetric_csr_sparse_matrix.hpp>
+#include <allium/util/parallel.hpp>
 
+#include <cstdio>
+#include <fstream>
+#include <limits>
 #include <gtest/gtest.h>
 
 using namespace allium;
@@ -24,6 +37,20 @@ typedef
   testing::Types<
     EigenSparseMatrixStorage<double>
     , EigenSparseMatrixStorage<std::complex<double>>
+    , EigenSparseMatrixStorage<double, Eigen::RowMajor>
+    , EigenSparseMatrixStorage<std::complex<double>, Eigen::RowMajor>
+    , CsrSparseMatrixStorage<double>
+    , CsrSparseMatrixStorage<std::complex<double>>
+    , DistributedCsrSparseMatrixStorage<double>
+    , DistributedCsrSparseMatrixStorage<std::complex<double>>
+    , CompactCsrSparseMatrixStorage<double>
+    , CompactCsrSparseMatrixStorage<double, float>
+    , CompactCsrSparseMatrixStorage<std::complex<double>, std::complex<float>>
+    , SellSparseMatrixStorage<float>
+    , SellSparseMatrixStorage<double>
+    , SellSparseMatrixStorage<std::complex<double>>
+    , AutotunedSparseMatrixStorage<double>
+    , AutotunedSparseMatrixStorage<std::complex<double>>
     #ifdef ALLIUM_USE_PETSC
       , PetscSparseMatrixStorage<double>
       #ifdef ALLIUM_PETSC_HAS_COMPLEX
@@ -55,7 +82,8 @@ TYPED_TEST(SparseMatrixTest, SetAndReadEntries)
 
   mat.set_entries(lmat);
 
-  ASSERT_EQ(lmat.entries(), mat.get_entries().entries());
+  auto entries = mat.get_entries();
+  ASSERT_EQ(lmat.entries(), entries.entries());
 }
 
 TYPED_TEST(SparseMatrixTest, MatVecMult)
@@ -108,3 +136,671 @@ TYPED_TEST(SparseMatrixTest, MatVecMult2)
   }
 }
 
+
+TYPED_TEST(SparseMatrixTest, Rectangular)
+{
+  using Number = typename TypeParam::Number;
+  using Vector = typename TypeParam::DefaultVector;
+
+  // more columns than rows, row i sums the columns i, i + 3, i + 6, ...
+  const size_t rows = 3;
+  const size_t cols = 40;
+  VectorSpec row_spec(Comm::world(), rows, rows);
+  VectorSpec col_spec(Comm::world(), cols, cols);
+  TypeParam mat(row_spec, col_spec);
+
+  LocalCooMatrix<Number> lmat;
+  for (size_t j = 0; j < cols; ++j) {
+    lmat.add(j % rows, j, 1);
+  }
+  mat.set_entries(lmat);
+
+  Vector v(col_spec);
+  { auto loc = local_slice(v);
+    for (size_t j = 0; j < cols; ++j) {
+      loc[j] = j;
+    }
+  }
+
+  Vector w(row_spec);
+  mat.apply(w, v);
+
+  { auto loc = local_slice(w);
+    for (size_t i = 0; i < rows; ++i) {
+      Number expected = 0;
+      for (size_t j = i; j < cols; j += rows) {
+        expected += Number(j);
+      }
+      ASSERT_EQ(loc[i], expected);
+    }
+  }
+}
+
+TYPED_TEST(SparseMatrixTest, SetCsr)
+{
+  using Number = typename TypeParam::Number;
+
+  const size_t rows = 20;
+  const size_t cols = 30;
+  VectorSpec row_spec(Comm::world(), rows, rows);
+  VectorSpec col_spec(Comm::world(), cols, cols);
+
+  LocalCooMatrix<Number> lmat;
+  for (size_t i = 0; i < rows; ++i) {
+    for (size_t j = i % 3; j < cols; j += 4) {
+      lmat.add(i, j, Number(i + 2*j));
+    }
+  }
+
+  TypeParam expected(row_spec, col_spec);
+  expected.set_entries(lmat);
+
+  TypeParam mat(row_spec, col_spec);
+  mat.set_csr(LocalCsrMatrix<Number>(rows, cols, lmat));
+  auto entries = mat.get_entries();
+  auto expected_entries = expected.get_entries();
+  EXPECT_EQ(entries.entries(), expected_entries.entries());
+
+  EXPECT_THROW(mat.set_csr(LocalCsrMatrix<Number>(rows, cols + 1)),
+               std::invalid_argument);
+}
+
+TYPED_TEST(SparseMatrixTest, ApplyAdd)
+{
+  using Number = typename TypeParam::Number;
+  using Vector = typename TypeParam::DefaultVector;
+
+  VectorSpec spec(Comm::world(), 2, 2);
+  TypeParam mat(spec, spec);
+
+  LocalCooMatrix<Number> lmat;
+  lmat.add(0, 0, 1);
+  lmat.add(0, 1, 5);
+  lmat.add(1, 0, 2);
+  lmat.add(1, 1, 3);
+  mat.set_entries(lmat);
+
+  Vector v(spec);
+  local_slice(v) = { 3, -1 };
+
+  // w = 2 A v - w
+  Vector w(spec);
+  local_slice(w) = { 1, 2 };
+  mat.apply_add(w, 2, v, -1);
+
+  { auto loc = local_slice(w);
+    ASSERT_EQ(loc[0], -5.0);
+    ASSERT_EQ(loc[1], 4.0);
+  }
+
+  // w = -A v, the previous values are not read
+  local_slice(w) = { std::numeric_limits<double>::quiet_NaN(), 0 };
+  mat.apply_add(w, -1, v, 0);
+
+  { auto loc = local_slice(w);
+    ASSERT_EQ(loc[0], 2.0);
+    ASSERT_EQ(loc[1], -3.0);
+  }
+}
+
+TYPED_TEST(SparseMatrixTest, ApplyMulti)
+{
+  using Number = typename TypeParam::Number;
+  using Vector = typename TypeParam::DefaultVector;
+  using OperatorVector = typename TypeParam::Vector;
+
+  VectorSpec spec(Comm::world(), 2, 2);
+  TypeParam mat(spec, spec);
+
+  LocalCooMatrix<Number> lmat;
+  lmat.add(0, 0, 1);
+  lmat.add(0, 1, 5);
+  lmat.add(1, 0, 2);
+  lmat.add(1, 1, 3);
+  mat.set_entries(lmat);
+
+  Vector v1(spec), v2(spec), w1(spec), w2(spec);
+  local_slice(v1) = { 3, -1 };
+  local_slice(v2) = { 0, 1 };
+
+  mat.apply_multi(std::vector<OperatorVector*>{ &w1, &w2 },
+                  std::vector<const OperatorVector*>{ &v1, &v2 });
+
+  { auto loc = local_slice(w1);
+    ASSERT_EQ(loc[0], -2.0);
+    ASSERT_EQ(loc[1], 3.0);
+  }
+  { auto loc = local_slice(w2);
+    ASSERT_EQ(loc[0], 5.0);
+    ASSERT_EQ(loc[1], 3.0);
+  }
+}
+
+TYPED_TEST(SparseMatrixTest, MatVecMultLarge)
+{
+  using Number = typename TypeParam::Number;
+  using Vector = typename TypeParam::DefaultVector;
+
+  // the tridiagonal matrix with 2 on the diagonal and -1 next to it
+  const size_t n = 1000;
+  VectorSpec spec(Comm::world(), n, n);
+  TypeParam mat(spec, spec);
+
+  LocalCooMatrix<Number> lmat;
+  for (size_t i = 0; i < n; ++i) {
+    if (i > 0) lmat.add(i, i-1, -1);
+    lmat.add(i, i, 2);
+    if (i < n-1) lmat.add(i, i+1, -1);
+  }
+  mat.set_entries(lmat);
+
+  Vector v(spec);
+  { auto loc = local_slice(v);
+    for (size_t i = 0; i < n; ++i) {
+      loc[i] = i * i;
+    }
+  }
+
+  Vector w(spec);
+  mat.apply(w, v);
+
+  { auto loc = local_slice(w);
+    ASSERT_EQ(loc[0], -1.0);
+    for (size_t i = 1; i < n-1; ++i) {
+      ASSERT_EQ(loc[i], -2.0);
+    }
+    ASSERT_EQ(loc[n-1], 2.0 * (n-1) * (n-1) - 1.0 * (n-2) * (n-2));
+  }
+}
+
+TYPED_TEST(SparseMatrixTest, VaryingRowLengths)
+{
+  using Number = typename TypeParam::Number;
+  using Vector = typename TypeParam::DefaultVector;
+
+  // row i has the entries 1, ..., i % 7 in the first columns
+  const size_t n = 50;
+  VectorSpec spec(Comm::world(), n, n);
+  TypeParam mat(spec, spec);
+
+  LocalCooMatrix<Number> lmat;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < i % 7; ++j) {
+      lmat.add(i, j, j+1);
+    }
+  }
+  mat.set_entries(lmat);
+
+  // the order of the entries depends on the format
+  auto entries = LocalCsrMatrix<Number>(n, n, mat.get_entries()).to_coo();
+  ASSERT_EQ(entries.entries(), lmat.entries());
+
+  Vector v(spec);
+  v.fill(1.0);
+
+  Vector w(spec);
+  mat.apply(w, v);
+
+  { auto loc = local_slice(w);
+    for (size_t i = 0; i < n; ++i) {
+      size_t k = i % 7;
+      ASSERT_EQ(loc[i], Number(k * (k+1) / 2));
+    }
+  }
+}
+
+TYPED_TEST(SparseMatrixTest, ApplyBlock)
+{
+  using Number = typename TypeParam::Number;
+  using Vector = typename TypeParam::DefaultVector;
+  using Block = MultiVector<Number, Eigen::RowMajor>;
+
+  // row i has the entries 1, ..., i % 7 in the first columns
+  const size_t n = 50;
+  VectorSpec spec(Comm::world(), n, n);
+  TypeParam mat(spec, spec);
+
+  LocalCooMatrix<Number> lmat;
+  for (size_t i = 0; i < n; ++i) {
+    for (size_t j = 0; j < i % 7; ++j) {
+      lmat.add(i, (i + j) % n, j+1);
+    }
+  }
+  mat.set_entries(lmat);
+
+  // a fixed and a variable kernel width
+  for (size_t k : { 4, 3 }) {
+    Block x(spec, k), y(spec, k);
+    for (size_t i = 0; i < n; ++i) {
+      for (size_t j = 0; j < k; ++j) {
+        x.native()(i, j) = Number((i + 3 * j) % 5);
+      }
+    }
+
+    mat.apply_block(y, x);
+
+    Vector v(spec), w(spec);
+    for (size_t j = 0; j < k; ++j) {
+      x.get(j, v);
+      mat.apply(w, v);
+
+      auto loc = local_slice(w);
+      for (size_t i = 0; i < n; ++i) {
+        ASSERT_EQ(y.native()(i, j), loc[i]);
+      }
+    }
+  }
+}
+
+typedef
+  testing::Types<
+    EigenSparseMatrixStorage<double>
+    , EigenSparseMatrixStorage<std::complex<double>>
+    , EigenSparseMatrixStorage<double, Eigen::RowMajor>
+    , CsrSparseMatrixStorage<double>
+    , DistributedCsrSparseMatrixStorage<double>
+    , SellSparseMatrixStorage<double>
+    , SellSparseMatrixStorage<std::complex<double>>
+    #ifdef ALLIUM_USE_PETSC
+      , PetscSparseMatrixStorage<double>
+    #endif
+    > ValueUpdateTypes;
+
+template <typename S>
+class SparseMatrixValueUpdateTest : public testing::Test {
+};
+
+TYPED_TEST_CASE(SparseMatrixValueUpdateTest, ValueUpdateTypes);
+
+TYPED_TEST(SparseMatrixValueUpdateTest, UpdateValues)
+{
+  using Number = typename TypeParam::Number;
+  using Vector = typename TypeParam::DefaultVector;
+
+  const size_t n = 20;
+  VectorSpec spec(Comm::world(), n, n);
+  TypeParam mat(spec, spec);
+
+  // tridiagonal, the diagonal is given as two entries
+  LocalCooMatrix<Number> lmat;
+  for (size_t i = 0; i < n; ++i) {
+    lmat.add(i, i, 1.0);
+    if (i > 0)
+      lmat.add(i, i-1, -1.0);
+    if (i+1 < n)
+      lmat.add(i, i+1, -1.0);
+    lmat.add(i, i, 1.0);
+  }
+  mat.set_entries(lmat);
+
+  auto scatter = mat.value_scatter(lmat);
+  EXPECT_EQ(scatter.value_count(), 3*n - 2);
+
+  for (size_t i = 0; i < lmat.entry_count(); ++i) {
+    lmat.values()[i] *= Number(i % 3 + 1);
+  }
+  mat.update_values(lmat, scatter);
+
+  TypeParam expected(spec, spec);
+  expected.set_entries(lmat);
+
+  Vector v(spec), w(spec), w_expected(spec);
+  { auto loc = local_slice(v);
+    for (size_t i = 0; i < n; ++i) {
+      loc[i] = i + 1;
+    }
+  }
+  mat.apply(w, v);
+  expected.apply(w_expected, v);
+
+  w_expected.add_scaled(-1.0, w);
+  EXPECT_EQ(w_expected.l2_norm(), 0.0);
+
+  // a flat array in pattern order
+  std::vector<Number> values(scatter.value_count(), Number(0));
+  EXPECT_THROW(mat.set_values(std::vector<Number>(1)), std::invalid_argument);
+  mat.set_values(values);
+  mat.apply(w, v);
+  EXPECT_EQ(w.l2_norm(), 0.0);
+}
+
+TYPED_TEST(SparseMatrixValueUpdateTest, EntryOutsidePattern)
+{
+  using Number = typename TypeParam::Number;
+
+  VectorSpec spec(Comm::world(), 2, 2);
+  TypeParam mat(spec, spec);
+
+  LocalCooMatrix<Number> lmat;
+  lmat.add(0, 0, 1.0);
+  mat.set_entries(lmat);
+
+  LocalCooMatrix<Number> other;
+  other.add(1, 0, 1.0);
+  EXPECT_THROW(mat.value_scatter(other), std::logic_error);
+}
+
+template <typename M>
+static void check_apply_transpose()
+{
+  using Vector = typename M::DefaultVector;
+
+  VectorSpec spec(Comm::world(), 2, 2);
+  M mat(spec, spec);
+
+  LocalCooMatrix<double> lmat;
+  lmat.add(0, 0, 1);
+  lmat.add(0, 1, 5);
+  lmat.add(1, 0, 2);
+  lmat.add(1, 1, 3);
+  mat.set_entries(lmat);
+
+  Vector v(spec), w(spec);
+  local_slice(v) = { 3, -1 };
+  mat.apply_transpose(w, v);
+
+  { auto loc = local_slice(w);
+    ASSERT_EQ(loc[0], 1.0);
+    ASSERT_EQ(loc[1], 12.0);
+  }
+}
+
+TEST(SparseMatrix, ApplyTranspose)
+{
+  check_apply_transpose<EigenSparseMatrixStorage<double>>();
+  check_apply_transpose<EigenRowMajorSparseMatrixStorage<double>>();
+  #ifdef ALLIUM_USE_PETSC
+    check_apply_transpose<PetscSparseMatrixStorage<double>>();
+  #endif
+
+  // there is no fallback for the transposed product
+  VectorSpec spec(Comm::world(), 2, 2);
+  CsrSparseMatrixStorage<double> mat(spec, spec);
+  EigenVectorStorage<double> v(spec), w(spec);
+  EXPECT_THROW(mat.apply_transpose(w, v), not_implemented);
+}
+
+template <typename M>
+void check_out_of_range_on_one_rank()
+{
+  // the other ranks must not wait for the rank with the invalid entry
+  auto comm = Comm::world();
+  VectorSpec spec(comm, 1, comm.size());
+
+  LocalCooMatrix<typename M::Number> lmat;
+  lmat.add(comm.rank(), 0, 1.0);
+  if (comm.rank() == 0) {
+    lmat.add(0, spec.global_size(), 1.0);
+  }
+
+  M mat(spec, spec);
+  EXPECT_THROW(mat.set_entries(lmat), std::out_of_range);
+}
+
+TEST(SparseMatrix, OutOfRangeOnOneRank)
+{
+  check_out_of_range_on_one_rank<DistributedCsrSparseMatrixStorage<double>>();
+  #ifdef ALLIUM_USE_PETSC
+    check_out_of_range_on_one_rank<PetscSparseMatrixStorage<double>>();
+  #endif
+}
+
+template <typename M>
+void check_apply_arguments()
+{
+  using Number = typename M::Number;
+  using Vector = typename M::DefaultVector;
+
+  VectorSpec spec(Comm::world(), 4, 4);
+  VectorSpec other_spec(Comm::world(), 2, 2);
+
+  LocalCooMatrix<Number> lmat;
+  for (size_t i = 0; i < 4; ++i)
+    lmat.add(i, i, 2);
+
+  M mat(spec, spec);
+  mat.set_entries(lmat);
+
+  Vector x(spec), y(spec), z(other_spec);
+  x.fill(1.0);
+  EXPECT_THROW(mat.apply(z, x), std::invalid_argument);
+  EXPECT_THROW(mat.apply(y, z), std::invalid_argument);
+  EXPECT_THROW(mat.apply(x, x), std::invalid_argument);
+}
+
+TEST(SparseMatrix, ApplyArguments)
+{
+  check_apply_arguments<CsrSparseMatrixStorage<double>>();
+  check_apply_arguments<CompactCsrSparseMatrixStorage<double, float>>();
+  check_apply_arguments<SellSparseMatrixStorage<double>>();
+  check_apply_arguments<BsrSparseMatrixStorage<double, 2>>();
+  check_apply_arguments<SymmetricCsrSparseMatrixStorage<double>>();
+}
+
+TEST(SparseMatrixValueUpdate, NotImplemented)
+{
+  VectorSpec spec(Comm::world(), 2, 2);
+  SymmetricCsrSparseMatrixStorage<double> mat(spec, spec);
+  EXPECT_THROW(mat.set_values(std::vector<double>(0)), not_implemented);
+}
+
+TEST(CompactCsrSparseMatrix, MixedPrecision)
+{
+  using Vector = EigenVectorStorage<double>;
+
+  VectorSpec spec(Comm::world(), 2, 2);
+  CompactCsrSparseMatrixStorage<double, float> mat(spec, spec);
+
+  LocalCooMatrix<double> lmat;
+  lmat.add(0, 0, 0.1);
+  lmat.add(0, 1, 1.0/3.0);
+  lmat.add(1, 1, 2.0);
+  mat.set_entries(lmat);
+
+  // the values are rounded to float, the product is computed in double
+  EXPECT_EQ(mat.values()[0], 0.1f);
+  EXPECT_EQ(mat.get_entries().values()[1], double(1.0f/3.0f));
+
+  Vector v(spec);
+  local_slice(v) = { 1e8, 1 };
+
+  Vector w(spec);
+  mat.apply(w, v);
+
+  { auto loc = local_slice(w);
+    EXPECT_EQ(loc[0], double(0.1f) * 1e8 + double(1.0f/3.0f));
+    EXPECT_EQ(loc[1], 2.0);
+  }
+}
+
+TEST(AutotunedSparseMatrix, Cache)
+{
+  const std::string cache_file = "autotuned_sparse_matrix_cache.txt";
+  std::remove(cache_file.c_str());
+
+  const size_t n = 100;
+  VectorSpec spec(Comm::world(), n, n);
+
+  LocalCooMatrix<double> lmat;
+  for (size_t i = 0; i < n; ++i) {
+    lmat.add(i, i, 2);
+    if (i > 0) lmat.add(i, i-1, -1);
+  }
+
+  AutotunedSparseMatrixStorage<double> tuned(spec, spec, cache_file);
+  tuned.set_entries(lmat);
+
+  size_t thread_counts = 0;
+  for (int threads = max_threads(); threads >= 1; threads /= 2)
+    ++thread_counts;
+  // the two Eigen formats are timed with max_threads() only
+  EXPECT_EQ(tuned.candidates().size(),
+            (AutotunedSparseMatrixStorage<double>::formats().size() - 2)
+            * thread_counts + 2);
+
+  // the second matrix uses the stored decision
+  AutotunedSparseMatrixStorage<double> cached(spec, spec, cache_file);
+  cached.set_entries(lmat);
+  EXPECT_TRUE(cached.candidates().empty());
+  EXPECT_EQ(cached.format(), tuned.format());
+  EXPECT_EQ(cached.threads(), tuned.threads());
+
+  // a different pattern is tuned again
+  lmat.add(0, n-1, 1);
+  cached.set_entries(lmat);
+  EXPECT_FALSE(cached.candidates().empty());
+
+  std::remove(cache_file.c_str());
+}
+
+TEST(AutotunedSparseMatrix, SetValuesForEachFormat)
+{
+  const std::string cache_file = "autotuned_sparse_matrix_values.txt";
+  std::remove(cache_file.c_str());
+
+  const size_t n = 50;
+  VectorSpec spec(Comm::world(), n, n);
+
+  LocalCooMatrix<double> lmat;
+  for (size_t i = 0; i < n; ++i) {
+    lmat.add(i, i, 2);
+    if (i > 0) lmat.add(i, i-1, -1);
+    if (i + 5 < n) lmat.add(i, i+5, 0.5);
+  }
+
+  // the key of the pattern, written by the first tuning
+  std::string key;
+  {
+    AutotunedSparseMatrixStorage<double> tuned(spec, spec, cache_file);
+    tuned.set_entries(lmat);
+    std::ifstream is(cache_file);
+    is >> key;
+  }
+  ASSERT_FALSE(key.empty());
+
+  // the new values, which depend on the position only
+  auto value = [](global_size_t i, global_size_t j) {
+    return 1.0 + 0.25 * ((3 * i + j) % 9);
+  };
+
+  LocalCooMatrix<double> updated;
+  for (const auto& e : lmat.entries())
+    updated.add(e.row(), e.col(), value(e.row(), e.col()));
+  CsrSparseMatrixStorage<double> ref(spec, spec);
+  ref.set_entries(updated);
+  auto ref_entries = ref.get_entries();
+
+  EigenVectorStorage<double> x(spec), expected(spec), y(spec);
+  {
+    auto lx = local_slice(x);
+    for (size_t i = 0; i < n; ++i)
+      lx[i] = 1.0 + i;
+  }
+  ref.apply(expected, x);
+
+  // force each format through the cache
+  for (const auto& format : AutotunedSparseMatrixStorage<double>::formats()) {
+    {
+      std::ofstream os(cache_file);
+      os << key << " " << format << " 1" << std::endl;
+    }
+
+    AutotunedSparseMatrixStorage<double> mat(spec, spec, cache_file);
+    mat.set_entries(lmat);
+    ASSERT_EQ(mat.format(), format);
+
+    // the pattern order does not depend on the format
+    auto entries = mat.get_entries();
+    std::vector<double> values;
+    for (const auto& e : entries.entries())
+      values.push_back(value(e.row(), e.col()));
+    mat.set_values(values);
+    auto updated_entries = mat.get_entries();
+    EXPECT_EQ(updated_entries.entries(), ref_entries.entries()) << format;
+
+    mat.apply(y, x);
+
+    auto ly = local_slice(y);
+    auto le = local_slice(expected);
+    for (size_t i = 0; i < n; ++i)
+      EXPECT_NEAR(ly[i], le[i], 1e-12 * std::abs(le[i])) << format;
+  }
+
+  std::remove(cache_file.c_str());
+}
+
+typedef testing::Types<double, std::complex<double>> SymmetricNumberTypes;
+
+template <typename N>
+class SymmetricCsrSparseMatrixTest : public testing::Test {};
+TYPED_TEST_SUITE(SymmetricCsrSparseMatrixTest, SymmetricNumberTypes);
+
+TYPED_TEST(SymmetricCsrSparseMatrixTest, MatchesCsr)
+{
+  using Number = TypeParam;
+  using Vector = EigenVectorStorage<Number>;
+
+  // a band matrix with some entries far from the diagonal
+  const size_t n = 200;
+  VectorSpec spec(Comm::world(), n, n);
+
+  LocalCooMatrix<Number> lmat;
+  auto add_pair = [&](size_t i, size_t j, Number value) {
+    lmat.add(i, j, value);
+    lmat.add(j, i, conj(value));
+  };
+  for (size_t i = 0; i < n; ++i) {
+    lmat.add(i, i, 4);
+    if (i + 1 < n) add_pair(i, i+1, Number(i % 5) - Number(2));
+    if (i + 3 < n) add_pair(i, i+3, 1);
+    if (i % 17 == 0) add_pair(i, n-1-i/17, 0.5);
+  }
+  if (is_complex<Number>::value)
+    add_pair(0, 1, std::sqrt(Number(-1)));
+
+  CsrSparseMatrixStorage<Number> full(spec, spec);
+  SymmetricCsrSparseMatrixStorage<Number> sym(spec, spec);
+  full.set_entries(lmat);
+  sym.set_entries(lmat);
+
+  // the upper triangle only
+  auto& upper = sym.upper_triangle();
+  for (size_t i_row = 0; i_row < n; ++i_row) {
+    for (size_t i = upper.row_ptr()[i_row]; i < upper.row_ptr()[i_row+1]; ++i) {
+      EXPECT_GE(upper.col_ind()[i], i_row);
+    }
+  }
+
+  auto entries = LocalCsrMatrix<Number>(n, n, sym.get_entries()).to_coo();
+  auto expected = full.local_matrix().to_coo();
+  EXPECT_EQ(entries.entries(), expected.entries());
+
+  Vector x(spec), y(spec), y_sym(spec);
+  { auto loc = local_slice(x);
+    for (size_t i = 0; i < n; ++i) {
+      loc[i] = Number(i % 11) - Number(5);
+    }
+  }
+  full.apply(y, x);
+
+  int threads = max_threads();
+  for (int t : {1, 3, 4}) {
+    set_max_threads(t);
+    sym.apply(y_sym, x);
+
+    auto loc = local_slice(y);
+    auto loc_sym = local_slice(y_sym);
+    for (size_t i = 0; i < n; ++i) {
+      EXPECT_NEAR(std::abs(loc_sym[i] - loc[i]), 0, 1e-12);
+    }
+  }
+  set_max_threads(threads);
+}
+
+TEST(SymmetricCsrSparseMatrix, NotSquare)
+{
+  VectorSpec rows(Comm::world(), 2, 2);
+  VectorSpec cols(Comm::world(), 3, 3);
+  EXPECT_THROW(SymmetricCsrSparseMatrixStorage<double>(rows, cols),
+               std::logic_error);
+}
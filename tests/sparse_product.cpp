@@ -0,0 +1,169 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <allium/la/sparse_product.hpp>
+
+#include <mpi.h>
+#include <gtest/gtest.h>
+
+using namespace allium;
+
+using MatrixTypes = ::testing::Types<CsrSparseMatrixStorage<double>,
+                                     EigenSparseMatrixStorage<double>,
+                                     EigenRowMajorSparseMatrixStorage<double>>;
+template <typename T>
+struct SparseProductTest : public testing::Test {};
+TYPED_TEST_SUITE(SparseProductTest, MatrixTypes);
+
+namespace {
+  using Dense = std::vector<std::vector<double>>;
+
+  VectorSpec spec(global_size_t size) {
+    return VectorSpec(Comm::world(), size, size);
+  }
+
+  /** A matrix with an irregular sparsity pattern. */
+  LocalCooMatrix<double> pattern_matrix(size_t rows, size_t cols, int seed)
+  {
+    LocalCooMatrix<double> coo;
+    for (size_t i = 0; i < rows; ++i) {
+      for (size_t j = 0; j < cols; ++j) {
+        if ((3*i + 5*j + seed) % 4 == 0)
+          coo.add(i, j, 1.0 + (i + 2*j + seed) % 7);
+      }
+    }
+    return coo;
+  }
+
+  template <typename M>
+  std::shared_ptr<M> make_matrix(size_t rows, size_t cols, int seed)
+  {
+    auto mat = std::make_shared<M>(spec(rows), spec(cols));
+    mat->set_entries(pattern_matrix(rows, cols, seed));
+    return mat;
+  }
+
+  template <typename M>
+  Dense to_dense(M& mat)
+  {
+    Dense result(mat.row_spec().global_size(),
+                 std::vector<double>(mat.col_spec().global_size(), 0.0));
+
+    auto coo = mat.get_entries();
+    for (auto e : coo.entries()) {
+      result.at(e.row()).at(e.col()) += e.value();
+    }
+    return result;
+  }
+
+  Dense multiply(const Dense& a, const Dense& b)
+  {
+    Dense result(a.size(), std::vector<double>(b.at(0).size(), 0.0));
+    for (size_t i = 0; i < a.size(); ++i)
+      for (size_t k = 0; k < b.size(); ++k)
+        for (size_t j = 0; j < b[k].size(); ++j)
+          result[i][j] += a[i][k] * b[k][j];
+    return result;
+  }
+
+  Dense transpose(const Dense& a)
+  {
+    Dense result(a.at(0).size(), std::vector<double>(a.size(), 0.0));
+    for (size_t i = 0; i < a.size(); ++i)
+      for (size_t j = 0; j < a[i].size(); ++j)
+        result[j][i] = a[i][j];
+    return result;
+  }
+
+  /** Scales all values of the matrix, keeping the sparsity pattern. */
+  template <typename M>
+  void scale_values(M& mat, double factor)
+  {
+    auto coo = mat.get_entries();
+    auto scatter = mat.value_scatter(coo);
+    for (auto& value : coo.values()) {
+      value *= factor;
+    }
+    mat.update_values(coo, scatter);
+  }
+}
+
+TYPED_TEST(SparseProductTest, Transpose)
+{
+  using Matrix = TypeParam;
+
+  auto a = make_matrix<Matrix>(5, 7, 0);
+  SparseTranspose<Matrix> t(a);
+
+  EXPECT_EQ(t.result()->row_spec().global_size(), 7);
+  EXPECT_EQ(t.result()->col_spec().global_size(), 5);
+  EXPECT_EQ(to_dense(*t.result()), transpose(to_dense(*a)));
+
+  scale_values(*a, 2.0);
+  t.update();
+  EXPECT_EQ(to_dense(*t.result()), transpose(to_dense(*a)));
+}
+
+TYPED_TEST(SparseProductTest, Product)
+{
+  using Matrix = TypeParam;
+
+  auto a = make_matrix<Matrix>(5, 7, 0);
+  auto b = make_matrix<Matrix>(7, 4, 1);
+  SparseProduct<Matrix> c(a, b);
+
+  EXPECT_EQ(c.result()->row_spec().global_size(), 5);
+  EXPECT_EQ(c.result()->col_spec().global_size(), 4);
+  EXPECT_EQ(to_dense(*c.result()), multiply(to_dense(*a), to_dense(*b)));
+
+  scale_values(*a, 2.0);
+  scale_values(*b, -3.0);
+  c.update();
+  EXPECT_EQ(to_dense(*c.result()), multiply(to_dense(*a), to_dense(*b)));
+}
+
+TYPED_TEST(SparseProductTest, TripleProduct)
+{
+  using Matrix = TypeParam;
+
+  auto a = make_matrix<Matrix>(6, 6, 2);
+  auto p = make_matrix<Matrix>(6, 3, 3);
+  SparseTripleProduct<Matrix> c(a, p);
+
+  auto expected = [&]() {
+    auto dense_p = to_dense(*p);
+    return multiply(transpose(dense_p), multiply(to_dense(*a), dense_p));
+  };
+
+  EXPECT_EQ(c.result()->row_spec().global_size(), 3);
+  EXPECT_EQ(c.result()->col_spec().global_size(), 3);
+  EXPECT_EQ(to_dense(*c.result()), expected());
+
+  scale_values(*a, 0.5);
+  scale_values(*p, 3.0);
+  c.update();
+  EXPECT_EQ(to_dense(*c.result()), expected());
+}
+
+TEST(LocalCsrProduct, PatternChanged)
+{
+  LocalCsrMatrix<double> a(4, 4, pattern_matrix(4, 4, 0));
+  LocalCsrMatrix<double> b(4, 4, pattern_matrix(4, 4, 1));
+  LocalCsrProduct<double> c(a, b);
+
+  auto coo = pattern_matrix(4, 4, 0);
+  coo.add(0, 1, 1.0);
+  LocalCsrMatrix<double> other(4, 4, coo);
+  EXPECT_THROW(c.numeric(other, b), std::invalid_argument);
+}
@@ -0,0 +1,307 @@
+// Copyright 2021 Hannah Rittich
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+
+#include <allium/config.hpp>
+#include <allium/mesh/stencil.hpp>
+
+#include <gtest/gtest.h>
+
+using namespace allium;
+
+TEST(Stencil, Laplace2d)
+{
+  auto stencil = laplace_stencil<double, 2>(0.5);
+
+  ASSERT_EQ(stencil.size(), 5);
+  EXPECT_EQ(stencil.width(), 1);
+  EXPECT_TRUE(stencil.is_star());
+
+  double sum = 0;
+  for (const auto& e : stencil.entries()) {
+    sum += e.coefficient;
+  }
+  EXPECT_EQ(sum, 0.0);
+  EXPECT_EQ(stencil.entries()[0].coefficient, 16.0);
+}
+
+TEST(Stencil, Box)
+{
+  Stencil<double, 2> stencil = {
+    {{0, 0}, 1.0},
+    {{1, 1}, 2.0},
+    {{-2, 0}, 3.0}
+  };
+
+  EXPECT_EQ(stencil.width(), 2);
+  EXPECT_FALSE(stencil.is_star());
+}
+
+#ifdef ALLIUM_USE_PETSC
+
+#include <allium/mesh/petsc_fd_jacobian.hpp>
+#include <allium/mesh/petsc_stencil_operator.hpp>
+
+using Mesh = PetscMesh<PetscScalar, 2>;
+
+static std::shared_ptr<PetscMeshSpec<2>> stencil_test_spec(
+  Comm comm,
+  DMBoundaryType boundary,
+  DMDAStencilType stencil_type)
+{
+  return std::shared_ptr<PetscMeshSpec<2>>(
+           new PetscMeshSpec<2>(
+             comm,
+             {boundary, boundary},
+             stencil_type,
+             {7, 5}, // global size
+             {PETSC_DECIDE, PETSC_DECIDE}, // processors per dim
+             1, // ndof
+             1)); // stencil_width
+}
+
+static void fill_test_values(Mesh& mesh, int seed)
+{
+  auto lmesh = local_mesh(mesh);
+  for (auto p : mesh.mesh_spec()->local_range()) {
+    lmesh(p[0], p[1]) = (p[0] * 13 + p[1] * 7 + seed) % 11 - 5.0;
+  }
+}
+
+TEST(StencilOperator, ShiftedLaplaceGhosted)
+{
+  auto comm = Comm::world();
+  auto spec = stencil_test_spec(comm, DM_BOUNDARY_GHOSTED, DMDA_STENCIL_STAR);
+  auto global_end = spec->range().end_pos();
+
+  const double h = 0.25;
+  StencilOperator<Mesh> op(spec, laplace_stencil<PetscScalar, 2>(h), 3.0);
+
+  Mesh u(spec), f(spec), expected(spec);
+  fill_test_values(u, 1);
+  op.apply(f, u);
+
+  // reference: the same values, gathered into a single array
+  PetscLocalMesh<PetscScalar, 2> u_local(spec);
+  u_local.assign(u);
+  {
+    auto lu = local_mesh(u_local);
+    auto le = local_mesh(expected);
+    auto value = [&](int i, int j) -> PetscScalar {
+      if (i < 0 || j < 0 || i >= global_end[0] || j >= global_end[1])
+        return 0;
+      return lu(i, j);
+    };
+
+    for (auto p : spec->local_range()) {
+      int i = p[0], j = p[1];
+      le(i, j) = 3.0 * value(i, j)
+                 + (4 * value(i, j)
+                    - value(i-1, j) - value(i+1, j)
+                    - value(i, j-1) - value(i, j+1)) / (h*h);
+    }
+  }
+
+  expected.add_scaled(-1.0, f);
+  EXPECT_NEAR(expected.l2_norm(), 0.0, 1e-10);
+
+  op.shift(0.0);
+  EXPECT_EQ(op.shift(), 0.0);
+}
+
+TEST(StencilOperator, ShiftedOperator)
+{
+  auto comm = Comm::world();
+  auto spec = stencil_test_spec(comm, DM_BOUNDARY_GHOSTED, DMDA_STENCIL_STAR);
+
+  const double h = 0.25;
+  auto op = std::make_shared<StencilOperator<Mesh>>(
+              spec, laplace_stencil<PetscScalar, 2>(h), 1.0);
+  StencilOperator<Mesh> reference(spec, laplace_stencil<PetscScalar, 2>(h), 3.0);
+
+  // the additional shift is folded into the stencil sweep
+  auto shifted = shifted_operator(op, 2.0);
+
+  Mesh u(spec), f(spec), expected(spec);
+  fill_test_values(u, 1);
+  fill_test_values(f, 2);
+  expected.assign(f);
+  expected *= 2.0;
+
+  Mesh tmp(spec);
+  reference.apply(tmp, u);
+  expected.add_scaled(0.5, tmp);
+
+  shifted->apply_add(f, 0.5, u, 2.0);
+
+  expected.add_scaled(-1.0, f);
+  EXPECT_NEAR(expected.l2_norm(), 0.0, 1e-10);
+}
+
+TEST(StencilOperator, VariableCoefficientsPeriodic)
+{
+  auto comm = Comm::world();
+  auto spec = stencil_test_spec(comm, DM_BOUNDARY_PERIODIC, DMDA_STENCIL_BOX);
+  auto global_end = spec->range().end_pos();
+
+  Stencil<PetscScalar, 2> stencil = {
+    {{0, 0}, 1.0},
+    {{1, 1}, 2.0}
+  };
+
+  StencilOperator<Mesh> op(spec, stencil);
+
+  auto coefficients = std::make_shared<Mesh>(spec);
+  fill_test_values(*coefficients, 3);
+  op.coefficient_values(1, coefficients);
+
+  Mesh u(spec), f(spec), expected(spec);
+  fill_test_values(u, 1);
+  op.apply(f, u);
+
+  {
+    auto le = local_mesh(expected);
+    auto lc = local_mesh(*coefficients);
+    for (auto p : spec->local_range()) {
+      int i = p[0], j = p[1];
+      int i1 = (i + 1) % global_end[0];
+      int j1 = (j + 1) % global_end[1];
+      auto value = [](int x, int y) -> PetscScalar {
+        return (x * 13 + y * 7 + 1) % 11 - 5.0;
+      };
+      le(i, j) = value(i, j) + 2.0 * lc(i, j) * value(i1, j1);
+    }
+  }
+
+  expected.add_scaled(-1.0, f);
+  EXPECT_NEAR(expected.l2_norm(), 0.0, 1e-10);
+}
+
+TEST(StencilOperator, Assemble)
+{
+  auto comm = Comm::world();
+
+  for (auto boundary : { DM_BOUNDARY_GHOSTED, DM_BOUNDARY_PERIODIC }) {
+    auto spec = stencil_test_spec(comm, boundary, DMDA_STENCIL_BOX);
+
+    Stencil<PetscScalar, 2> stencil = laplace_stencil<PetscScalar, 2>(0.5);
+    stencil.add({1, -1}, 0.5);
+    StencilOperator<Mesh> op(spec, stencil, 2.0);
+
+    auto coefficients = std::make_shared<Mesh>(spec);
+    fill_test_values(*coefficients, 3);
+    op.coefficient_values(5, coefficients);
+
+    auto mat = op.assemble();
+
+    // the 5-point stencil, the extra diagonal and the shift on the center
+    auto entries = mat->get_entries();
+    size_t points = spec->local_range().shape().prod();
+    if (boundary == DM_BOUNDARY_PERIODIC) {
+      EXPECT_EQ(entries.entry_count(), 6 * points);
+    } else {
+      EXPECT_LT(entries.entry_count(), 6 * points);
+    }
+
+    Mesh u(spec), f(spec), g(spec);
+    fill_test_values(u, 1);
+    op.apply(f, u);
+    mat->apply(g, u);
+
+    g.add_scaled(-1.0, f);
+    EXPECT_NEAR(g.l2_norm(), 0.0, 1e-10);
+  }
+}
+
+TEST(PetscFdJacobian, Fisher)
+{
+  // F(u) = -Δu + u^2, hence J(u) v = -Δv + 2 u v
+  auto comm = Comm::world();
+  auto spec = stencil_test_spec(comm, DM_BOUNDARY_GHOSTED, DMDA_STENCIL_STAR);
+
+  auto op = std::make_shared<StencilOperator<Mesh>>(
+              spec, laplace_stencil<PetscScalar, 2>(0.5));
+
+  PetscFdJacobian jacobian(spec, [op](Mesh& f, const Mesh& u) {
+    op->apply(f, u);
+    auto lf = local_slice(f);
+    auto lu = local_slice(u);
+    for (size_t i = 0; i < lu.size(); ++i) {
+      lf[i] += lu[i] * lu[i];
+    }
+  });
+  EXPECT_LE(jacobian.color_count(), 9);
+
+  Mesh u(spec), v(spec), w(spec), expected(spec);
+  fill_test_values(u, 1);
+  fill_test_values(v, 2);
+
+  jacobian.compute(u);
+  jacobian.matrix()->apply(w, v);
+
+  op->apply(expected, v);
+  {
+    auto le = local_slice(expected);
+    auto lu = local_slice(u);
+    auto lv = local_slice(v);
+    for (size_t i = 0; i < lu.size(); ++i) {
+      le[i] += 2.0 * lu[i] * lv[i];
+    }
+  }
+
+  expected.add_scaled(-1.0, w);
+  EXPECT_NEAR(expected.l2_norm(), 0.0, 1e-4);
+}
+
+TEST(PetscFdJacobian, AfterAssemble)
+{
+  // assembling an operator must not change the matrices of the mesh spec
+  auto comm = Comm::world();
+  auto spec = stencil_test_spec(comm, DM_BOUNDARY_GHOSTED, DMDA_STENCIL_STAR);
+
+  auto op = std::make_shared<StencilOperator<Mesh>>(
+              spec, laplace_stencil<PetscScalar, 2>(0.5));
+  auto mat = op->assemble();
+
+  PetscFdJacobian jacobian(spec, [op](Mesh& f, const Mesh& u) {
+    op->apply(f, u);
+  });
+
+  Mesh u(spec), v(spec), w(spec), expected(spec);
+  fill_test_values(u, 1);
+  fill_test_values(v, 2);
+
+  jacobian.compute(u);
+  jacobian.matrix()->apply(w, v);
+  mat->apply(expected, v);
+
+  expected.add_scaled(-1.0, w);
+  EXPECT_NEAR(expected.l2_norm(), 0.0, 1e-4);
+}
+
+TEST(StencilOperator, InvalidStencil)
+{
+  auto comm = Comm::world();
+  auto star = stencil_test_spec(comm, DM_BOUNDARY_GHOSTED, DMDA_STENCIL_STAR);
+
+  Stencil<PetscScalar, 2> diagonal = { {{1, 1}, 1.0} };
+  EXPECT_THROW((StencilOperator<Mesh>(star, diagonal)), std::logic_error);
+
+  Stencil<PetscScalar, 2> wide = { {{2, 0}, 1.0} };
+  EXPECT_THROW((StencilOperator<Mesh>(star, wide)), std::logic_error);
+
+  StencilOperator<Mesh> op(star, laplace_stencil<PetscScalar, 2>(1.0));
+  EXPECT_THROW(op.coefficient_values(5, nullptr), std::out_of_range);
+}
+
+#endif
@@ -14,6 +14,7 @@
 
 #include <allium/config.hpp>
 #include <allium/la/vector_storage.hpp>
+#include <allium/la/distributed_vector.hpp>
 #include <allium/la/petsc_vector.hpp>
 #include <allium/la/eigen_vector.hpp>
 #include <allium/la/cuda_vector.hpp>
@@ -27,6 +28,8 @@ typedef
   testing::Types<
     EigenVectorStorage<double>
     , EigenVectorStorage<std::complex<double>>
+    , DistributedVectorStorage<double>
+    , DistributedVectorStorage<std::complex<double>>
     #ifdef ALLIUM_USE_PETSC
       , PetscVectorStorage<double>
       #ifdef ALLIUM_PETSC_HAS_COMPLEX